@@ -0,0 +1,322 @@
+// BitsyBenchmark.cpp: parser throughput, memory and allocation benchmarks on generated games.
+// Results are printed as JSON so they can be tracked across versions.
+#include "BitsyArenaGame.h"
+#include "BitsyBinaryFormat.h"
+#include "BitsyBlockScanner.h"
+#include "BitsyGameGenerator.h"
+#include "BitsyGameParser.h"
+#include "BitsyGameWriter.h"
+#include "BitsyInternedGame.h"
+#include "BitsyJsonString.h"
+#include "BitsyJsonWriter.h"
+#include "BitsySearchIndex.h"
+#include "BitsyBatchRunner.h"
+#include "BitsyDialogueScripts.h"
+#include "BitsySimulation.h"
+#include "BitsySynthesizer.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <sys/resource.h>
+
+// Global allocation accounting. Every block carries its size in a 16-byte header so live and
+// peak heap bytes can be tracked without sized delete.
+namespace {
+
+std::atomic<uint64_t> gAllocations(0);
+std::atomic<uint64_t> gLiveBytes(0);
+std::atomic<uint64_t> gPeakBytes(0);
+
+void* countedAlloc(size_t size) {
+    char* block = static_cast<char*>(std::malloc(size + 16));
+    if (!block) throw std::bad_alloc();
+    *reinterpret_cast<size_t*>(block) = size;
+    ++gAllocations;
+    uint64_t live = gLiveBytes += size;
+    uint64_t peak = gPeakBytes.load();
+    while (live > peak && !gPeakBytes.compare_exchange_weak(peak, live)) {
+    }
+    return block + 16;
+}
+
+void countedFree(void* ptr) {
+    if (!ptr) return;
+    char* block = static_cast<char*>(ptr) - 16;
+    gLiveBytes -= *reinterpret_cast<size_t*>(block);
+    std::free(block);
+}
+
+}  // namespace
+
+void* operator new(size_t size) { return countedAlloc(size); }
+void* operator new[](size_t size) { return countedAlloc(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return countedAlloc(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+void operator delete(void* ptr) noexcept { countedFree(ptr); }
+void operator delete[](void* ptr) noexcept { countedFree(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { countedFree(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { countedFree(ptr); }
+
+namespace {
+
+struct Measurement {
+    std::string name;
+    std::string game;
+    size_t bytes = 0;
+    size_t blocks = 0;
+    double seconds = 0;  // Median over the iterations
+    uint64_t allocations = 0;  // Per run
+    uint64_t peakHeapBytes = 0;  // Peak live heap during one run, above what was live before it
+};
+
+template <typename Fn>
+Measurement measure(const std::string& name, const std::string& game, size_t bytes, size_t blocks, int iterations,
+                    Fn run) {
+    Measurement m;
+    m.name = name;
+    m.game = game;
+    m.bytes = bytes;
+    m.blocks = blocks;
+
+    // One counted run for allocations and peak heap, then timed runs
+    uint64_t allocationsBefore = gAllocations.load();
+    uint64_t liveBefore = gLiveBytes.load();
+    gPeakBytes.store(liveBefore);
+    run();
+    m.allocations = gAllocations.load() - allocationsBefore;
+    m.peakHeapBytes = gPeakBytes.load() - liveBefore;
+
+    std::vector<double> times;
+    for (int i = 0; i < iterations; ++i) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        run();
+        times.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    m.seconds = times[times.size() / 2];
+    return m;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int scale = 1;
+    int iterations = 5;
+    std::string outputPath;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--scale" && i + 1 < argc) {
+            scale = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--iterations" && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--output" && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--scale N] [--iterations N] [--output results.json]" << std::endl;
+            return 2;
+        }
+    }
+
+    // Games of increasing size; scale multiplies every count
+    struct GameSpec {
+        const char* name;
+        BitsyGeneratorOptions options;
+    };
+    std::vector<GameSpec> specs;
+    for (int size : {10, 100, 1000}) {
+        GameSpec spec;
+        spec.name = size == 10 ? "small" : size == 100 ? "medium" : "large";
+        spec.options.rooms = size * scale;
+        spec.options.tiles = std::min(80, size * scale);
+        spec.options.sprites = std::min(80, size * scale);
+        spec.options.items = size * scale;
+        spec.options.dialogues = 4 * size * scale;
+        spec.options.variables = size * scale;
+        spec.options.tunes = size * scale / 4 + 1;
+        spec.options.blips = size * scale / 4 + 1;
+        specs.push_back(spec);
+    }
+
+    std::vector<Measurement> results;
+    for (const GameSpec& spec : specs) {
+        std::string text = BitsyGameGenerator::generate(spec.options);
+        std::string path = std::string("bench_") + spec.name + ".bitsy";
+        std::string binPath = std::string("bench_") + spec.name + ".bitsybin";
+        BitsyGameGenerator::writeFile(spec.options, path);
+        size_t blocks = BitsyBlockScanner::scan(text.data(), text.size()).size();
+        BitsyBinaryWriter::writeFile(BitsyGameParser::parseGameBuffer(text.data(), text.size()), binPath);
+
+        results.push_back(measure("parseGameData", spec.name, text.size(), blocks, iterations, [&]() {
+            BitsyGameData game = BitsyGameParser::parseGameData(path);
+        }));
+        results.push_back(measure("parseGameBuffer", spec.name, text.size(), blocks, iterations, [&]() {
+            BitsyGameData game = BitsyGameParser::parseGameBuffer(text.data(), text.size());
+        }));
+        results.push_back(measure("parseGameBufferParallel", spec.name, text.size(), blocks, iterations, [&]() {
+            BitsyGameData game;
+            std::string error;
+            BitsyGameParser::parseGameBufferParallel(text.data(), text.size(), game, error);
+        }));
+        BitsyArenaGame arenaGame;
+        results.push_back(measure("BitsyArenaGame::loadBuffer", spec.name, text.size(), blocks, iterations, [&]() {
+            std::string error;
+            arenaGame.loadBuffer(text.data(), text.size(), error);
+        }));
+        // Every load after the first finds all of its content already in the pool
+        BitsyInternPool pool;
+        BitsyInternedGame internedGame(pool);
+        results.push_back(measure("BitsyInternedGame::loadBuffer", spec.name, text.size(), blocks, iterations, [&]() {
+            std::string error;
+            internedGame.loadBuffer(text.data(), text.size(), error);
+        }));
+        results.push_back(measure("BitsyBinaryGame::open", spec.name, text.size(), blocks, iterations, [&]() {
+            BitsyBinaryGame binary;
+            binary.open(binPath);
+        }));
+        results.push_back(measure("BitsyBinaryGame::toGameData", spec.name, text.size(), blocks, iterations, [&]() {
+            BitsyBinaryGame binary;
+            binary.open(binPath);
+            BitsyGameData game = binary.toGameData();
+        }));
+        BitsyGameData parsed = BitsyGameParser::parseGameBuffer(text.data(), text.size());
+        results.push_back(measure("BitsyGameWriter::write", spec.name, text.size(), blocks, iterations, [&]() {
+            std::string written = BitsyGameWriter::write(parsed);
+        }));
+        std::string json;
+        results.push_back(measure("BitsyJsonWriter::append", spec.name, text.size(), blocks, iterations, [&]() {
+            json.clear();
+            BitsyJsonWriter::append(parsed, BitsyJsonOptions(), json);
+        }));
+        std::string image;
+        results.push_back(measure("BitsySearchIndexBuilder::serialize", spec.name, text.size(), blocks, iterations,
+                                  [&]() {
+                                      BitsySearchIndexBuilder builder;
+                                      builder.addGame(spec.name, parsed);
+                                      image = builder.serialize();
+                                  }));
+        // Prefix query on the first letter of the first term; "blocks" here counts hits
+        BitsySearchIndex index;
+        index.openBuffer(image.data(), image.size());
+        std::string start = index.termCount() ? index.termText(0).str().substr(0, 1) : "a";
+        size_t hits = index.prefix(start).size();
+        results.push_back(measure("BitsySearchIndex::prefix", spec.name, 0, hits, iterations, [&]() {
+            std::vector<BitsySearchHit> found = index.prefix(start);
+        }));
+        // Random walk through the world; "blocks" here counts steps
+        BitsyWorld world(parsed);
+        const size_t kSteps = 1000000;
+        std::vector<BitsyInput> inputs(kSteps);
+        uint32_t seed = 1;
+        for (BitsyInput& input : inputs) {
+            seed = seed * 1664525u + 1013904223u;
+            input = static_cast<BitsyInput>(kInputUp + (seed >> 30));
+        }
+        results.push_back(measure("BitsyWorld::step", spec.name, 0, kSteps, iterations, [&]() {
+            BitsyPlayState state = world.initialState();
+            for (BitsyInput input : inputs) world.step(state, input);
+        }));
+        results.push_back(measure("BitsyDialogueScripts::compile", spec.name, 0, parsed.dialogues.size(),
+                                  iterations, [&]() { BitsyDialogueScripts scripts(parsed); }));
+        BitsyDialogueScripts scripts(parsed);
+        results.push_back(measure("BitsyDialogueScripts::run", spec.name, 0, parsed.dialogues.size(), iterations,
+                                  [&]() {
+                                      BitsyPlayState state = world.initialState();
+                                      BitsyDialogueOutput output;
+                                      for (const Dialogue& dialogue : parsed.dialogues) {
+                                          output.clear();
+                                          scripts.run(dialogue.id, state, &output);
+                                      }
+                                  }));
+        results.push_back(measure("BitsySynthesizer::render", spec.name, 0, parsed.tunes.size() + parsed.blips.size(),
+                                  iterations, [&]() {
+                                      BitsyAudio audio;
+                                      for (const Tune& tune : parsed.tunes) {
+                                          BitsySynthesizer::renderTune(tune, BitsyAudioOptions(), audio);
+                                      }
+                                      for (const Blip& blip : parsed.blips) {
+                                          BitsySynthesizer::renderBlip(blip, BitsyAudioOptions(), audio);
+                                      }
+                                  }));
+        BitsyBatchRunner runner(world, 10000);
+        results.push_back(measure("BitsyBatchRunner::runRandom", spec.name, 0, 10000 * 100, iterations, [&]() {
+            runner.reset();
+            runner.runRandom(100, 1);
+        }));
+        std::remove(path.c_str());
+        std::remove(binPath.c_str());
+    }
+
+    // Allocations per block for each section type: games holding only that section,
+    // compared with a game that has none
+    struct SectionSpec {
+        const char* name;
+        int BitsyGeneratorOptions::*count;
+    };
+    const SectionSpec sections[] = {
+        {"room", &BitsyGeneratorOptions::rooms},       {"tile", &BitsyGeneratorOptions::tiles},
+        {"sprite", &BitsyGeneratorOptions::sprites},   {"item", &BitsyGeneratorOptions::items},
+        {"dialogue", &BitsyGeneratorOptions::dialogues}, {"variable", &BitsyGeneratorOptions::variables},
+        {"tune", &BitsyGeneratorOptions::tunes},       {"blip", &BitsyGeneratorOptions::blips}};
+    BitsyGeneratorOptions empty;
+    empty.rooms = empty.tiles = empty.sprites = empty.items = empty.dialogues = 0;
+    empty.variables = empty.tunes = empty.blips = 0;
+    std::string emptyText = BitsyGameGenerator::generate(empty);
+    uint64_t baseline = measure("", "", 0, 0, 1, [&]() {
+        BitsyGameData game = BitsyGameParser::parseGameBuffer(emptyText.data(), emptyText.size());
+    }).allocations;
+
+    const int kSectionBlocks = 1000;
+    std::ostringstream sectionJson;
+    for (size_t i = 0; i < sizeof(sections) / sizeof(sections[0]); ++i) {
+        BitsyGeneratorOptions options = empty;
+        options.*(sections[i].count) = kSectionBlocks;
+        std::string text = BitsyGameGenerator::generate(options);
+        Measurement m = measure(sections[i].name, "", text.size(), kSectionBlocks, iterations, [&]() {
+            BitsyGameData game = BitsyGameParser::parseGameBuffer(text.data(), text.size());
+        });
+        sectionJson << (i ? ",\n" : "\n") << "    {\"section\": \"" << sections[i].name << "\", \"blocks\": "
+                    << kSectionBlocks << ", \"bytes\": " << text.size() << ", \"allocations_per_block\": "
+                    << static_cast<double>(m.allocations - baseline) / kSectionBlocks
+                    << ", \"blocks_per_s\": " << kSectionBlocks / m.seconds << "}";
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    std::ostringstream json;
+    json << "{\n  \"format_version\": 1,\n  \"scale\": " << scale << ",\n  \"iterations\": " << iterations
+         << ",\n  \"results\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Measurement& m = results[i];
+        json << (i ? ",\n" : "\n") << "    {\"benchmark\": ";
+        bitsyAppendJsonString(json, m.name);
+        json << ", \"game\": ";
+        bitsyAppendJsonString(json, m.game);
+        json << ", \"bytes\": " << m.bytes << ", \"blocks\": " << m.blocks << ", \"seconds\": " << m.seconds
+             << ", \"mb_per_s\": " << m.bytes / m.seconds / 1e6 << ", \"blocks_per_s\": " << m.blocks / m.seconds
+             << ", \"allocations\": " << m.allocations << ", \"peak_heap_bytes\": " << m.peakHeapBytes << "}";
+    }
+    json << "\n  ],\n  \"sections\": [" << sectionJson.str() << "\n  ],\n  \"max_rss_kb\": " << usage.ru_maxrss
+         << "\n}\n";
+
+    if (outputPath.empty()) {
+        std::cout << json.str();
+    } else {
+        std::ofstream out(outputPath);
+        out << json.str();
+    }
+    return 0;
+}
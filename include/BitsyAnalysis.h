@@ -0,0 +1,93 @@
+#ifndef BITSYANALYSIS_H
+#define BITSYANALYSIS_H
+
+#include "BitsySimulation.h"
+#include <string>
+#include <vector>
+
+// An exit whose destination room does not exist
+struct BitsyBrokenExit {
+    int roomId;
+    int x, y;  // Start position of the exit
+    int destinationRoomId;
+};
+
+// An ending the avatar can never step onto
+struct BitsyUnreachableEnd {
+    int roomId;
+    int x, y;
+    int dialogueId;
+};
+
+// A reference to an entity that does not exist, e.g. a sprite naming a missing dialogue
+struct BitsyDanglingReference {
+    std::string kind;  // What is missing: "dialogue", "palette", "tune", "blip", "item", "tile" or "room"
+    std::string ownerType;  // Block holding the reference: "room", "sprite", "item" or "avatar"
+    std::string ownerId;
+    std::string id;  // The missing ID
+};
+
+struct BitsyAnalysisReport {
+    std::vector<int> unreachableRooms;  // Room IDs, in file order
+    std::vector<BitsyBrokenExit> brokenExits;
+    std::vector<BitsyUnreachableEnd> unreachableEndings;
+    std::vector<BitsyDanglingReference> danglingReferences;
+
+    bool clean() const;  // True if nothing was found
+    std::string toJson() const;
+};
+
+// Static analysis of how a game can be played through. Every room is split into walkable
+// regions (cells connected through floor, flood-filled over the 256-bit wall and sprite
+// bitmaps of BitsyWorld), and exits and endings become nodes of their own. Regions link to
+// the exits and endings they touch, and exits link to the regions around their destination,
+// giving one compact (CSR) graph that is searched once from the avatar's start.
+//
+// Building the analysis is linear in the size of the game; queries are constant time.
+class BitsyGameAnalysis {
+public:
+    explicit BitsyGameAnalysis(const BitsyGameData& game);
+
+    // Can the avatar, starting where the game puts it, enter the room / stand on the cell?
+    bool reachable(int roomId) const;
+    bool reachable(int roomId, int x, int y) const;
+
+    // Room IDs linked to roomId by chains of exits, walls ignored, roomId first
+    std::vector<int> linkedRooms(int roomId) const;
+
+    size_t regionCount() const { return regionCount_; }  // Walkable regions over all rooms
+    size_t nodeCount() const { return nodeRoom_.size(); }  // Regions, exits and endings
+    size_t edgeCount() const { return targets_.size(); }
+
+    const BitsyAnalysisReport& report() const { return report_; }
+
+private:
+    void buildNodes();
+    void buildEdges();
+    void search();
+    void appendEntry(int room, int x, int y, std::vector<int>& nodes) const;
+    void findDanglingReferences(const BitsyGameData& game);
+
+    BitsyWorld world_;
+    size_t regionCount_ = 0;
+
+    // Per room slot: node of every cell (y * 16 + x), -1 for walls and sprites. Floor cells
+    // map to their region; exit and ending cells to their own node.
+    std::vector<int> cellNodes_;
+    std::vector<int> nodeRoom_;  // Room slot of each node
+    std::vector<int> nodeCell_;  // Cell of an exit or ending node, -1 for regions
+
+    // Walkability graph in CSR form: node n links to targets_[offsets_[n] .. offsets_[n + 1])
+    std::vector<int> offsets_;
+    std::vector<int> targets_;
+    std::vector<uint64_t> reached_;  // Bit per node
+    std::vector<char> roomReached_;  // Per room slot
+
+    // Exit graph over room slots, also CSR
+    std::vector<int> roomOffsets_;
+    std::vector<int> roomTargets_;
+
+    BitsyAnalysisReport report_;
+};
+
+#endif // BITSYANALYSIS_H
@@ -0,0 +1,78 @@
+#ifndef BITSYARENA_H
+#define BITSYARENA_H
+
+#include "BitsyStringView.h"
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+// Read-only array living in an arena
+template <typename T>
+struct BitsySpan {
+    const T* data = nullptr;
+    size_t size = 0;
+
+    BitsySpan() {}
+    BitsySpan(const T* d, size_t n) : data(d), size(n) {}
+
+    bool empty() const { return size == 0; }
+    const T* begin() const { return data; }
+    const T* end() const { return data + size; }
+    const T& operator[](size_t i) const { return data[i]; }
+};
+
+// Monotonic bump allocator. Allocations are never freed individually; reset() forgets all of
+// them at once and keeps the memory, merged into a single block, for the next round. Only
+// trivially destructible objects may live here since no destructors are run.
+class BitsyArena {
+public:
+    explicit BitsyArena(size_t initialCapacity = 0);
+
+    void* allocate(size_t size, size_t alignment);  // Uninitialized, aligned storage
+
+    template <typename T>
+    T* allocateArray(size_t count) {  // Uninitialized storage for count objects
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    template <typename T>
+    BitsySpan<T> copyArray(const T* values, size_t count) {  // Copy values into the arena
+        if (count == 0) return BitsySpan<T>();
+        T* out = allocateArray<T>(count);
+        for (size_t i = 0; i < count; ++i) new (out + i) T(values[i]);
+        return BitsySpan<T>(out, count);
+    }
+
+    template <typename T>
+    BitsySpan<T> copyArray(const std::vector<T>& values) {
+        return copyArray(values.empty() ? nullptr : &values[0], values.size());
+    }
+
+    BitsyStringView copyString(BitsyStringView text);  // Copy a string (not NUL-terminated)
+
+    void reserve(size_t bytes);  // Make sure the next bytes of allocations fit in the current block
+    void reset();  // Drop all allocations but keep the memory for reuse
+    void release();  // Drop all allocations and free the memory
+
+    size_t bytesUsed() const;  // Bytes handed out since the last reset, including alignment padding
+    size_t bytesReserved() const;  // Bytes owned by the arena
+    size_t blockCount() const { return blocks_.size(); }
+
+private:
+    BitsyArena(const BitsyArena&);
+    BitsyArena& operator=(const BitsyArena&);
+
+    struct Block {
+        std::unique_ptr<char[]> memory;
+        size_t capacity;
+    };
+
+    void addBlock(size_t minimum);
+
+    std::vector<Block> blocks_;
+    size_t used_ = 0;  // Bytes used in the last block
+    size_t usedBefore_ = 0;  // Bytes used in all earlier blocks
+};
+
+#endif // BITSYARENA_H
@@ -0,0 +1,141 @@
+#ifndef BITSYARENAGAME_H
+#define BITSYARENAGAME_H
+
+#include "BitsyArena.h"
+#include "BitsyGameData.h"
+#include <string>
+
+// Arena-resident counterparts of the BitsyGameData entities: strings are views and lists are
+// spans into the owning BitsyArenaGame's arena, so none of them owns heap memory.
+struct ArenaPalette {
+    int id;
+    std::tuple<int, int, int> color1, color2, color3;
+    BitsyStringView name;
+};
+
+struct ArenaExit {
+    std::pair<int, int> startPosition;
+    int destinationRoomId;
+    std::pair<int, int> destinationPosition;
+    BitsyStringView effect;
+    int dialogueId;
+};
+
+struct ArenaRoom {
+    int id;
+    RoomGrid tiles;
+    BitsySpan<std::pair<int, std::pair<int, int>>> items;
+    BitsySpan<ArenaExit> exits;
+    BitsySpan<End> endings;
+    int paletteId;
+    int tuneId;
+    BitsyStringView name;
+};
+
+struct ArenaTile {
+    char id;
+    FrameSet frames;
+    BitsyStringView name;
+    bool wall;
+};
+
+struct ArenaSprite {
+    char id;
+    FrameSet frames;
+    BitsyStringView name;
+    int dialogId, blipId, roomId;
+    std::pair<int, int> position;
+};
+
+struct ArenaAvatar {
+    FrameSet frames;
+    int roomId = 0;
+    std::pair<int, int> position;
+    BitsySpan<int> inventory;
+};
+
+struct ArenaItem {
+    int id;
+    FrameSet frames;
+    BitsyStringView name;
+    int dialogId, blipId;
+};
+
+struct ArenaDialogue {
+    int id;
+    BitsyStringView text, name;
+};
+
+struct ArenaVariable {
+    BitsyStringView name, value;
+};
+
+struct ArenaTune {
+    int id;
+    BitsySpan<BitsyStringView> treblePatterns, bassPatterns;
+    BitsyStringView key, tempo, trebleInstrument, bassInstrument, arpeggio, name;
+};
+
+struct ArenaBlip {
+    int id;
+    BitsyStringView notes;
+    BitsySpan<int> env, beat;
+    BitsyStringView squareWave;
+    int repeat;
+    BitsyStringView name;
+};
+
+// A whole parsed game stored in one arena. Loading resets the arena and reuses its memory,
+// so repeatedly loading games of similar size settles into a single block, and dropping a
+// game is one deallocation. Entities are only valid until the next load or clear.
+class BitsyArenaGame {
+public:
+    BitsyArenaGame() {}
+
+    bool loadFile(const std::string& filePath, std::string& error);  // Returns false on errors
+    bool loadBuffer(const char* data, size_t size, std::string& error);
+    void clear();  // Forget the game, keeping the arena memory for the next load
+
+    size_t bytesUsed() const { return arena_.bytesUsed(); }  // Arena bytes holding this game
+    size_t bytesReserved() const { return arena_.bytesReserved(); }  // Arena bytes owned
+    const BitsyArena& arena() const { return arena_; }
+
+    const ArenaVariable* findVariable(BitsyStringView name) const;  // Binary search; nullptr if absent
+    BitsyGameData toGameData() const;  // Copy out into regular heap-backed structures
+
+    BitsyStringView title;
+    Settings settings;
+    ArenaAvatar avatar;
+    BitsySpan<ArenaPalette> palettes;
+    BitsySpan<ArenaRoom> rooms;
+    BitsySpan<ArenaTile> tiles;
+    BitsySpan<ArenaSprite> sprites;
+    BitsySpan<ArenaItem> items;
+    BitsySpan<ArenaDialogue> dialogues;
+    BitsySpan<ArenaVariable> variables;  // Sorted by name, one entry per name
+    BitsySpan<ArenaTune> tunes;
+    BitsySpan<ArenaBlip> blips;
+
+private:
+    BitsyArenaGame(const BitsyArenaGame&);
+    BitsyArenaGame& operator=(const BitsyArenaGame&);
+
+    friend class BitsyArenaBuilder;
+
+    BitsyArena arena_;
+
+    // Entities are collected here while parsing, then copied into the arena in one piece.
+    // The vectors keep their capacity, so later loads do not allocate for them.
+    std::vector<ArenaPalette> stagedPalettes_;
+    std::vector<ArenaRoom> stagedRooms_;
+    std::vector<ArenaTile> stagedTiles_;
+    std::vector<ArenaSprite> stagedSprites_;
+    std::vector<ArenaItem> stagedItems_;
+    std::vector<ArenaDialogue> stagedDialogues_;
+    std::vector<ArenaVariable> stagedVariables_;
+    std::vector<ArenaTune> stagedTunes_;
+    std::vector<ArenaBlip> stagedBlips_;
+    std::vector<BitsyStringView> stagedPatterns_;
+};
+
+#endif // BITSYARENAGAME_H
@@ -0,0 +1,92 @@
+#ifndef BITSYASYNCLOADER_H
+#define BITSYASYNCLOADER_H
+
+#include "BitsyGameData.h"
+#include "BitsyParallel.h"
+#include <functional>
+#include <memory>
+#include <string>
+
+enum BitsyLoadStatus {
+    kLoadPending,  // Queued or still parsing
+    kLoadOk,
+    kLoadOpenFailed,  // The file could not be opened or mapped
+    kLoadParseFailed,  // The parser threw; the game holds the blocks before the failing one
+    kLoadCancelled,  // cancel() stopped the load; the game holds the blocks parsed until then
+    kLoadCallbackFailed  // The completion callback threw; the message holds what it threw
+};
+
+// What went wrong, in fields instead of a printed message
+struct BitsyLoadError {
+    BitsyLoadStatus status = kLoadPending;
+    std::string message;  // Empty when the load succeeded
+    std::string filePath;  // Empty for buffer loads
+    size_t offset = 0;  // Byte offset where parsing stopped: the start of the failing block
+    size_t line = 0;  // 1-based line at offset; 0 if parsing never started
+
+    std::string toJson() const;
+};
+
+struct BitsyLoadProgress {
+    size_t bytes = 0;  // Bytes parsed so far, up to the end of the last finished block
+    size_t totalBytes = 0;  // Size of the input; 0 until a file has been opened
+    size_t blocks = 0;  // Top-level blocks parsed or skipped so far
+
+    double fraction() const { return totalBytes ? static_cast<double>(bytes) / totalBytes : 0; }
+};
+
+struct BitsyLoadResult {
+    BitsyGameData game;  // Parsed game; partial unless ok()
+    BitsyLoadError error;
+
+    bool ok() const { return error.status == kLoadOk; }
+};
+
+// Shared state of one background load. Copies of a handle refer to the same load, and the
+// load keeps running if every handle is dropped.
+class BitsyLoadHandle {
+public:
+    BitsyLoadHandle() {}
+
+    bool valid() const { return state_ != nullptr; }
+    BitsyLoadProgress progress() const;  // Safe to poll from any thread while the load runs
+    BitsyLoadStatus status() const;
+    bool done() const { return status() != kLoadPending; }
+
+    // Ask the load to stop after the block being parsed; a load still queued never starts.
+    // Does nothing once the load has finished.
+    void cancel();
+
+    void wait() const;
+    bool waitFor(double seconds) const;  // False if the load is still running after the timeout
+    BitsyLoadResult& result();  // Waits for the load to finish
+
+private:
+    friend class BitsyAsyncLoader;
+    struct State;
+    std::shared_ptr<State> state_;
+};
+
+// Loads games on an executor instead of the calling thread, so threads that must stay
+// responsive can start a load, poll its progress, cancel it and collect the result or a
+// structured error later. Parsing is the same sequential parse as parseGameData, checked for
+// cancellation between top-level blocks.
+class BitsyAsyncLoader {
+public:
+    // Runs on the executor thread once the load finishes, before waiters are woken; it may move
+    // the game out of the result. If it throws, waiters see kLoadCallbackFailed.
+    typedef std::function<void(BitsyLoadResult& result)> Callback;
+
+    static BitsyLoadHandle loadFile(const std::string& filePath, const Callback& callback = Callback(),
+                                    BitsyExecutor& executor = BitsyExecutor::shared());
+
+    // The buffer is not copied and must stay valid until the load is done
+    static BitsyLoadHandle loadBuffer(const char* data, size_t size, const Callback& callback = Callback(),
+                                      BitsyExecutor& executor = BitsyExecutor::shared());
+
+private:
+    static void run(BitsyLoadHandle::State& state, const char* data, size_t size);
+    static void finish(BitsyLoadHandle::State& state, const Callback& callback);
+};
+
+#endif // BITSYASYNCLOADER_H
@@ -0,0 +1,39 @@
+#ifndef BITSYBATCHLOADER_H
+#define BITSYBATCHLOADER_H
+
+#include "BitsyGameData.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+// Outcome of loading one file in a batch
+struct BitsyBatchResult {
+    std::string filePath;  // File as passed to load()
+    size_t index = 0;  // Position of the file in the input list
+    BitsyGameData game;  // Parsed game (partial if ok is false)
+    bool ok = false;  // True if the file was opened and parsed without errors
+    std::string error;  // Error message when ok is false
+    size_t bytes = 0;  // File size
+};
+
+// Loads many .bitsy files in parallel. Files are spread over a worker pool with work stealing,
+// largest first, and each result is handed to the callback on the calling thread as soon as it
+// completes, so the callback needs no locking.
+class BitsyBatchLoader {
+public:
+    typedef std::function<void(BitsyBatchResult& result)> Callback;
+
+    explicit BitsyBatchLoader(unsigned threadCount = 0);  // 0 uses one thread per core
+
+    // Load every file; returns the number of files that failed
+    size_t load(const std::vector<std::string>& filePaths, const Callback& callback) const;
+
+    // Collect the .bitsy files under a directory (recursively), sorted by path
+    static std::vector<std::string> listGameFiles(const std::string& directory);
+
+private:
+    unsigned threadCount_;
+    size_t maxPending_;  // Finished results allowed to wait for the callback before workers pause
+};
+
+#endif // BITSYBATCHLOADER_H
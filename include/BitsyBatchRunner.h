@@ -0,0 +1,73 @@
+#ifndef BITSYBATCHRUNNER_H
+#define BITSYBATCHRUNNER_H
+
+#include "BitsyDialogueScripts.h"
+#include "BitsySimulation.h"
+#include <map>
+#include <string>
+#include <vector>
+
+// What a batch of playthroughs reached
+struct BitsyCoverage {
+    size_t instances = 0;
+    uint64_t ticks = 0;  // Ticks run since the last reset
+    std::vector<size_t> roomInstances;  // Per room slot: instances that entered the room
+    std::vector<size_t> endingInstances;  // Per ending, rooms in slot order: instances that ended there
+    std::map<int, size_t> dialogueTriggers;  // Dialogue ID to number of times it was triggered
+    size_t endedInstances = 0;
+
+    size_t roomsReached() const;  // Rooms at least one instance entered
+    size_t endingsHit() const;  // Endings at least one instance reached
+    std::string toJson() const;
+};
+
+// Runs many independent playthroughs of one BitsyWorld. Per-instance state is kept in
+// structure-of-arrays form (one array per field, inventory and flags field-major), so a
+// tick touches contiguous memory. Instances are split into contiguous ranges; each worker
+// advances its range tick by tick, every instance in the range taking tick t before any of
+// them takes t + 1. Ranges run independently of each other.
+class BitsyBatchRunner {
+public:
+    BitsyBatchRunner(const BitsyWorld& world, size_t instances, unsigned threadCount = 0);
+
+    void reset();  // Put every instance back at the world's initial state and clear coverage
+
+    // Step every instance ticks times. inputs is tick-major: inputs[t * instanceCount() + i]
+    void run(const BitsyInput* inputs, size_t ticks);
+
+    // Step with pseudo-random moves; each instance has its own generator seeded from seed
+    void runRandom(size_t ticks, uint32_t seed);
+
+    // Run every triggered dialogue against the instance's variables and inventory, so scripts
+    // can change variables as the game plays. Resets the batch; pass nullptr to stop running them.
+    // The scripts must have been compiled from the same game as the world and outlive the runner.
+    void setScripts(const BitsyDialogueScripts* scripts);
+
+    size_t instanceCount() const { return instances_; }
+    BitsyPlayState state(size_t instance) const;  // Copy of one instance's state (steps is the tick count)
+    BitsyCoverage coverage() const;
+
+private:
+    template <typename InputFn>
+    void runTicks(size_t ticks, const InputFn& input);
+    BitsyStateRef ref(size_t instance);
+
+    const BitsyWorld& world_;
+    const BitsyDialogueScripts* scripts_ = nullptr;
+    size_t instances_;
+    unsigned threadCount_;
+    uint64_t ticks_ = 0;
+
+    // One entry per instance unless noted; "field-major" arrays hold field f of instance i
+    // at [f * instances_ + i]
+    std::vector<int> room_, x_, y_, endDialogueId_;
+    std::vector<uint8_t> ended_;
+    std::vector<int> inventory_;  // Field-major by item slot
+    std::vector<uint64_t> takenItems_;  // Field-major by word
+    std::vector<int> variables_;  // Field-major by variable (BitsyDialogueScripts::variableNames with scripts)
+    std::vector<uint64_t> visitedRooms_;  // Field-major by word of room-slot bits
+    std::vector<uint32_t> random_;  // Generator state for runRandom
+    std::map<int, size_t> dialogueTriggers_;
+};
+
+#endif // BITSYBATCHRUNNER_H
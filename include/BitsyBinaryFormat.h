@@ -0,0 +1,200 @@
+#ifndef BITSYBINARYFORMAT_H
+#define BITSYBINARYFORMAT_H
+
+#include "BitsyGameData.h"
+#include "BitsyMappedFile.h"
+#include <cstdint>
+#include <string>
+
+// Compiled binary form of BitsyGameData.
+//
+// The file is a header followed by 8-byte aligned sections of fixed-size records. Strings live
+// in one string table and are referenced by offset and length; variable-length lists (room
+// items, exits, tune patterns, envelope values...) are ranges into shared flat sections.
+// Values are stored in host byte order; the header's byteOrder field rejects foreign files.
+// Offsets and counts are 32-bit, so an image is always smaller than 4 GiB.
+
+enum BitsyBinSection {
+    kBinStrings,  // Raw string bytes
+    kBinGame,  // One BitsyBinGame record
+    kBinPalettes,
+    kBinRooms,
+    kBinRoomItems,
+    kBinExits,
+    kBinEnds,
+    kBinTiles,
+    kBinSprites,
+    kBinItems,
+    kBinDialogues,
+    kBinVariables,
+    kBinTunes,
+    kBinPatterns,  // BitsyBinString entries referenced by tunes
+    kBinBlips,
+    kBinInts,  // int32 values referenced by blips and the avatar inventory
+    kBinRoomIndex,  // BitsyBinRoomIndex entries sorted by room ID
+    kBinSectionCount
+};
+
+struct BitsyBinString {
+    uint32_t offset;  // Offset into the string table
+    uint32_t length;  // Length in bytes
+};
+
+struct BitsyBinRange {
+    uint32_t first;  // First record in the referenced section
+    uint32_t count;  // Number of records
+};
+
+struct BitsyBinSectionEntry {
+    uint32_t offset;  // Byte offset of the section from the start of the file
+    uint32_t count;  // Number of records (bytes for the string table)
+    uint32_t recordSize;  // sizeof the record type, checked on load
+    uint32_t reserved;
+};
+
+struct BitsyBinHeader {
+    char magic[8];  // "BITSYBIN"
+    uint32_t version;  // kVersion
+    uint32_t byteOrder;  // kByteOrder as written by the producing host
+    uint32_t sectionCount;  // kBinSectionCount
+    uint32_t reserved;
+    BitsyBinSectionEntry sections[kBinSectionCount];
+
+    static const uint32_t kVersion = 2;
+    static const uint32_t kByteOrder = 0x01020304;
+};
+
+struct BitsyBinGame {
+    uint64_t avatarFrames[FrameSet::kMaxFrames];
+    BitsyBinString title;
+    int32_t settings[5];  // verMaj, verMin, roomFormat, dlgCompat, txtMode
+    int32_t avatarRoomId, avatarX, avatarY;
+    uint32_t avatarFrameCount;
+    BitsyBinRange avatarInventory;  // Into kBinInts
+};
+
+struct BitsyBinPalette {
+    int32_t id;
+    int32_t colors[9];  // Three RGB triples
+    BitsyBinString name;
+};
+
+struct BitsyBinRoom {
+    int32_t id;
+    char tiles[RoomGrid::kCells];  // Same layout as RoomGrid::cells
+    int32_t paletteId, tuneId;
+    BitsyBinString name;
+    BitsyBinRange items, exits, endings;  // Into kBinRoomItems, kBinExits, kBinEnds
+};
+
+struct BitsyBinRoomIndex {
+    int32_t id;
+    uint32_t room;  // Record number in kBinRooms; the first room with the ID when IDs repeat
+};
+
+struct BitsyBinRoomItem {
+    int32_t id, x, y;
+};
+
+struct BitsyBinExit {
+    int32_t startX, startY, destinationRoomId, destinationX, destinationY, dialogueId;
+    BitsyBinString effect;
+};
+
+struct BitsyBinEnd {
+    int32_t dialogueId, x, y;
+};
+
+struct BitsyBinTile {
+    uint64_t frames[FrameSet::kMaxFrames];
+    uint32_t frameCount;
+    char id;
+    uint8_t wall;
+    uint16_t reserved;
+    BitsyBinString name;
+};
+
+struct BitsyBinSprite {
+    uint64_t frames[FrameSet::kMaxFrames];
+    uint32_t frameCount;
+    char id;
+    char reserved[3];
+    BitsyBinString name;
+    int32_t dialogId, blipId, roomId, x, y;
+    uint32_t padding;
+};
+
+struct BitsyBinItem {
+    uint64_t frames[FrameSet::kMaxFrames];
+    uint32_t frameCount;
+    int32_t id;
+    BitsyBinString name;
+    int32_t dialogId, blipId;
+};
+
+struct BitsyBinDialogue {
+    int32_t id;
+    BitsyBinString text, name;
+};
+
+struct BitsyBinVariable {
+    BitsyBinString name, value;
+};
+
+struct BitsyBinTune {
+    int32_t id;
+    BitsyBinRange treblePatterns, bassPatterns;  // Into kBinPatterns
+    BitsyBinString key, tempo, trebleInstrument, bassInstrument, arpeggio, name;
+};
+
+struct BitsyBinBlip {
+    int32_t id;
+    BitsyBinString notes;
+    BitsyBinRange env, beat;  // Into kBinInts
+    BitsyBinString squareWave;
+    int32_t repeat;
+    BitsyBinString name;
+};
+
+// Serializes BitsyGameData into the binary format
+class BitsyBinaryWriter {
+public:
+    static std::string serialize(const BitsyGameData& game);  // Whole file image; empty if it would reach 4 GiB
+    static bool writeFile(const BitsyGameData& game, const std::string& filePath);  // False on I/O errors or size
+};
+
+// Memory-mapped view of a compiled game. open() only validates the header and section
+// bounds; records are read straight out of the mapping.
+class BitsyBinaryGame {
+public:
+    bool open(const std::string& filePath);  // Map and validate a file
+    bool openBuffer(const char* data, size_t size);  // Validate a caller-owned buffer (8-byte aligned)
+
+    // Typed access to a section: pointer to its first record and the record count
+    template <typename T>
+    const T* records(BitsyBinSection section, size_t& count) const {
+        count = header_->sections[section].count;
+        return reinterpret_cast<const T*>(data_ + header_->sections[section].offset);
+    }
+    template <typename T>
+    const T* records(BitsyBinSection section) const {
+        return reinterpret_cast<const T*>(data_ + header_->sections[section].offset);
+    }
+    size_t count(BitsyBinSection section) const { return header_->sections[section].count; }
+
+    const BitsyBinGame& game() const { return *records<BitsyBinGame>(kBinGame); }
+    BitsyStringView string(BitsyBinString ref) const;  // Resolve a string reference
+    const BitsyBinRoom* findRoom(int id) const;  // Binary search of the room index; nullptr if absent
+
+    BitsyGameData toGameData() const;  // Materialize the full BitsyGameData (index included)
+
+private:
+    bool validate();
+
+    BitsyMappedFile file_;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    const BitsyBinHeader* header_ = nullptr;
+};
+
+#endif // BITSYBINARYFORMAT_H
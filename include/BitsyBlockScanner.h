@@ -0,0 +1,43 @@
+#ifndef BITSYBLOCKSCANNER_H
+#define BITSYBLOCKSCANNER_H
+
+#include "BitsyStringView.h"
+#include <vector>
+
+// Kind of top-level block, decided by the keyword on its first line
+enum BitsyBlockType {
+    kBlockOther,  // Comments and unknown keywords; ignored by the parser
+    kBlockSettings,  // "!" lines
+    kBlockPalette,
+    kBlockRoom,
+    kBlockTile,
+    kBlockAvatar,  // "SPR A"
+    kBlockSprite,
+    kBlockItem,
+    kBlockDialogue,
+    kBlockVariable,
+    kBlockTune,
+    kBlockBlip
+};
+
+// A run of non-empty lines plus the blank line that ends it
+struct BitsyBlock {
+    BitsyBlockType type = kBlockOther;
+    size_t offset = 0;  // Byte offset of the block's first line
+    size_t length = 0;  // Bytes up to and including the terminating blank line (or end of buffer)
+};
+
+class BitsyBlockScanner {
+public:
+    // Classify a line the way the parser's dispatch loop does
+    static BitsyBlockType classify(BitsyStringView line);
+
+    // Lower-case name of a block type ("room", "tile"...), used in reports
+    static const char* typeName(BitsyBlockType type);
+
+    // Split everything after the title line into blocks. A single pass with memchr over the
+    // buffer; nothing is parsed. Blocks of a well-formed game can be parsed independently.
+    static std::vector<BitsyBlock> scan(const char* data, size_t size);
+};
+
+#endif // BITSYBLOCKSCANNER_H
@@ -0,0 +1,130 @@
+#ifndef BITSYDIALOGUESCRIPTS_H
+#define BITSYDIALOGUESCRIPTS_H
+
+#include "BitsySimulation.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Instructions of the dialogue bytecode. Operands follow the opcode byte, little-endian.
+enum BitsyScriptOp : uint8_t {
+    kOpEnd,  // Stop
+    kOpText,  // u32 offset, u32 length: append a run of the string pool to the output
+    kOpTag,  // u8 BitsyTextTagType, u8 closing: record a formatting tag at the current output position
+    kOpPushInt,  // i32 value
+    kOpPushVariable,  // u16 variable index
+    kOpPushItem,  // u16 item slot: push the inventory count
+    kOpStoreVariable,  // u16 variable index: pop into the variable
+    kOpPop,  // Discard the top of the stack
+    kOpPrint,  // Pop and append as a decimal number
+    kOpAdd,  // Binary operators pop b, then a, and push a op b; comparisons push 1 or 0
+    kOpSubtract,
+    kOpMultiply,
+    kOpDivide,  // Division by zero gives 0
+    kOpEqual,
+    kOpNotEqual,
+    kOpLess,
+    kOpGreater,
+    kOpLessEqual,
+    kOpGreaterEqual,
+    kOpJump,  // u32 target offset
+    kOpJumpIfZero  // u32 target offset: pop, jump if zero
+};
+
+enum BitsyTextTagType : uint8_t {
+    kTagWavy,  // {wvy}
+    kTagShaky,  // {shk}
+    kTagRainbow,  // {rbw}
+    kTagColor1,  // {clr1}
+    kTagColor2,  // {clr2}
+    kTagColor3,  // {clr3}
+    kTagPage  // {pg}; {br} becomes a newline in the text instead
+};
+
+struct BitsyTextTag {
+    BitsyTextTagType type;
+    bool closing;  // Written as {/wvy}; Bitsy also accepts a second {wvy} to close
+    size_t offset;  // Position in BitsyDialogueOutput::text
+};
+
+// What running a dialogue printed
+struct BitsyDialogueOutput {
+    std::string text;
+    std::vector<BitsyTextTag> tags;
+
+    void clear() {
+        text.clear();
+        tags.clear();
+    }
+};
+
+// Where a dialogue reads and writes game state. Strided like BitsyStateRef, so it can point
+// into a BitsyPlayState or into the structure-of-arrays storage of BitsyBatchRunner.
+struct BitsyScriptContext {
+    int* variables;  // Value of variable v (BitsyDialogueScripts::variableNames) at variables[v * variableStride]
+    size_t variableStride;
+    const int* inventory;  // Count of item slot s at inventory[s * inventoryStride]
+    size_t inventoryStride;
+};
+
+// A problem found while compiling; the offending {...} block is compiled to nothing
+struct BitsyScriptError {
+    int dialogueId;
+    size_t column;  // Byte offset of the block in the dialogue text
+    std::string message;
+};
+
+// Every dialogue of a game compiled once into bytecode for a small stack machine. The
+// supported script is Bitsy's inline form:
+//
+//   text {wvy}effects{/wvy} {br} {pg}        text runs and formatting tags
+//   {a = a + 1}  {say a}  {print {item "tea"}}  variable writes and reads, item counts
+//   {- a > 2 ? big - a == 1 ? one - else ? small}    conditionals
+//
+// Expressions are integers (true is 1, false is 0) with + - * / == != < > <= >=. Items are
+// named by ID or name. Variables are addressed by index into a flat store, so running a
+// dialogue does no lookups by name and no allocation when no output is wanted.
+//
+// Inside a conditional, " - " followed later by "?" starts the next branch.
+class BitsyDialogueScripts {
+public:
+    explicit BitsyDialogueScripts(const BitsyGameData& game);
+
+    // Run a dialogue; output may be null when only its effects on variables matter.
+    // Returns false if the game has no dialogue with that ID.
+    bool run(int dialogueId, const BitsyScriptContext& context, BitsyDialogueOutput* output) const;
+
+    // Same, on a single play state; state.variables is grown to variableNames().size() and
+    // state.inventory to itemCount() first, new item slots holding zero
+    bool run(int dialogueId, BitsyPlayState& state, BitsyDialogueOutput* output) const;
+
+    // The game's variables sorted by name (matching BitsyWorld::variableNames), followed by
+    // names first used in dialogue, in order of use
+    const std::vector<std::string>& variableNames() const { return variableNames_; }
+    const std::vector<int>& initialVariables() const { return initialVariables_; }
+    int variableIndex(const std::string& name) const;  // -1 if absent
+    size_t itemCount() const { return itemCount_; }  // Inventory slots a context must provide
+
+    const std::vector<BitsyScriptError>& errors() const { return errors_; }
+    size_t bytecodeSize() const { return code_.size(); }
+    std::string disassemble(int dialogueId) const;  // One instruction per line, for debugging
+
+private:
+    friend class BitsyScriptCompiler;
+
+    struct Program {
+        int id;
+        uint32_t start;  // Offset of the first instruction in code_
+    };
+
+    std::vector<Program> programs_;
+    BitsyIdIndex programIndex_;
+    std::vector<uint8_t> code_;
+    std::string pool_;  // Text runs
+    std::vector<std::string> variableNames_;
+    std::vector<int> initialVariables_;
+    size_t itemCount_ = 0;  // Items in the compiled game
+    std::vector<BitsyScriptError> errors_;
+};
+
+#endif // BITSYDIALOGUESCRIPTS_H
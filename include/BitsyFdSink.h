@@ -0,0 +1,63 @@
+#ifndef BITSYFDSINK_H
+#define BITSYFDSINK_H
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <unistd.h>
+
+// Output sink that batches writes to a file descriptor through a fixed 64 KiB buffer.
+// Text longer than the buffer is written straight through. Errors are sticky: after the
+// first failed write everything else is dropped and finish() returns false.
+class BitsyFdSink {
+public:
+    explicit BitsyFdSink(int fd) : fd_(fd), used_(0), ok_(true) {}
+
+    void append(const char* text, size_t length) {
+        if (length > sizeof(buffer_) - used_) {
+            flush();
+            if (length > sizeof(buffer_)) {
+                writeAll(text, length);
+                return;
+            }
+        }
+        std::memcpy(buffer_ + used_, text, length);
+        used_ += length;
+    }
+    void put(char c) {
+        if (used_ == sizeof(buffer_)) flush();
+        buffer_[used_++] = c;
+    }
+    bool finish() {  // Write out what is buffered; false if any write failed
+        flush();
+        return ok_;
+    }
+
+private:
+    BitsyFdSink(const BitsyFdSink&);
+    BitsyFdSink& operator=(const BitsyFdSink&);
+
+    void flush() {
+        writeAll(buffer_, used_);
+        used_ = 0;
+    }
+    void writeAll(const char* data, size_t length) {
+        while (ok_ && length > 0) {
+            ssize_t written = ::write(fd_, data, length);
+            if (written < 0 && errno == EINTR) continue;
+            if (written <= 0) {
+                ok_ = false;
+                return;
+            }
+            data += written;
+            length -= written;
+        }
+    }
+
+    int fd_;
+    size_t used_;
+    bool ok_;
+    char buffer_[64 * 1024];
+};
+
+#endif // BITSYFDSINK_H
@@ -0,0 +1,56 @@
+#ifndef BITSYFRAME_H
+#define BITSYFRAME_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "BitsyStringView.h"
+
+// One 8x8 one-bit frame packed into a single word: bit (y * 8 + x) is the pixel at (x, y)
+struct PackedFrame {
+    uint64_t bits = 0;  // Row y occupies byte y, leftmost pixel in the lowest bit
+
+    PackedFrame() {}
+    explicit PackedFrame(uint64_t b) : bits(b) {}
+
+    bool pixel(int x, int y) const { return (bits >> (y * 8 + x)) & 1; }  // Pixel at (x, y)
+    void setPixel(int x, int y, bool on) {  // Set the pixel at (x, y)
+        uint64_t mask = uint64_t(1) << (y * 8 + x);
+        bits = on ? (bits | mask) : (bits & ~mask);
+    }
+    uint8_t row(int y) const { return static_cast<uint8_t>(bits >> (y * 8)); }  // Row y as a bitmask
+
+    PackedFrame flippedHorizontal() const;  // Mirror left to right
+    PackedFrame flippedVertical() const;  // Mirror top to bottom
+    PackedFrame transposed() const;  // Swap x and y
+    PackedFrame rotatedClockwise() const;  // Rotate 90 degrees clockwise
+    PackedFrame rotatedCounterClockwise() const;  // Rotate 90 degrees counter-clockwise
+
+    static PackedFrame fromRow(PackedFrame frame, int y, BitsyStringView text);  // Set row y from "01" text
+    std::vector<std::string> toText() const;  // Eight "0"/"1" rows
+};
+
+inline bool operator==(PackedFrame a, PackedFrame b) { return a.bits == b.bits; }
+inline bool operator!=(PackedFrame a, PackedFrame b) { return a.bits != b.bits; }
+
+// Animation frames of a tile, sprite, item or avatar (the format allows one or two)
+struct FrameSet {
+    static const int kMaxFrames = 2;
+
+    PackedFrame frames[kMaxFrames];  // Frame data; only the first count entries are meaningful
+    uint8_t count = 0;  // Number of frames
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const PackedFrame& operator[](size_t i) const { return frames[i]; }
+    PackedFrame& operator[](size_t i) { return frames[i]; }
+    void push_back(PackedFrame frame) { if (count < kMaxFrames) frames[count++] = frame; }
+    bool pixel(int frame, int x, int y) const { return frames[frame].pixel(x, y); }  // Pixel of a frame
+
+    std::vector<std::string> toText() const;  // Eight rows per frame, as they appear in the file
+};
+
+bool operator==(const FrameSet& a, const FrameSet& b);
+inline bool operator!=(const FrameSet& a, const FrameSet& b) { return !(a == b); }
+
+#endif // BITSYFRAME_H
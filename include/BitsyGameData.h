@@ -6,6 +6,9 @@
 #include <map>
 #include <tuple>
 #include <utility>
+#include <cstring>
+#include "BitsyStringView.h"
+#include "BitsyFrame.h"
 
 // Data structures used by BitsyGame
 struct Palette {
@@ -14,45 +17,64 @@ struct Palette {
     std::string name;  // Name of the palette
 };
 
+// 16x16 grid of tile IDs stored row-major in one contiguous block
+struct RoomGrid {
+    static const int kSize = 16;  // Rooms are always 16 tiles wide and high
+    static const int kCells = kSize * kSize;
+
+    char cells[kCells];  // Tile ID of cell (x, y) lives at cells[y * kSize + x]
+
+    RoomGrid() { std::memset(cells, '0', sizeof(cells)); }  // '0' is the empty tile
+
+    char at(int x, int y) const { return cells[y * kSize + x]; }  // Tile ID at (x, y)
+    void set(int x, int y, char id) { cells[y * kSize + x] = id; }  // Set the tile ID at (x, y)
+
+    char* operator[](int y) { return cells + y * kSize; }  // Row access, so grid[y][x] works
+    const char* operator[](int y) const { return cells + y * kSize; }
+
+    BitsyStringView row(int y) const { return BitsyStringView(cells + y * kSize, kSize); }  // One row
+    BitsyStringView view() const { return BitsyStringView(cells, kCells); }  // Whole grid
+};
+
 struct Room {
     int id;  // Unique ID for the room
-    std::vector<std::vector<char>> tiles;  // 16x16 grid of tile IDs
+    RoomGrid tiles;  // 16x16 grid of tile IDs
     std::vector<std::pair<int, std::pair<int, int>>> items;  // List of items with positions
     std::vector<struct Exit> exits;  // Exits in the room
     std::vector<struct End> endings;  // Endings in the room
-    int paletteId;  // Palette ID used in the room
-    int tuneId;  // Tune ID
+    int paletteId = 0;  // Palette ID used in the room
+    int tuneId = 0;  // Tune ID
     std::string name;  // Room name
 };
 
 struct Tile {
     char id;  // Tile ID
-    std::vector<std::string> frames;  // One or two frames of the tile
+    FrameSet frames;  // One or two frames of the tile
     std::string name;  // Tile name
     bool wall = false;  // Wall property
 };
 
 struct Sprite {
     char id;  // Sprite ID
-    std::vector<std::string> frames;  // One or two frames
+    FrameSet frames;  // One or two frames
     std::string name;  // Sprite name
     int dialogId = -1;  // Dialogue ID (optional)
     int blipId = -1;  // Blip sound ID (optional)
-    int roomId;  // Room ID
+    int roomId = 0;  // Room ID
     std::pair<int, int> position;  // Position (x, y)
 };
 
 struct Avatar {
     char id = 'A';  // Avatar always has ID 'A'
-    std::vector<std::string> frames;  // Frames for the avatar
-    int roomId;  // Room ID where avatar starts
+    FrameSet frames;  // Frames for the avatar
+    int roomId = 0;  // Room ID where avatar starts
     std::pair<int, int> position;  // Position (x, y)
     std::vector<int> inventory;  // Avatar's inventory (item IDs)
 };
 
 struct Item {
     int id;  // Item ID
-    std::vector<std::string> frames;  // One or two frames
+    FrameSet frames;  // One or two frames
     std::string name;  // Item name
     int dialogId = -1;  // Dialogue ID (optional)
     int blipId = -1;  // Blip sound ID (optional)
@@ -60,14 +82,14 @@ struct Item {
 
 struct Exit {
     std::pair<int, int> startPosition;  // Starting position of exit
-    int destinationRoomId;  // Destination room ID
+    int destinationRoomId = 0;  // Destination room ID
     std::pair<int, int> destinationPosition;  // Destination position (x, y)
     std::string effect;  // Exit effect (optional)
-    int dialogueId;  // Dialogue ID (optional)
+    int dialogueId = -1;  // Dialogue ID (optional)
 };
 
 struct End {
-    int dialogueId;  // Dialogue ID
+    int dialogueId = -1;  // Dialogue ID
     std::pair<int, int> position;  // Position of ending (x, y)
 };
 
@@ -105,13 +127,81 @@ struct Blip {
 };
 
 struct Settings {
-        int verMaj, verMin, roomFormat, dlgCompat, txtMode;  // Game settings
+        int verMaj = 0, verMin = 0, roomFormat = 0, dlgCompat = 0, txtMode = 0;  // Game settings
     };
 
+// Flat ID-to-slot map: a dense table for the small IDs Bitsy uses, sorted pairs for outliers
+class BitsyIdIndex {
+public:
+    static const int kDenseLimit = 1 << 16;  // IDs below this go in the dense table
+
+    template <typename T>
+    void build(const std::vector<T>& entries) {  // Index entries by their id field; first duplicate wins
+        dense_.clear();
+        sparse_.clear();
+        for (size_t slot = 0; slot < entries.size(); ++slot) {
+            insert(entries[slot].id, static_cast<int>(slot));
+        }
+        finish();
+    }
+
+    int slot(int id) const {  // Slot of the entry with this ID, or -1
+        if (id >= 0 && id < static_cast<int>(dense_.size())) return dense_[id];
+        return sparseSlot(id);
+    }
+
+    size_t memoryUsage() const;  // Heap bytes held by the tables
+
+private:
+    void insert(int id, int slot);
+    void finish();
+    int sparseSlot(int id) const;
+
+    std::vector<int> dense_;  // dense_[id] is a slot or -1
+    std::vector<std::pair<int, int>> sparse_;  // Sorted (id, slot) pairs for negative or huge IDs
+};
+
+// Estimated bytes held by a BitsyGameData, per collection. Each figure covers the vector's
+// reserved capacity plus heap memory owned by its elements (strings past the small-string
+// buffer, nested vectors); map nodes are estimated with a fixed per-node overhead.
+struct BitsyMemoryFootprint {
+    size_t object = 0;  // sizeof(BitsyGameData), including the inline tile and sprite slot tables
+    size_t title = 0;
+    size_t palettes = 0;
+    size_t rooms = 0;
+    size_t tiles = 0;
+    size_t sprites = 0;
+    size_t avatar = 0;  // Avatar inventory
+    size_t items = 0;
+    size_t dialogues = 0;
+    size_t variables = 0;
+    size_t tunes = 0;
+    size_t blips = 0;
+    size_t index = 0;  // ID lookup tables
+
+    size_t total() const;
+    std::string toJson() const;  // JSON object with every field and the total
+};
+
 // BitsyGameData
 class BitsyGameData {
 public:
+    BitsyGameData();
     void printGameStats() const;  // Print game statistics
+    BitsyMemoryFootprint memoryFootprint() const;  // Bytes held, per collection
+
+    // O(1) lookups by ID. The parser builds the index after loading; call buildIndex()
+    // again after adding or removing entries. Each returns nullptr if the ID is unknown.
+    void buildIndex();
+    const Palette* findPalette(int id) const;
+    const Room* findRoom(int id) const;
+    const Tile* findTile(char id) const;
+    const Sprite* findSprite(char id) const;  // The avatar is not a sprite; use avatar directly
+    const Item* findItem(int id) const;
+    const Dialogue* findDialogue(int id) const;
+    const Tune* findTune(int id) const;
+    const Blip* findBlip(int id) const;
+
     std::string title;  // Game title
     Settings settings;  // Game settings
     std::vector<Palette> palettes;  // Palettes in the game
@@ -124,6 +214,33 @@ public:
     std::map<std::string, Variable> variables;  // Game variables
     std::vector<Tune> tunes;  // Tunes in the game
     std::vector<Blip> blips;  // Blip sounds in the game
+
+private:
+    template <typename T>
+    static const T* entryAt(const std::vector<T>& entries, int slot) {
+        return slot >= 0 && slot < static_cast<int>(entries.size()) ? &entries[slot] : nullptr;
+    }
+
+    BitsyIdIndex paletteIndex_, roomIndex_, itemIndex_, dialogueIndex_, tuneIndex_, blipIndex_;
+    int tileSlots_[256];  // Slot per tile char, or -1
+    int spriteSlots_[256];  // Slot per sprite char, or -1
 };
 
+// Field-by-field equality, used to check that different load paths agree
+bool operator==(const Palette& a, const Palette& b);
+bool operator==(const RoomGrid& a, const RoomGrid& b);
+bool operator==(const Room& a, const Room& b);
+bool operator==(const Tile& a, const Tile& b);
+bool operator==(const Sprite& a, const Sprite& b);
+bool operator==(const Avatar& a, const Avatar& b);
+bool operator==(const Item& a, const Item& b);
+bool operator==(const Exit& a, const Exit& b);
+bool operator==(const End& a, const End& b);
+bool operator==(const Dialogue& a, const Dialogue& b);
+bool operator==(const Variable& a, const Variable& b);
+bool operator==(const Tune& a, const Tune& b);
+bool operator==(const Blip& a, const Blip& b);
+bool operator==(const Settings& a, const Settings& b);
+bool operator==(const BitsyGameData& a, const BitsyGameData& b);
+
 #endif // BITSYGAME_H
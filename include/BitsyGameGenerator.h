@@ -0,0 +1,31 @@
+#ifndef BITSYGAMEGENERATOR_H
+#define BITSYGAMEGENERATOR_H
+
+#include <cstdint>
+#include <string>
+
+// How many blocks of each kind a generated game contains
+struct BitsyGeneratorOptions {
+    int rooms = 16;
+    int tiles = 16;
+    int sprites = 8;
+    int items = 8;
+    int dialogues = 32;
+    int variables = 4;
+    int tunes = 4;
+    int blips = 4;
+    uint32_t seed = 1;  // Same options and seed always give the same text
+};
+
+// Writes synthetic games in the .bitsy text format, for benchmarks and stress tests.
+// Every reference (exit destinations, dialogue, palette and tune IDs) points at an
+// entity that exists in the generated game.
+class BitsyGameGenerator {
+public:
+    static std::string generate(const BitsyGeneratorOptions& options);
+    static bool writeFile(const BitsyGeneratorOptions& options, const std::string& filePath);  // False on I/O errors
+
+    static char tileId(int index);  // Character used for the index-th tile or sprite
+};
+
+#endif // BITSYGAMEGENERATOR_H
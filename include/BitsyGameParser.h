@@ -2,6 +2,9 @@
 #define BITSYGAMEPARSER_H
 
 #include "BitsyGameData.h"
+#include "BitsyGameVisitor.h"
+#include "BitsyLineCursor.h"
+#include "BitsyParseStats.h"
 #include <iostream>
 
 // Class responsible for parsing the Bitsy game data
@@ -10,19 +13,58 @@ public:
     // Static method to parse the game data and return a BitsyGameData object
     static BitsyGameData parseGameData(const std::string& filePath);
 
+    // Zero-copy variant: mmaps the file and tokenizes with views into the mapping.
+    // Produces the same BitsyGameData as parseGameData.
+    static BitsyGameData parseGameDataMapped(const std::string& filePath);
+
+    // Zero-copy variant over a caller-owned buffer, which only needs to outlive the call
+    static BitsyGameData parseGameBuffer(const char* data, size_t size);
+
+    // Variants that hand parse failures back in error instead of printing them.
+    // They return false on failure; gameData then holds whatever was parsed before the error.
+    // If stats is given it is reset and filled in with per-section timings and counters.
+    static bool parseGameDataMapped(const std::string& filePath, BitsyGameData& gameData, std::string& error,
+                                    BitsyParseStats* stats = nullptr);
+    static bool parseGameBuffer(const char* data, size_t size, BitsyGameData& gameData, std::string& error,
+                                BitsyParseStats* stats = nullptr);
+
+    // Parallel variants for very large games: the buffer is split into top-level blocks
+    // (BitsyBlockScanner), groups of blocks are parsed on threadCount threads (0 = one per core)
+    // and merged in file order. The result matches the sequential parse for well-formed games.
+    static BitsyGameData parseGameDataParallel(const std::string& filePath, unsigned threadCount = 0);
+    static bool parseGameBufferParallel(const char* data, size_t size, BitsyGameData& gameData, std::string& error,
+                                        unsigned threadCount = 0);
+
+    // Event-driven parsing: drives the visitor entity by entity instead of building a
+    // BitsyGameData. Blocks the visitor does not want are skipped unparsed, and a handler
+    // returning false stops the parse early. Only the current entity is held in memory, and
+    // files are mapped, so games larger than memory can be processed.
+    // Returns false on errors (not when the visitor stops). stats works as above.
+    static bool parse(const char* data, size_t size, BitsyGameVisitor& visitor, std::string& error,
+                      BitsyParseStats* stats = nullptr);
+    static bool parseFile(const std::string& filePath, BitsyGameVisitor& visitor, std::string& error,
+                          BitsyParseStats* stats = nullptr);
+
+    // Parse a range holding whole top-level blocks and no title line, such as one BitsyBlock
+    // found by BitsyBlockScanner::scan. Returns false on errors (not when the visitor stops).
+    static bool parseBlocks(const char* data, size_t size, BitsyGameVisitor& visitor, std::string& error);
+
 private:
-    static void parseGameTitle(BitsyGameData& game, const std::string& line);  // Parse the game title
-    static void parseSettings(BitsyGameData& game, const std::string& line);  // Parse game settings
-    static void parsePalette(BitsyGameData& game, std::istream& file, const std::string& firstLine);  // Parse a palette
-    static void parseRoom(BitsyGameData& game, std::istream& file, const std::string& firstLine);  // Parse a room
-    static void parseTile(BitsyGameData& game, std::istream& file, const std::string& firstLine);  // Parse a tile
-    static void parseAvatar(BitsyGameData& game, std::istream& file, const std::string& firstLine);  // Parse the avatar
-    static void parseSprite(BitsyGameData& game, std::istream& file, const std::string& firstLine);  // Parse a sprite
-    static void parseItem(BitsyGameData& game, std::istream& file, const std::string& firstLine);  // Parse an item
-    static void parseDialogue(BitsyGameData& game, std::istream& file, const std::string& firstLine);  // Parse a dialogue
-    static void parseVariable(BitsyGameData& game, std::istream& file, const std::string& firstLine);  // Parse a variable
-    static void parseTune(BitsyGameData& game, std::istream& file, const std::string& firstLine);  // Parse a tune
-    static void parseBlip(BitsyGameData& game, std::istream& file, const std::string& firstLine);  // Parse a blip sound
+    // Feed every line in the cursor to the block parsers below; returns false if the visitor stopped
+    static bool parseLines(BitsyLineCursor& cursor, BitsyGameVisitor& visitor, BitsyParseStats* stats = nullptr);
+
+    static bool parseSettings(BitsyGameVisitor& visitor, BitsyStringView line);  // Parse game settings
+    static Palette parsePalette(BitsyLineCursor& cursor, BitsyStringView firstLine);  // Parse a palette
+    static Room parseRoom(BitsyLineCursor& cursor, BitsyStringView firstLine);  // Parse a room
+    static Tile parseTile(BitsyLineCursor& cursor, BitsyStringView firstLine);  // Parse a tile
+    static Avatar parseAvatar(BitsyLineCursor& cursor, BitsyStringView firstLine);  // Parse the avatar
+    static Sprite parseSprite(BitsyLineCursor& cursor, BitsyStringView firstLine);  // Parse a sprite
+    static Item parseItem(BitsyLineCursor& cursor, BitsyStringView firstLine);  // Parse an item
+    static Dialogue parseDialogue(BitsyLineCursor& cursor, BitsyStringView firstLine);  // Parse a dialogue
+    static Variable parseVariable(BitsyLineCursor& cursor, BitsyStringView firstLine);  // Parse a variable
+    static Tune parseTune(BitsyLineCursor& cursor, BitsyStringView firstLine);  // Parse a tune
+    static Blip parseBlip(BitsyLineCursor& cursor, BitsyStringView firstLine);  // Parse a blip sound
+    static void skipBlock(BitsyLineCursor& cursor);  // Skip to the blank line ending a block
 };
 
 #endif // BITSYGAMEPARSER_H
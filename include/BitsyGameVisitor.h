@@ -0,0 +1,59 @@
+#ifndef BITSYGAMEVISITOR_H
+#define BITSYGAMEVISITOR_H
+
+#include "BitsyGameData.h"
+#include "BitsyBlockScanner.h"
+
+// Receives a game's entities one at a time while BitsyGameParser::parse reads them.
+// Every handler returns true to keep going or false to stop parsing right there.
+// Entities are passed by non-const reference; a handler may move from them.
+class BitsyGameVisitor {
+public:
+    virtual ~BitsyGameVisitor() {}
+
+    // Return false to skip blocks of this type without building their entities
+    virtual bool wants(BitsyBlockType type) const { (void)type; return true; }
+
+    virtual bool onTitle(BitsyStringView title) { (void)title; return true; }
+    virtual bool onSetting(BitsyStringView key, int value) { (void)key; (void)value; return true; }
+    virtual bool onPalette(Palette& palette) { (void)palette; return true; }
+    virtual bool onExit(const Room& room, const Exit& exit) { (void)room; (void)exit; return true; }  // Before onRoom
+    virtual bool onEnding(const Room& room, const End& end) { (void)room; (void)end; return true; }  // Before onRoom
+    virtual bool onRoom(Room& room) { (void)room; return true; }
+    virtual bool onTile(Tile& tile) { (void)tile; return true; }
+    virtual bool onAvatar(Avatar& avatar) { (void)avatar; return true; }
+    virtual bool onSprite(Sprite& sprite) { (void)sprite; return true; }
+    virtual bool onItem(Item& item) { (void)item; return true; }
+    virtual bool onDialogue(Dialogue& dialogue) { (void)dialogue; return true; }
+    virtual bool onVariable(Variable& variable) { (void)variable; return true; }
+    virtual bool onTune(Tune& tune) { (void)tune; return true; }
+    virtual bool onBlip(Blip& blip) { (void)blip; return true; }
+
+    // After every top-level block, wanted or skipped; offset is the number of bytes of the
+    // parsed range consumed so far. Lets long parses report progress or be cancelled.
+    virtual bool onBlockEnd(BitsyBlockType type, size_t offset) { (void)type; (void)offset; return true; }
+};
+
+// Visitor that collects everything into a BitsyGameData; this is what parseGameData uses
+class BitsyGameBuilder : public BitsyGameVisitor {
+public:
+    explicit BitsyGameBuilder(BitsyGameData& game) : game_(game) {}
+
+    bool onTitle(BitsyStringView title) override;
+    bool onSetting(BitsyStringView key, int value) override;
+    bool onPalette(Palette& palette) override;
+    bool onRoom(Room& room) override;
+    bool onTile(Tile& tile) override;
+    bool onAvatar(Avatar& avatar) override;
+    bool onSprite(Sprite& sprite) override;
+    bool onItem(Item& item) override;
+    bool onDialogue(Dialogue& dialogue) override;
+    bool onVariable(Variable& variable) override;
+    bool onTune(Tune& tune) override;
+    bool onBlip(Blip& blip) override;
+
+private:
+    BitsyGameData& game_;
+};
+
+#endif // BITSYGAMEVISITOR_H
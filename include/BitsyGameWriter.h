@@ -0,0 +1,27 @@
+#ifndef BITSYGAMEWRITER_H
+#define BITSYGAMEWRITER_H
+
+#include "BitsyGameData.h"
+#include <string>
+
+// Writes BitsyGameData in the text format BitsyGameParser reads. Numbers are formatted by
+// hand and text is copied straight into the output, so no iostreams are involved.
+//
+// Parsing the output gives back the same BitsyGameData, and writing that again gives the same
+// bytes. Entities with no frames get one empty frame, since the format cannot express none.
+class BitsyGameWriter {
+public:
+    static size_t measure(const BitsyGameData& game);  // Exact size of the text in bytes
+
+    // Whole text in a string allocated once at its exact size
+    static std::string write(const BitsyGameData& game);
+
+    // Write into a caller-owned buffer; returns the bytes written, or 0 if capacity < measure(game)
+    static size_t write(const BitsyGameData& game, char* buffer, size_t capacity);
+
+    // Stream to a file descriptor through a fixed 64 KiB buffer. Return false on I/O errors.
+    static bool writeFd(const BitsyGameData& game, int fd);
+    static bool writeFile(const BitsyGameData& game, const std::string& filePath);
+};
+
+#endif // BITSYGAMEWRITER_H
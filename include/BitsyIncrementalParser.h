@@ -0,0 +1,61 @@
+#ifndef BITSYINCREMENTALPARSER_H
+#define BITSYINCREMENTALPARSER_H
+
+#include "BitsyBlockScanner.h"
+#include "BitsyGameData.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Identifies one entity of a game: a block type plus its ID. Tiles and sprites use their
+// character ID; variables are keyed by name; settings and the avatar use ID 0.
+struct BitsyEntityKey {
+    BitsyBlockType type = kBlockOther;
+    int id = 0;
+    std::string name;  // Variables only
+};
+
+bool operator==(const BitsyEntityKey& a, const BitsyEntityKey& b);
+
+// What an incremental update changed
+struct BitsyReloadReport {
+    std::vector<BitsyEntityKey> added;
+    std::vector<BitsyEntityKey> removed;
+    std::vector<BitsyEntityKey> modified;  // Same key, different block text
+    bool titleChanged = false;
+    bool fullParse = false;  // True when every block had to be parsed (first update or a new game object)
+    size_t blocksParsed = 0;  // Blocks whose bytes changed and were parsed again
+    size_t blocksReused = 0;  // Blocks whose entities were carried over unparsed
+
+    bool empty() const { return added.empty() && removed.empty() && modified.empty() && !titleChanged; }
+};
+
+// Re-parses an edited game by block. Each update splits the new text into top-level blocks
+// (BitsyBlockScanner) and hashes them; blocks whose hash and length match a block of the
+// previous text keep their entities, and only the rest are parsed. The game passed to
+// update() is patched in place and ends up equal to a full parse of the new text.
+//
+// Pass the same BitsyGameData to every update; a different object triggers a full parse.
+// Entity vectors are rebuilt, so pointers into the game do not survive an update.
+class BitsyIncrementalParser {
+public:
+    // Bring game up to date with the text in data. On a parse error the game and the
+    // parser's state are left as they were and false is returned.
+    bool update(const char* data, size_t size, BitsyGameData& game, BitsyReloadReport& report, std::string& error);
+    bool updateFile(const std::string& filePath, BitsyGameData& game, BitsyReloadReport& report, std::string& error);
+
+    void reset();  // Forget the previous parse; the next update parses everything
+
+private:
+    struct BlockState {
+        BitsyBlockType type;
+        uint64_t hash;  // FNV-1a of the block bytes
+        size_t length;
+        std::vector<BitsyEntityKey> keys;  // Entities the block produced, grouped by type in file order
+    };
+
+    std::vector<BlockState> blocks_;  // Blocks of the previous text, in order
+    const BitsyGameData* game_ = nullptr;  // Game the blocks were applied to
+};
+
+#endif // BITSYINCREMENTALPARSER_H
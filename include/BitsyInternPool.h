@@ -0,0 +1,99 @@
+#ifndef BITSYINTERNPOOL_H
+#define BITSYINTERNPOOL_H
+
+#include "BitsyArena.h"
+#include "BitsyFrame.h"
+#include "BitsyGameData.h"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Reference to an immutable value held by a BitsyInternPool. A pool stores each distinct value
+// once, so two handles from the same pool are equal exactly when their values are, and
+// comparing them compares one pointer. A default-constructed handle refers to nothing.
+template <typename T>
+class BitsyHandle {
+public:
+    BitsyHandle() {}
+
+    const T& operator*() const { return *value_; }
+    const T* operator->() const { return value_; }
+    const T* get() const { return value_; }
+    bool valid() const { return value_ != nullptr; }
+
+    bool operator==(BitsyHandle other) const { return value_ == other.value_; }
+    bool operator!=(BitsyHandle other) const { return value_ != other.value_; }
+
+private:
+    friend class BitsyInternPool;
+    explicit BitsyHandle(const T* value) : value_(value) {}
+
+    const T* value_ = nullptr;
+};
+
+typedef BitsyHandle<BitsyStringView> BitsyStringHandle;
+typedef BitsyHandle<FrameSet> BitsyFrameHandle;
+typedef BitsyHandle<RoomGrid> BitsyGridHandle;
+typedef BitsyHandle<BitsySpan<BitsyStringHandle>> BitsyStringListHandle;
+
+// Hash-consing store for the values games repeat most: strings, frame sets, room grids and
+// lists of strings (tune patterns). Interning a value returns the handle of the stored copy,
+// adding it first if it is new. Values live in arenas and are never freed or moved while the
+// pool exists, so one pool can back any number of games.
+//
+// Safe to use from several threads at once: values are spread over shards by hash, each
+// with its own lock, arena and open-addressing table.
+class BitsyInternPool {
+public:
+    struct Stats {
+        size_t values = 0;  // Distinct values stored
+        size_t bytes = 0;  // Arena bytes holding them
+        size_t tableBytes = 0;  // Hash table memory
+        uint64_t requests = 0;  // Calls to intern
+        uint64_t hits = 0;  // Calls that found the value already stored
+    };
+
+    BitsyInternPool() {}
+
+    BitsyStringHandle intern(BitsyStringView text);
+    BitsyStringHandle intern(const std::string& text) { return intern(BitsyStringView(text)); }
+    BitsyStringHandle intern(const char* text) { return intern(BitsyStringView(text)); }
+    BitsyFrameHandle intern(const FrameSet& frames);
+    BitsyGridHandle intern(const RoomGrid& grid);
+    BitsyStringListHandle intern(const std::vector<BitsyStringHandle>& list);
+    BitsyStringListHandle intern(const std::vector<std::string>& list);  // Interns each string too
+
+    Stats stats() const;
+
+private:
+    BitsyInternPool(const BitsyInternPool&);
+    BitsyInternPool& operator=(const BitsyInternPool&);
+
+    static const int kShardBits = 4;
+
+    enum Kind : uint8_t { kKindString, kKindFrames, kKindGrid, kKindList };
+
+    struct Slot {
+        uint64_t hash;
+        const void* value;  // nullptr for an empty slot
+        Kind kind;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        BitsyArena arena;
+        std::vector<Slot> slots;  // Power-of-two size, at most 3/4 full
+        size_t values = 0;
+        uint64_t requests = 0;
+        uint64_t hits = 0;
+    };
+
+    // The stored value equal to the candidate, or a new copy made by create(arena)
+    template <typename T, typename Equal, typename Create>
+    const T* find(Kind kind, uint64_t hash, const Equal& equal, const Create& create);
+
+    Shard shards_[1 << kShardBits];
+};
+
+#endif // BITSYINTERNPOOL_H
@@ -0,0 +1,132 @@
+#ifndef BITSYINTERNEDGAME_H
+#define BITSYINTERNEDGAME_H
+
+#include "BitsyGameData.h"
+#include "BitsyInternPool.h"
+#include <string>
+#include <vector>
+
+// Counterparts of the BitsyGameData entities whose strings, frames, room grids and tune
+// patterns are handles into a shared BitsyInternPool. The same content in any game loaded
+// into that pool has the same handle, so it is stored once and compared by pointer.
+struct InternedPalette {
+    int id;
+    std::tuple<int, int, int> color1, color2, color3;
+    BitsyStringHandle name;
+};
+
+struct InternedExit {
+    std::pair<int, int> startPosition;
+    int destinationRoomId;
+    std::pair<int, int> destinationPosition;
+    BitsyStringHandle effect;
+    int dialogueId;
+};
+
+struct InternedRoom {
+    int id;
+    BitsyGridHandle tiles;
+    std::vector<std::pair<int, std::pair<int, int>>> items;
+    std::vector<InternedExit> exits;
+    std::vector<End> endings;
+    int paletteId;
+    int tuneId;
+    BitsyStringHandle name;
+};
+
+struct InternedTile {
+    char id;
+    BitsyFrameHandle frames;
+    BitsyStringHandle name;
+    bool wall;
+};
+
+struct InternedSprite {
+    char id;
+    BitsyFrameHandle frames;
+    BitsyStringHandle name;
+    int dialogId, blipId, roomId;
+    std::pair<int, int> position;
+};
+
+struct InternedAvatar {
+    BitsyFrameHandle frames;
+    int roomId = 0;
+    std::pair<int, int> position;
+    std::vector<int> inventory;
+};
+
+struct InternedItem {
+    int id;
+    BitsyFrameHandle frames;
+    BitsyStringHandle name;
+    int dialogId, blipId;
+};
+
+struct InternedDialogue {
+    int id;
+    BitsyStringHandle text, name;
+};
+
+struct InternedVariable {
+    BitsyStringHandle name, value;
+};
+
+struct InternedTune {
+    int id;
+    BitsyStringListHandle treblePatterns, bassPatterns;
+    BitsyStringHandle key, tempo, trebleInstrument, bassInstrument, arpeggio, name;
+};
+
+struct InternedBlip {
+    int id;
+    BitsyStringHandle notes;
+    std::vector<int> env, beat;
+    BitsyStringHandle squareWave;
+    int repeat;
+    BitsyStringHandle name;
+};
+
+// A parsed game whose repeated content lives in a BitsyInternPool shared with other games.
+// Each game keeps only its entity records and small ID lists; text, pixels and room layouts
+// are handles, so loading the same or similar games many times adds little beyond the first.
+// The pool must outlive every game using it. Loading different games into one pool from
+// several threads at once is safe.
+class BitsyInternedGame {
+public:
+    explicit BitsyInternedGame(BitsyInternPool& pool) : pool_(&pool) {}
+
+    bool loadFile(const std::string& filePath, std::string& error);  // Returns false on errors
+    bool loadBuffer(const char* data, size_t size, std::string& error);
+    void assign(const BitsyGameData& game);  // Intern an already parsed game
+    void clear();
+
+    BitsyInternPool& pool() const { return *pool_; }
+    const InternedVariable* findVariable(BitsyStringView name) const;  // Binary search; nullptr if absent
+    BitsyGameData toGameData() const;  // Copy out into regular heap-backed structures
+    size_t memoryUsage() const;  // Bytes held by this game itself, not counting the pool
+
+    BitsyStringHandle title;
+    Settings settings;
+    InternedAvatar avatar;
+    std::vector<InternedPalette> palettes;
+    std::vector<InternedRoom> rooms;
+    std::vector<InternedTile> tiles;
+    std::vector<InternedSprite> sprites;
+    std::vector<InternedItem> items;
+    std::vector<InternedDialogue> dialogues;
+    std::vector<InternedVariable> variables;  // Sorted by name, one entry per name
+    std::vector<InternedTune> tunes;
+    std::vector<InternedBlip> blips;
+
+private:
+    friend class BitsyInternBuilder;
+
+    BitsyInternPool* pool_;
+};
+
+// Entity-by-entity equality. Handles are compared by pointer, so both games must share a pool.
+bool operator==(const BitsyInternedGame& a, const BitsyInternedGame& b);
+inline bool operator!=(const BitsyInternedGame& a, const BitsyInternedGame& b) { return !(a == b); }
+
+#endif // BITSYINTERNEDGAME_H
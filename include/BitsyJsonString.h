@@ -0,0 +1,25 @@
+#ifndef BITSYJSONSTRING_H
+#define BITSYJSONSTRING_H
+
+#include <ostream>
+#include <string>
+
+// Writes text as a quoted JSON string for the toJson() reports. Quotes, backslashes and
+// control characters are escaped; other bytes, UTF-8 included, are copied as they are.
+inline void bitsyAppendJsonString(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (u < 0x20) {
+            static const char* kHex = "0123456789abcdef";
+            out << "\\u00" << kHex[u >> 4] << kHex[u & 15];
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+#endif // BITSYJSONSTRING_H
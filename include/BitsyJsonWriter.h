@@ -0,0 +1,50 @@
+#ifndef BITSYJSONWRITER_H
+#define BITSYJSONWRITER_H
+
+#include "BitsyGameData.h"
+#include <string>
+
+// Top-level collections, as bits of BitsyJsonOptions::sections
+enum BitsyJsonSection {
+    kJsonPalettes = 1 << 0,
+    kJsonRooms = 1 << 1,
+    kJsonTiles = 1 << 2,
+    kJsonSprites = 1 << 3,
+    kJsonAvatar = 1 << 4,
+    kJsonItems = 1 << 5,
+    kJsonDialogues = 1 << 6,
+    kJsonVariables = 1 << 7,
+    kJsonTunes = 1 << 8,
+    kJsonBlips = 1 << 9,
+    kJsonAllSections = (1 << 10) - 1
+};
+
+struct BitsyJsonOptions {
+    bool lines = false;  // NDJSON: one record per entity instead of one document
+    bool packedFrames = false;  // Frames as PackedFrame::bits integers instead of "01" row strings
+    unsigned sections = kJsonAllSections;  // Collections to write; the title and settings always are
+};
+
+// Writes BitsyGameData as JSON, straight into the output with no document tree in between.
+// Keys are snake_case; tile, sprite and item frames, room tiles and avatar frames come out as
+// arrays of 8 or 16 row strings ("00111100"), or with packedFrames as one integer per frame
+// (bit y * 8 + x is pixel (x, y); values reach 2^64, past what JavaScript numbers hold exactly).
+//
+// As a document the game is one object with a key per section. As NDJSON every line is an
+// object with a "type" field: "game" (title and settings) first, then "palette", "room",
+// "tile", "sprite", "avatar", "item", "dialogue", "variable", "tune" and "blip" records in
+// that order, each holding the entity's fields.
+class BitsyJsonWriter {
+public:
+    static std::string write(const BitsyGameData& game, const BitsyJsonOptions& options = BitsyJsonOptions());
+
+    // Append to a caller-owned string, so one buffer can be reused across games
+    static void append(const BitsyGameData& game, const BitsyJsonOptions& options, std::string& out);
+
+    // Stream to a file descriptor through a fixed 64 KiB buffer. Return false on I/O errors.
+    static bool writeFd(const BitsyGameData& game, int fd, const BitsyJsonOptions& options = BitsyJsonOptions());
+    static bool writeFile(const BitsyGameData& game, const std::string& filePath,
+                          const BitsyJsonOptions& options = BitsyJsonOptions());
+};
+
+#endif // BITSYJSONWRITER_H
@@ -0,0 +1,103 @@
+#ifndef BITSYLAZYGAME_H
+#define BITSYLAZYGAME_H
+
+#include "BitsyBlockScanner.h"
+#include "BitsyGameData.h"
+#include "BitsyMappedFile.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Index entry for one top-level block: its type, the ID from its first line and its bytes
+struct BitsyIndexedBlock {
+    BitsyBlockType type = kBlockOther;
+    int id = 0;  // Numeric ID, or the character code for tiles and sprites; 0 for other blocks
+    size_t offset = 0;  // Byte range in the game text
+    size_t length = 0;
+};
+
+// Game that parses its entities on first access. open() makes one pass over the text with
+// BitsyBlockScanner and reads only the ID on each block's first line; the title, settings and
+// avatar are parsed right away, everything else when a find* call first asks for it. Parsed
+// entities are cached, so pointers stay valid until the next open or close.
+//
+// Lookups follow BitsyGameData: the first entity with an ID wins, the last variable with a name
+// wins. The cache is filled from const accessors without locking, so one BitsyLazyGame must
+// not be used from several threads at once.
+class BitsyLazyGame {
+public:
+    BitsyLazyGame() {}
+
+    bool openFile(const std::string& filePath, std::string& error);  // Map the file and index it
+    bool openBuffer(const char* data, size_t size, std::string& error);  // Caller-owned; must outlive the game
+    void close();
+
+    // Each returns nullptr if the ID is unknown or its block fails to parse (see error())
+    const Palette* findPalette(int id) const;
+    const Room* findRoom(int id) const;
+    const Tile* findTile(char id) const;
+    const Sprite* findSprite(char id) const;
+    const Item* findItem(int id) const;
+    const Dialogue* findDialogue(int id) const;
+    const Variable* findVariable(const std::string& name) const;
+    const Tune* findTune(int id) const;
+    const Blip* findBlip(int id) const;
+
+    BitsyGameData toGameData() const;  // Full parse of the same text
+
+    const std::vector<BitsyIndexedBlock>& blocks() const { return blocks_; }  // In file order
+    size_t parsedBlockCount() const { return parsedBlocks_; }  // Blocks parsed so far, eager ones included
+    const std::string& error() const { return error_; }  // Last lazy parse failure
+
+    std::string title;  // Parsed eagerly
+    Settings settings;
+    Avatar avatar;
+
+private:
+    BitsyLazyGame(const BitsyLazyGame&);
+    BitsyLazyGame& operator=(const BitsyLazyGame&);
+
+    // Blocks of one entity type with their ID index and parse cache
+    template <typename T>
+    struct Section {
+        std::vector<BitsyIndexedBlock> entries;
+        BitsyIdIndex index;
+        std::vector<std::unique_ptr<T>> cache;  // Parallel to entries; null until parsed
+
+        void clear() {
+            entries.clear();
+            index = BitsyIdIndex();
+            cache.clear();
+        }
+        void finish() {
+            index.build(entries);
+            cache.resize(entries.size());
+        }
+    };
+
+    void clearIndex();  // Forget everything but the mapping
+    template <typename T>
+    const T* load(Section<T>& section, int id) const;
+    bool parseBlock(const BitsyIndexedBlock& block, BitsyGameData& part) const;
+
+    BitsyMappedFile file_;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+
+    std::vector<BitsyIndexedBlock> blocks_;
+    mutable Section<Palette> palettes_;
+    mutable Section<Room> rooms_;
+    mutable Section<Tile> tiles_;
+    mutable Section<Sprite> sprites_;
+    mutable Section<Item> items_;
+    mutable Section<Dialogue> dialogues_;
+    mutable Section<Tune> tunes_;
+    mutable Section<Blip> blips_;
+    std::map<std::string, size_t> variableBlocks_;  // Name to index into blocks_
+    mutable std::map<std::string, Variable> variables_;  // Parsed variables
+    mutable size_t parsedBlocks_ = 0;
+    mutable std::string error_;
+};
+
+#endif // BITSYLAZYGAME_H
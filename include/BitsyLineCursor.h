@@ -0,0 +1,112 @@
+#ifndef BITSYLINECURSOR_H
+#define BITSYLINECURSOR_H
+
+#include "BitsyStringView.h"
+#include <climits>
+
+// Walks a buffer line by line, handing out views instead of copies
+class BitsyLineCursor {
+public:
+    BitsyLineCursor(const char* begin, const char* end)
+        : begin_(begin), pos_(begin), end_(end), lastLine_(begin) {}
+
+    // Same contract as std::getline: fails at the end of the buffer and leaves an empty line
+    bool nextLine(BitsyStringView& line) {
+        if (pos_ >= end_) {
+            line = BitsyStringView();
+            return false;
+        }
+        lastLine_ = pos_;
+        const char* nl = static_cast<const char*>(std::memchr(pos_, '\n', end_ - pos_));
+        const char* lineEnd = nl ? nl : end_;
+        line = BitsyStringView(pos_, lineEnd - pos_);
+        pos_ = nl ? nl + 1 : end_;
+        return true;
+    }
+
+    // Step back to the start of the line returned by the last nextLine()
+    void unreadLine() { pos_ = lastLine_; }
+
+    bool atEnd() const { return pos_ >= end_; }
+    size_t offset() const { return pos_ - begin_; }
+    const char* position() const { return pos_; }  // Start of the next line
+
+private:
+    const char* begin_;
+    const char* pos_;
+    const char* end_;
+    const char* lastLine_;
+};
+
+inline bool bitsyIsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Parse a leading integer with the same contract as std::stoi (throws on missing digits or overflow)
+inline int bitsyParseInt(BitsyStringView text) {
+    const char* p = text.begin();
+    const char* end = text.end();
+    while (p < end && bitsyIsSpace(*p)) ++p;
+    bool negative = false;
+    if (p < end && (*p == '+' || *p == '-')) negative = (*p++ == '-');
+    if (p == end || *p < '0' || *p > '9') throw std::invalid_argument("stoi");
+    long long value = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+        value = value * 10 + (*p - '0');
+        if (value > static_cast<long long>(INT_MAX) + 1) throw std::out_of_range("stoi");
+    }
+    if (negative) value = -value;
+    if (value > INT_MAX || value < INT_MIN) throw std::out_of_range("stoi");
+    return static_cast<int>(value);
+}
+
+// Field scanner for a single line, mirroring the sscanf formats used by the parser:
+// literal() matches exact characters, space() matches any run of whitespace,
+// integer() behaves like %d and word() like %s. Each call returns false once a field fails.
+class BitsyFieldScanner {
+public:
+    explicit BitsyFieldScanner(BitsyStringView line) : pos_(line.begin()), end_(line.end()) {}
+
+    bool literal(BitsyStringView text) {
+        if (static_cast<size_t>(end_ - pos_) < text.size) return false;
+        if (std::memcmp(pos_, text.data, text.size) != 0) return false;
+        pos_ += text.size;
+        return true;
+    }
+
+    bool space() {
+        while (pos_ < end_ && bitsyIsSpace(*pos_)) ++pos_;
+        return true;
+    }
+
+    bool integer(int& out) {
+        space();
+        const char* p = pos_;
+        bool negative = false;
+        if (p < end_ && (*p == '+' || *p == '-')) negative = (*p++ == '-');
+        if (p == end_ || *p < '0' || *p > '9') return false;
+        long long value = 0;
+        for (; p < end_ && *p >= '0' && *p <= '9'; ++p) {
+            if (value <= INT_MAX) value = value * 10 + (*p - '0');
+        }
+        if (negative) value = -value;
+        out = value > INT_MAX ? INT_MAX : (value < INT_MIN ? INT_MIN : static_cast<int>(value));
+        pos_ = p;
+        return true;
+    }
+
+    bool word(BitsyStringView& out) {
+        space();
+        const char* start = pos_;
+        while (pos_ < end_ && !bitsyIsSpace(*pos_)) ++pos_;
+        if (pos_ == start) return false;
+        out = BitsyStringView(start, pos_ - start);
+        return true;
+    }
+
+private:
+    const char* pos_;
+    const char* end_;
+};
+
+#endif // BITSYLINECURSOR_H
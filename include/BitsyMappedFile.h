@@ -0,0 +1,32 @@
+#ifndef BITSYMAPPEDFILE_H
+#define BITSYMAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file (POSIX mmap). Files that cannot be mapped,
+// such as pipes, are read into an owned buffer instead.
+class BitsyMappedFile {
+public:
+    BitsyMappedFile() {}
+    ~BitsyMappedFile();
+
+    bool open(const std::string& filePath);  // Map the file; returns false if it cannot be opened or read
+    void close();  // Unmap the file
+
+    const char* data() const { return data_; }  // Start of the mapping (nullptr for empty files)
+    size_t size() const { return size_; }  // File size in bytes
+    bool isOpen() const { return open_; }
+
+private:
+    BitsyMappedFile(const BitsyMappedFile&);
+    BitsyMappedFile& operator=(const BitsyMappedFile&);
+
+    std::string buffer_;  // Contents of files that could not be mapped
+    const char* data_ = nullptr;
+    bool mapped_ = false;
+    size_t size_ = 0;
+    bool open_ = false;
+};
+
+#endif // BITSYMAPPEDFILE_H
@@ -0,0 +1,65 @@
+#ifndef BITSYPARALLEL_H
+#define BITSYPARALLEL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Per-worker task deques with stealing: a worker pops from the front of its own deque and,
+// once that is empty, steals from the back of the others, so uneven tasks balance out.
+class BitsyWorkStealingQueue {
+public:
+    explicit BitsyWorkStealingQueue(unsigned workerCount);
+
+    unsigned workerCount() const { return static_cast<unsigned>(queues_.size()); }
+    void push(unsigned worker, size_t task);  // Queue a task on a worker's own deque
+    bool pop(unsigned worker, size_t& task);  // Next task for a worker; false once every deque is empty
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+};
+
+// Long-lived pool of worker threads running submitted tasks in submission order. Unlike
+// bitsyParallelFor, which starts threads per call, an executor is meant to be shared by
+// callers that queue work and return at once. The destructor runs every queued task first.
+class BitsyExecutor {
+public:
+    explicit BitsyExecutor(unsigned threadCount = 0);  // 0 uses one thread per core
+    ~BitsyExecutor();
+
+    void submit(std::function<void()> task);
+    unsigned threadCount() const { return static_cast<unsigned>(workers_.size()); }
+    size_t pending() const;  // Tasks queued but not started
+
+    static BitsyExecutor& shared();  // Process-wide executor, started on first use
+
+private:
+    BitsyExecutor(const BitsyExecutor&);
+    BitsyExecutor& operator=(const BitsyExecutor&);
+
+    void work();
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<std::function<void()>> tasks_;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+};
+
+// Number of worker threads to use when the caller passes 0
+unsigned bitsyDefaultThreadCount();
+
+// Run task(worker, index) for every index in [0, count) on threadCount threads (0 = default).
+// Tasks are dealt round-robin in index order, so put the most expensive ones first.
+void bitsyParallelFor(size_t count, unsigned threadCount, const std::function<void(unsigned, size_t)>& task);
+
+#endif // BITSYPARALLEL_H
@@ -0,0 +1,52 @@
+#ifndef BITSYPARSESTATS_H
+#define BITSYPARSESTATS_H
+
+#include "BitsyBlockScanner.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Opt-in instrumentation filled in by BitsyGameParser when a stats object is passed in.
+// Timing and line counting only happen when one is supplied, so the default path pays nothing.
+struct BitsyParseStats {
+    static const int kSectionCount = kBlockBlip + 1;  // One entry per BitsyBlockType
+    static const size_t kMaxSamples = 16;  // Unrecognized lines kept verbatim
+
+    struct Section {
+        size_t blocks = 0;  // Blocks parsed
+        size_t skippedBlocks = 0;  // Blocks the visitor did not want
+        size_t bytes = 0;  // Bytes consumed, skipped blocks included
+        size_t lines = 0;  // Lines consumed, skipped blocks included
+        double seconds = 0;  // Time spent parsing and in the visitor's handlers
+        uint64_t allocations = 0;  // Only counted when allocationCounter is set
+    };
+
+    struct LineSample {
+        size_t line = 0;  // 1-based line number
+        std::string text;
+    };
+
+    // Optional hook returning a running allocation count (for example from a counting
+    // operator new). The parser reads it around every block and takes differences.
+    uint64_t (*allocationCounter)() = nullptr;
+
+    Section sections[kSectionCount];  // Indexed by BitsyBlockType; kBlockOther is unused
+    size_t bytes = 0;  // Bytes consumed in total
+    size_t lines = 0;  // Lines consumed in total
+    size_t blankLines = 0;  // Blank lines between blocks
+    size_t commentLines = 0;  // Lines starting with '#'
+    size_t unrecognizedLines = 0;  // Lines outside any block that match no keyword
+    std::vector<LineSample> unrecognizedSamples;  // The first kMaxSamples of them
+    double totalSeconds = 0;  // Whole parse, title included
+    double indexSeconds = 0;  // buildIndex() after a parseGameBuffer
+    uint64_t allocations = 0;  // Whole parse; only counted when allocationCounter is set
+
+    bool ok = true;  // False if the parse failed
+    std::string error;  // Error message on failure
+    size_t errorLine = 0;  // Line the parser was on when it failed (1-based)
+
+    void reset();  // Clear all counters, keeping allocationCounter
+    std::string toJson() const;  // JSON object with every counter
+};
+
+#endif // BITSYPARSESTATS_H
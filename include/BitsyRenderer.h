@@ -0,0 +1,60 @@
+#ifndef BITSYRENDERER_H
+#define BITSYRENDERER_H
+
+#include "BitsyGameData.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// RGB image, three bytes per pixel, rows top to bottom
+struct BitsyImage {
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> pixels;  // width * height * 3 bytes
+
+    const uint8_t* pixel(int x, int y) const { return &pixels[(y * width + x) * 3]; }  // R, G, B
+};
+
+enum BitsyImageFormat {
+    kImagePpm,  // Binary P6
+    kImagePng  // Uncompressed (stored deflate blocks)
+};
+
+// One room to render and where to write it
+struct BitsyRenderJob {
+    const BitsyGameData* game = nullptr;
+    const Room* room = nullptr;
+    std::string outputPath;
+};
+
+// Draws rooms the way Bitsy shows them: the palette's first color as background, tiles in
+// the second color, then items, sprites and the avatar in the third.
+//
+// Each 8-pixel frame row is expanded through a 256-entry table of byte masks, so drawing a
+// row is a fixed 24-byte select (out = (out & ~mask) | (color & mask)) that compilers vectorize.
+class BitsyRenderer {
+public:
+    static const int kTileSize = 8;  // Pixels per tile side
+    static const int kImageSize = RoomGrid::kSize * kTileSize;  // 128
+
+    // Render a room of game into image (resized to 128x128). frame selects the animation
+    // frame; entities with fewer frames wrap around. Unknown IDs are left undrawn and a
+    // missing palette falls back to black and white.
+    static void renderRoom(const BitsyGameData& game, const Room& room, int frame, BitsyImage& image);
+    static BitsyImage renderRoom(const BitsyGameData& game, const Room& room, int frame = 0);
+
+    static std::string encodePpm(const BitsyImage& image);
+    static std::string encodePng(const BitsyImage& image);
+    static bool writeImage(const BitsyImage& image, const std::string& filePath, BitsyImageFormat format);
+
+    // Jobs for every room of a game, written to pathPrefix + "room<id>.ppm" (or ".png")
+    static std::vector<BitsyRenderJob> roomJobs(const BitsyGameData& game, const std::string& pathPrefix,
+                                                BitsyImageFormat format);
+
+    // Render and write the jobs on threadCount threads (0 = one per core); each worker
+    // reuses one image buffer. Returns the number of files that could not be written.
+    static size_t renderBatch(const std::vector<BitsyRenderJob>& jobs, BitsyImageFormat format, int frame = 0,
+                              unsigned threadCount = 0);
+};
+
+#endif // BITSYRENDERER_H
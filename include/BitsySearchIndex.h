@@ -0,0 +1,159 @@
+#ifndef BITSYSEARCHINDEX_H
+#define BITSYSEARCHINDEX_H
+
+#include "BitsyBinaryFormat.h"
+#include "BitsyGameData.h"
+#include "BitsyMappedFile.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// On-disk inverted index over the searchable text of many games.
+//
+// Like the compiled game format, the file is a header followed by 8-byte aligned sections of
+// fixed-size records in host byte order, and is read straight out of a mapping. Terms are
+// sorted so lookups are binary searches; each term points at a run of postings sorted by
+// game, field, entity and position.
+
+enum BitsySearchField : uint8_t {
+    kSearchDialogueText,
+    kSearchDialogueName,
+    kSearchRoomName,
+    kSearchSpriteName,  // Entity IDs of sprites are their ID characters as unsigned values
+    kSearchItemName,
+    kSearchTuneName,
+    kSearchBlipName,
+    kSearchFieldCount
+};
+
+enum BitsyIdxSection {
+    kIdxStrings,  // Term text and game keys
+    kIdxGames,  // BitsyIdxGame records, indexed by game number
+    kIdxTerms,  // BitsyIdxTerm records sorted by text
+    kIdxPostings,
+    kIdxSectionCount
+};
+
+struct BitsyIdxHeader {
+    char magic[8];  // "BITSYIDX"
+    uint32_t version;  // kVersion
+    uint32_t byteOrder;  // BitsyBinHeader::kByteOrder as written by the producing host
+    uint32_t sectionCount;  // kIdxSectionCount
+    uint32_t reserved;
+    BitsyBinSectionEntry sections[kIdxSectionCount];
+
+    static const uint32_t kVersion = 1;
+};
+
+struct BitsyIdxGame {
+    BitsyBinString key;  // Caller's name for the game, usually its file path
+};
+
+struct BitsyIdxTerm {
+    BitsyBinString text;
+    uint32_t firstPosting;
+    uint32_t postingCount;
+};
+
+struct BitsyIdxPosting {
+    uint32_t game;
+    int32_t entityId;
+    uint32_t position;  // Word number within the field
+    uint8_t field;  // BitsySearchField
+    uint8_t reserved[3];
+};
+
+// Entity that matched a query, with the number of times it matched
+struct BitsySearchHit {
+    uint32_t game = 0;
+    BitsySearchField field = kSearchDialogueText;
+    int entityId = 0;
+    uint32_t matches = 0;
+};
+
+// Read-only view of an index file. Queries touch only the terms and postings they need, so
+// they cost a binary search plus the size of the result. Hits come back sorted by game,
+// field and entity. Query words go through tokenize() first, so case does not matter.
+class BitsySearchIndex {
+public:
+    bool open(const std::string& filePath);  // Map and validate a file
+    bool openBuffer(const char* data, size_t size);  // Validate a caller-owned buffer (8-byte aligned)
+
+    size_t gameCount() const { return header_ ? header_->sections[kIdxGames].count : 0; }
+    size_t termCount() const { return header_ ? header_->sections[kIdxTerms].count : 0; }
+    size_t postingCount() const { return header_ ? header_->sections[kIdxPostings].count : 0; }
+    BitsyStringView gameKey(uint32_t game) const;  // Empty for unknown game numbers
+    BitsyStringView termText(size_t term) const;  // Terms in sorted order
+
+    std::vector<BitsySearchHit> term(BitsyStringView word) const;  // Entities containing the word
+    std::vector<BitsySearchHit> prefix(BitsyStringView start) const;  // Containing any word starting so
+    std::vector<BitsySearchHit> phrase(BitsyStringView text) const;  // Containing the words in a row
+
+    // Query syntax: one word is a term query, a word ending in '*' a prefix query and several
+    // words a phrase query
+    std::vector<BitsySearchHit> search(BitsyStringView query) const;
+
+    // Lower-case ASCII words: runs of letters, digits and non-ASCII bytes. Text tags in
+    // braces such as {wvy} or {/clr1} are markup and are skipped.
+    static void tokenize(BitsyStringView text, std::vector<std::string>& words);
+
+private:
+    friend class BitsySearchIndexBuilder;
+
+    bool validate();
+    const BitsyIdxTerm* terms() const;
+    const BitsyIdxPosting* postings() const;
+    BitsyStringView string(BitsyBinString ref) const;
+    const BitsyIdxTerm* findTerm(BitsyStringView word) const;  // Exact match or nullptr
+
+    BitsyMappedFile file_;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    const BitsyIdxHeader* header_ = nullptr;
+};
+
+// Builds index files and keeps them up to date. Games are identified by key; adding a game
+// under a key that is already present replaces its postings, so re-indexing one changed game
+// means loading the existing index, adding that game and writing the file again, with no
+// other game parsed. The file is replaced by a rename, so readers that have the old one
+// mapped keep a consistent view.
+class BitsySearchIndexBuilder {
+public:
+    BitsySearchIndexBuilder() {}
+
+    // Start from an existing index, replacing the builder's contents. False, leaving the
+    // builder empty, if the index is not open.
+    bool load(const BitsySearchIndex& index);
+    void addGame(const std::string& key, const BitsyGameData& game);
+    bool removeGame(const std::string& key);  // False if there is no game under key
+    size_t gameCount() const { return keySlots_.size(); }
+
+    std::string serialize() const;  // Whole file image
+    bool writeFile(const std::string& filePath) const;  // Returns false on I/O errors
+
+private:
+    struct Posting {
+        uint32_t term;
+        int32_t entityId;
+        uint32_t position;
+        uint8_t field;
+    };
+    struct Game {
+        std::string key;
+        std::vector<Posting> postings;
+        bool live;
+    };
+
+    void addField(Game& game, BitsySearchField field, int entityId, BitsyStringView text);
+    uint32_t termId(const std::string& text);
+    Game& slot(const std::string& key);  // Empty live slot for key, reusing its old one
+
+    std::vector<Game> games_;  // Removed games stay as dead slots until the builder is reloaded
+    std::unordered_map<std::string, size_t> keySlots_;  // Live games by key
+    std::vector<std::string> terms_;
+    std::unordered_map<std::string, uint32_t> termIds_;
+    std::vector<std::string> words_;  // Scratch space for tokenize
+};
+
+#endif // BITSYSEARCHINDEX_H
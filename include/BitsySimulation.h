@@ -0,0 +1,153 @@
+#ifndef BITSYSIMULATION_H
+#define BITSYSIMULATION_H
+
+#include "BitsyGameData.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One bit per cell of a 16x16 room: bit (y * 16 + x), four words, row 4k..4k+3 in word k
+struct BitsyCellBitmap {
+    uint64_t words[4] = {0, 0, 0, 0};
+
+    bool test(int x, int y) const {
+        int bit = y * RoomGrid::kSize + x;
+        return (words[bit >> 6] >> (bit & 63)) & 1;
+    }
+    void set(int x, int y) {
+        int bit = y * RoomGrid::kSize + x;
+        words[bit >> 6] |= uint64_t(1) << (bit & 63);
+    }
+    bool any() const { return (words[0] | words[1] | words[2] | words[3]) != 0; }
+    int first() const;  // Index (y * 16 + x) of the lowest set cell, or -1
+    size_t count() const;
+
+    BitsyCellBitmap grown() const;  // Add every cell's four neighbours, clipped to the room
+
+    BitsyCellBitmap operator&(const BitsyCellBitmap& other) const;
+    BitsyCellBitmap operator|(const BitsyCellBitmap& other) const;
+    BitsyCellBitmap operator~() const;
+    bool operator==(const BitsyCellBitmap& other) const;
+    bool operator!=(const BitsyCellBitmap& other) const { return !(*this == other); }
+};
+
+enum BitsyInput : uint8_t {
+    kInputNone,
+    kInputUp,
+    kInputDown,
+    kInputLeft,
+    kInputRight
+};
+
+// Bit flags describing what a step did
+enum BitsyStepEvent : uint32_t {
+    kEventMoved = 1,  // The avatar changed cell (or room)
+    kEventBlocked = 2,  // A wall, sprite or room edge stopped the move
+    kEventItem = 4,  // An item was picked up
+    kEventExit = 8,  // An exit moved the avatar to another room or position
+    kEventEnd = 16,  // An ending was reached; further steps do nothing
+    kEventDialogue = 32  // A dialogue was triggered (see BitsyStepResult::dialogueId)
+};
+
+struct BitsyStepResult {
+    uint32_t events = 0;  // BitsyStepEvent flags
+    int dialogueId = -1;  // Dialogue triggered by a sprite, item, exit or ending
+    int itemId = -1;  // Item picked up
+};
+
+// Mutable part of a running game. Cheap to copy, so searches can branch from any state.
+struct BitsyPlayState {
+    int room = -1;  // Room slot in the BitsyWorld, -1 if the avatar's room does not exist
+    int x = 0, y = 0;
+    uint8_t ended = 0;  // Nonzero once an ending was reached
+    int endDialogueId = -1;  // Dialogue of the ending reached
+    uint64_t steps = 0;  // Steps taken, including blocked ones
+    std::vector<int> inventory;  // Count per item slot (index into BitsyGameData::items)
+    std::vector<uint64_t> takenItems;  // Bit per placed item (BitsyWorld::placedItemCount)
+    std::vector<int> variables;  // Value per variable (BitsyWorld::variableNames)
+};
+
+// Pointers to the fields of one play state wherever they live. Inventory counts and taken-item
+// words are strided so structure-of-arrays storage (BitsyBatchRunner) can be stepped in place.
+struct BitsyStateRef {
+    int* room;
+    int* x;
+    int* y;
+    uint8_t* ended;
+    int* endDialogueId;
+    int* inventory;  // Count of item slot s at inventory[s * inventoryStride]
+    size_t inventoryStride;
+    uint64_t* takenItems;  // Word w at takenItems[w * takenStride]
+    size_t takenStride;
+};
+
+// Immutable, precomputed form of a game for simulation. Every room's walls, sprites, items,
+// exits and endings become 256-bit cell bitmaps, so a step is a handful of bit tests; the
+// entity lists are only searched when a bitmap says something is there.
+//
+// The world keeps no reference to the BitsyGameData it was built from.
+class BitsyWorld {
+public:
+    struct PlacedItem {
+        int x, y;
+        int itemSlot;  // Index into BitsyGameData::items
+        int itemId;
+        int dialogueId;
+        int index;  // Bit in BitsyPlayState::takenItems
+    };
+    struct PlacedExit {
+        int x, y;
+        int destinationRoom;  // Room slot
+        int destinationX, destinationY;
+        int dialogueId;
+    };
+    struct PlacedEnd {
+        int x, y;
+        int dialogueId;
+    };
+    struct PlacedSprite {
+        int x, y;
+        int dialogueId;
+    };
+    struct RoomInfo {
+        int id;
+        BitsyCellBitmap walls;  // Cells whose tile is a wall
+        BitsyCellBitmap blocked;  // Walls and sprites: cells the avatar cannot enter
+        BitsyCellBitmap triggers;  // Cells holding an item, exit or ending
+        std::vector<PlacedItem> items;
+        std::vector<PlacedExit> exits;  // Only exits to rooms that exist
+        std::vector<PlacedEnd> endings;
+        std::vector<PlacedSprite> sprites;
+    };
+
+    explicit BitsyWorld(const BitsyGameData& game);
+
+    BitsyPlayState initialState() const;  // Avatar start position and inventory
+    BitsyStepResult step(BitsyPlayState& state, BitsyInput input) const;  // Advance one move
+    BitsyStepResult step(const BitsyStateRef& state, BitsyInput input) const;  // Same, without the step count
+
+    // Apply inputs in order until they run out or an ending is reached; returns the number applied
+    size_t run(BitsyPlayState& state, const BitsyInput* inputs, size_t count) const;
+
+    int roomSlot(int roomId) const { return roomIndex_.slot(roomId); }  // -1 if absent
+    const std::vector<RoomInfo>& rooms() const { return rooms_; }
+    size_t placedItemCount() const { return placedItemCount_; }
+    size_t itemCount() const { return itemCount_; }
+
+    // Variables as numbers ("true" is 1, "false" and non-numeric values are 0), sorted by name
+    const std::vector<std::string>& variableNames() const { return variableNames_; }
+    const std::vector<int>& initialVariables() const { return initialVariables_; }
+
+private:
+    std::vector<RoomInfo> rooms_;
+    BitsyIdIndex roomIndex_;
+    size_t placedItemCount_ = 0;
+    size_t itemCount_ = 0;
+    int startRoom_ = -1;
+    int startX_ = 0, startY_ = 0;
+    std::vector<int> startInventory_;
+    std::vector<std::string> variableNames_;
+    std::vector<int> initialVariables_;
+};
+
+#endif // BITSYSIMULATION_H
@@ -0,0 +1,55 @@
+#ifndef BITSYSTRINGVIEW_H
+#define BITSYSTRINGVIEW_H
+
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+// Non-owning view into a character buffer (the project targets C++11, so no std::string_view)
+struct BitsyStringView {
+    const char* data = nullptr;  // First character of the view
+    size_t size = 0;  // Number of characters in the view
+
+    BitsyStringView() {}
+    BitsyStringView(const char* d, size_t n) : data(d), size(n) {}
+    BitsyStringView(const char* s) : data(s), size(std::strlen(s)) {}
+    BitsyStringView(const std::string& s) : data(s.data()), size(s.size()) {}
+
+    bool empty() const { return size == 0; }
+    const char* begin() const { return data; }
+    const char* end() const { return data + size; }
+
+    // Same contract as std::string::operator[]: reading at size yields '\0'
+    char operator[](size_t i) const { return i < size ? data[i] : '\0'; }
+
+    // Same contract as std::string::substr: throws std::out_of_range when pos > size
+    BitsyStringView substr(size_t pos) const {
+        if (pos > size) throw std::out_of_range("BitsyStringView::substr");
+        return BitsyStringView(data + pos, size - pos);
+    }
+
+    bool contains(BitsyStringView needle) const {
+        if (needle.size == 0) return true;
+        if (needle.size > size) return false;
+        const char* last = data + size - needle.size;
+        for (const char* p = data; p <= last; ++p) {
+            p = static_cast<const char*>(std::memchr(p, needle.data[0], last - p + 1));
+            if (!p) return false;
+            if (std::memcmp(p, needle.data, needle.size) == 0) return true;
+        }
+        return false;
+    }
+
+    std::string str() const { return std::string(data, size); }
+};
+
+inline bool operator==(BitsyStringView a, BitsyStringView b) {
+    return a.size == b.size && (a.size == 0 || std::memcmp(a.data, b.data, a.size) == 0);
+}
+
+inline bool operator!=(BitsyStringView a, BitsyStringView b) {
+    return !(a == b);
+}
+
+#endif // BITSYSTRINGVIEW_H
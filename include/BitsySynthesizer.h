@@ -0,0 +1,68 @@
+#ifndef BITSYSYNTHESIZER_H
+#define BITSYSYNTHESIZER_H
+
+#include "BitsyGameData.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Mono 16-bit PCM
+struct BitsyAudio {
+    int sampleRate = 0;
+    std::vector<int16_t> samples;
+
+    double seconds() const { return sampleRate ? static_cast<double>(samples.size()) / sampleRate : 0; }
+};
+
+struct BitsyAudioOptions {
+    int sampleRate = 44100;
+    float volume = 0.5f;  // Peak amplitude of a blip; each tune voice gets half
+};
+
+// One tune or blip to render and where to write it
+struct BitsyAudioJob {
+    const Tune* tune = nullptr;  // Exactly one of tune and blip is set
+    const Blip* blip = nullptr;
+    std::string outputPath;
+};
+
+// Renders tunes and blips to PCM with pulse-wave voices, the way Bitsy's sound chip plays them:
+//
+//  - Tunes are bars of 16 steps, a treble and a bass line each. A step holds "0" (nothing
+//    new) or a note: an optional length in steps, a letter (C..B, or d r m f s l t picked
+//    from the KEY scale), an optional '#', and an optional octave (default 4), e.g. "3d5",
+//    "2F#" or "G3". A note sounds until its length runs out or the next note in its line.
+//    TMP sets the speed (SLW, MED, FST, XFST: 4, 8, 12 or 16 steps per second), SQR the
+//    pulse width of treble and bass (P2, P4, P8: 1/2, 1/4, 1/8), and ARP (UP, DWN, INT5,
+//    INT8) turns treble notes into fast arpeggios, four notes per step.
+//  - Blips are a list of notes under one envelope. ENV is attack ms, decay ms, sustain
+//    level (0-15), hold ms and release ms; BEAT is ms per note and ms of silence between
+//    notes. The notes loop while the envelope lasts if RPT is set, otherwise the last one holds.
+//    Each envelope segment and beat length is capped at kMaxBlipSegmentMs.
+//
+// Sound is produced a block of samples at a time by small loops (pulse oscillator, linear
+// envelope ramp, mix) with no branches or calls inside, which compilers vectorize. Rendering
+// uses only the inputs, so the same tune always gives the same samples.
+class BitsySynthesizer {
+public:
+    static const int kBlockSize = 256;  // Samples per kernel call
+    static const int kMaxBlipSegmentMs = 5000;  // Longest ENV segment or BEAT length honoured
+
+    static void renderTune(const Tune& tune, const BitsyAudioOptions& options, BitsyAudio& audio);
+    static BitsyAudio renderTune(const Tune& tune, const BitsyAudioOptions& options = BitsyAudioOptions());
+    static void renderBlip(const Blip& blip, const BitsyAudioOptions& options, BitsyAudio& audio);
+    static BitsyAudio renderBlip(const Blip& blip, const BitsyAudioOptions& options = BitsyAudioOptions());
+
+    static std::string encodeWav(const BitsyAudio& audio);
+    static bool writeWav(const BitsyAudio& audio, const std::string& filePath);
+
+    // Jobs for every tune and blip of a game, written to pathPrefix + "tune<id>.wav" and "blip<id>.wav"
+    static std::vector<BitsyAudioJob> audioJobs(const BitsyGameData& game, const std::string& pathPrefix);
+
+    // Render and write the jobs on threadCount threads (0 = one per core); each worker reuses
+    // one sample buffer. Returns the number of files that could not be rendered or written.
+    static size_t renderBatch(const std::vector<BitsyAudioJob>& jobs,
+                              const BitsyAudioOptions& options = BitsyAudioOptions(), unsigned threadCount = 0);
+};
+
+#endif // BITSYSYNTHESIZER_H
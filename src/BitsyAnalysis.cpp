@@ -0,0 +1,325 @@
+#include <BitsyAnalysis.h>
+#include <BitsyJsonString.h>
+#include <sstream>
+
+namespace {
+
+bool inRoom(int x, int y) {
+    return x >= 0 && x < RoomGrid::kSize && y >= 0 && y < RoomGrid::kSize;
+}
+
+template <typename Fn>
+void forEachCell(const BitsyCellBitmap& cells, const Fn& fn) {
+    for (int w = 0; w < 4; ++w) {
+        for (uint64_t bits = cells.words[w]; bits; bits &= bits - 1) fn(w * 64 + __builtin_ctzll(bits));
+    }
+}
+
+// Up to four in-room neighbours of a cell; returns how many were written
+int neighbours(int cell, int* out) {
+    int x = cell % RoomGrid::kSize, y = cell / RoomGrid::kSize, count = 0;
+    if (x > 0) out[count++] = cell - 1;
+    if (x < RoomGrid::kSize - 1) out[count++] = cell + 1;
+    if (y > 0) out[count++] = cell - RoomGrid::kSize;
+    if (y < RoomGrid::kSize - 1) out[count++] = cell + RoomGrid::kSize;
+    return count;
+}
+
+// Counting sort of (from, to) pairs into compressed sparse rows
+void buildCsr(size_t nodes, const std::vector<std::pair<int, int>>& edges, std::vector<int>& offsets,
+              std::vector<int>& targets) {
+    offsets.assign(nodes + 1, 0);
+    for (const auto& edge : edges) ++offsets[edge.first + 1];
+    for (size_t n = 0; n < nodes; ++n) offsets[n + 1] += offsets[n];
+    targets.resize(edges.size());
+    std::vector<int> fill(offsets.begin(), offsets.end() - 1);
+    for (const auto& edge : edges) targets[fill[edge.first]++] = edge.second;
+}
+
+bool testBit(const std::vector<uint64_t>& bits, int index) {
+    return (bits[index >> 6] >> (index & 63)) & 1;
+}
+
+// Sets the bit; returns false if it already was
+bool markBit(std::vector<uint64_t>& bits, int index) {
+    uint64_t bit = uint64_t(1) << (index & 63);
+    if (bits[index >> 6] & bit) return false;
+    bits[index >> 6] |= bit;
+    return true;
+}
+
+}  // namespace
+
+bool BitsyAnalysisReport::clean() const {
+    return unreachableRooms.empty() && brokenExits.empty() && unreachableEndings.empty() &&
+           danglingReferences.empty();
+}
+
+std::string BitsyAnalysisReport::toJson() const {
+    std::ostringstream out;
+    out << "{\"clean\": " << (clean() ? "true" : "false") << ", \"unreachable_rooms\": [";
+    for (size_t i = 0; i < unreachableRooms.size(); ++i) out << (i ? ", " : "") << unreachableRooms[i];
+    out << "], \"broken_exits\": [";
+    for (size_t i = 0; i < brokenExits.size(); ++i) {
+        const BitsyBrokenExit& exit = brokenExits[i];
+        out << (i ? ", " : "") << "{\"room\": " << exit.roomId << ", \"x\": " << exit.x << ", \"y\": " << exit.y
+            << ", \"destination\": " << exit.destinationRoomId << '}';
+    }
+    out << "], \"unreachable_endings\": [";
+    for (size_t i = 0; i < unreachableEndings.size(); ++i) {
+        const BitsyUnreachableEnd& end = unreachableEndings[i];
+        out << (i ? ", " : "") << "{\"room\": " << end.roomId << ", \"x\": " << end.x << ", \"y\": " << end.y
+            << ", \"dialogue\": " << end.dialogueId << '}';
+    }
+    out << "], \"dangling_references\": [";
+    for (size_t i = 0; i < danglingReferences.size(); ++i) {
+        const BitsyDanglingReference& reference = danglingReferences[i];
+        out << (i ? ", " : "") << "{\"kind\": ";
+        bitsyAppendJsonString(out, reference.kind);
+        out << ", \"owner_type\": ";
+        bitsyAppendJsonString(out, reference.ownerType);
+        out << ", \"owner_id\": ";
+        bitsyAppendJsonString(out, reference.ownerId);
+        out << ", \"id\": ";
+        bitsyAppendJsonString(out, reference.id);
+        out << '}';
+    }
+    out << "]}";
+    return out.str();
+}
+
+BitsyGameAnalysis::BitsyGameAnalysis(const BitsyGameData& game) : world_(game) {
+    buildNodes();
+    buildEdges();
+    search();
+
+    const std::vector<BitsyWorld::RoomInfo>& rooms = world_.rooms();
+    for (size_t slot = 0; slot < rooms.size(); ++slot) {
+        if (!roomReached_[slot]) report_.unreachableRooms.push_back(rooms[slot].id);
+        for (const BitsyWorld::PlacedEnd& end : rooms[slot].endings) {
+            if (!reachable(rooms[slot].id, end.x, end.y)) {
+                BitsyUnreachableEnd entry = {rooms[slot].id, end.x, end.y, end.dialogueId};
+                report_.unreachableEndings.push_back(entry);
+            }
+        }
+    }
+    for (const Room& room : game.rooms) {
+        for (const Exit& exit : room.exits) {
+            if (game.findRoom(exit.destinationRoomId)) continue;
+            BitsyBrokenExit entry = {room.id, exit.startPosition.first, exit.startPosition.second,
+                                     exit.destinationRoomId};
+            report_.brokenExits.push_back(entry);
+        }
+    }
+    findDanglingReferences(game);
+}
+
+void BitsyGameAnalysis::buildNodes() {
+    const std::vector<BitsyWorld::RoomInfo>& rooms = world_.rooms();
+    cellNodes_.assign(rooms.size() * RoomGrid::kCells, -1);
+
+    for (size_t slot = 0; slot < rooms.size(); ++slot) {
+        const BitsyWorld::RoomInfo& info = rooms[slot];
+        int* cells = &cellNodes_[slot * RoomGrid::kCells];
+
+        // Exits and endings end a walk, so they split regions like walls do
+        BitsyCellBitmap stops;
+        for (const BitsyWorld::PlacedExit& exit : info.exits) stops.set(exit.x, exit.y);
+        for (const BitsyWorld::PlacedEnd& end : info.endings) stops.set(end.x, end.y);
+
+        // Flood-fill one region at a time by growing a seed cell until it stops changing.
+        // Every grow step is a few word operations, and the steps over all regions of a
+        // room add up to at most one per cell.
+        BitsyCellBitmap open = ~(info.blocked | stops);
+        while (open.any()) {
+            int seed = open.first();
+            BitsyCellBitmap region;
+            region.set(seed % RoomGrid::kSize, seed / RoomGrid::kSize);
+            for (;;) {
+                BitsyCellBitmap grown = region.grown() & open;
+                if (grown == region) break;
+                region = grown;
+            }
+            int node = static_cast<int>(nodeRoom_.size());
+            nodeRoom_.push_back(static_cast<int>(slot));
+            nodeCell_.push_back(-1);
+            forEachCell(region, [&](int cell) { cells[cell] = node; });
+            open = open & ~region;
+            ++regionCount_;
+        }
+
+        // An exit or ending under a wall or sprite can never be stepped on and gets no node
+        forEachCell(stops & ~info.blocked, [&](int cell) {
+            cells[cell] = static_cast<int>(nodeRoom_.size());
+            nodeRoom_.push_back(static_cast<int>(slot));
+            nodeCell_.push_back(cell);
+        });
+    }
+}
+
+void BitsyGameAnalysis::appendEntry(int room, int x, int y, std::vector<int>& nodes) const {
+    // Arriving on floor puts the avatar in that cell's region. Arriving anywhere else (on an
+    // exit, or on a wall) leaves it free to step onto any neighbouring cell that has a node.
+    const int* cells = &cellNodes_[static_cast<size_t>(room) * RoomGrid::kCells];
+    int cell = y * RoomGrid::kSize + x;
+    if (cells[cell] >= 0 && nodeCell_[cells[cell]] < 0) {
+        nodes.push_back(cells[cell]);
+        return;
+    }
+    int around[4];
+    int count = neighbours(cell, around);
+    for (int i = 0; i < count; ++i) {
+        if (cells[around[i]] >= 0) nodes.push_back(cells[around[i]]);
+    }
+}
+
+void BitsyGameAnalysis::buildEdges() {
+    const std::vector<BitsyWorld::RoomInfo>& rooms = world_.rooms();
+    std::vector<std::pair<int, int>> edges;
+    std::vector<int> entry;
+
+    for (size_t node = 0; node < nodeRoom_.size(); ++node) {
+        int cell = nodeCell_[node];
+        if (cell < 0) continue;
+        int slot = nodeRoom_[node];
+        const int* cells = &cellNodes_[static_cast<size_t>(slot) * RoomGrid::kCells];
+
+        // Regions touching the cell lead onto it
+        int around[4];
+        int count = neighbours(cell, around);
+        for (int i = 0; i < count; ++i) {
+            int from = cells[around[i]];
+            if (from >= 0 && nodeCell_[from] < 0) edges.push_back(std::make_pair(from, static_cast<int>(node)));
+        }
+
+        // Endings take precedence over exits on the same cell, as in BitsyWorld::step
+        const BitsyWorld::RoomInfo& info = rooms[slot];
+        int x = cell % RoomGrid::kSize, y = cell / RoomGrid::kSize;
+        bool ending = false;
+        for (const BitsyWorld::PlacedEnd& end : info.endings) ending = ending || (end.x == x && end.y == y);
+        if (ending) continue;
+        for (const BitsyWorld::PlacedExit& exit : info.exits) {
+            if (exit.x != x || exit.y != y) continue;
+            entry.clear();
+            appendEntry(exit.destinationRoom, exit.destinationX, exit.destinationY, entry);
+            for (int to : entry) edges.push_back(std::make_pair(static_cast<int>(node), to));
+            break;
+        }
+    }
+    buildCsr(nodeRoom_.size(), edges, offsets_, targets_);
+
+    edges.clear();
+    for (size_t slot = 0; slot < rooms.size(); ++slot) {
+        for (const BitsyWorld::PlacedExit& exit : rooms[slot].exits) {
+            edges.push_back(std::make_pair(static_cast<int>(slot), exit.destinationRoom));
+        }
+    }
+    buildCsr(rooms.size(), edges, roomOffsets_, roomTargets_);
+}
+
+void BitsyGameAnalysis::search() {
+    reached_.assign((nodeRoom_.size() + 63) / 64, 0);
+    roomReached_.assign(world_.rooms().size(), 0);
+
+    BitsyPlayState start = world_.initialState();
+    if (start.room < 0 || !inRoom(start.x, start.y)) return;
+
+    std::vector<int> queue;
+    appendEntry(start.room, start.x, start.y, queue);
+    roomReached_[start.room] = 1;
+    size_t head = 0;
+    for (size_t i = 0; i < queue.size(); ++i) {
+        if (markBit(reached_, queue[i])) queue[head++] = queue[i];
+    }
+    queue.resize(head);
+
+    for (head = 0; head < queue.size(); ++head) {
+        int node = queue[head];
+        roomReached_[nodeRoom_[node]] = 1;
+        for (int edge = offsets_[node]; edge < offsets_[node + 1]; ++edge) {
+            if (markBit(reached_, targets_[edge])) queue.push_back(targets_[edge]);
+        }
+    }
+}
+
+bool BitsyGameAnalysis::reachable(int roomId) const {
+    int slot = world_.roomSlot(roomId);
+    return slot >= 0 && roomReached_[slot];
+}
+
+bool BitsyGameAnalysis::reachable(int roomId, int x, int y) const {
+    int slot = world_.roomSlot(roomId);
+    if (slot < 0 || !inRoom(x, y)) return false;
+    int node = cellNodes_[static_cast<size_t>(slot) * RoomGrid::kCells + y * RoomGrid::kSize + x];
+    return node >= 0 && testBit(reached_, node);
+}
+
+std::vector<int> BitsyGameAnalysis::linkedRooms(int roomId) const {
+    std::vector<int> result;
+    int slot = world_.roomSlot(roomId);
+    if (slot < 0) return result;
+
+    const std::vector<BitsyWorld::RoomInfo>& rooms = world_.rooms();
+    std::vector<uint64_t> seen((rooms.size() + 63) / 64, 0);
+    std::vector<int> queue(1, slot);
+    markBit(seen, slot);
+    for (size_t head = 0; head < queue.size(); ++head) {
+        int room = queue[head];
+        result.push_back(rooms[room].id);
+        for (int edge = roomOffsets_[room]; edge < roomOffsets_[room + 1]; ++edge) {
+            if (markBit(seen, roomTargets_[edge])) queue.push_back(roomTargets_[edge]);
+        }
+    }
+    return result;
+}
+
+void BitsyGameAnalysis::findDanglingReferences(const BitsyGameData& game) {
+    std::vector<BitsyDanglingReference>& out = report_.danglingReferences;
+    auto add = [&out](const char* kind, const char* ownerType, const std::string& ownerId, const std::string& id) {
+        BitsyDanglingReference reference = {kind, ownerType, ownerId, id};
+        out.push_back(reference);
+    };
+    auto checkDialogue = [&](int id, const char* ownerType, const std::string& ownerId) {
+        if (id != -1 && !game.findDialogue(id)) add("dialogue", ownerType, ownerId, std::to_string(id));
+    };
+    auto checkBlip = [&](int id, const char* ownerType, const std::string& ownerId) {
+        if (id != -1 && !game.findBlip(id)) add("blip", ownerType, ownerId, std::to_string(id));
+    };
+
+    for (const Room& room : game.rooms) {
+        std::string owner = std::to_string(room.id);
+        if (!game.findPalette(room.paletteId)) add("palette", "room", owner, std::to_string(room.paletteId));
+        if (room.tuneId != 0 && !game.findTune(room.tuneId)) add("tune", "room", owner, std::to_string(room.tuneId));
+
+        bool seen[256] = {};
+        for (int y = 0; y < RoomGrid::kSize; ++y) {
+            for (int x = 0; x < RoomGrid::kSize; ++x) {
+                char tile = room.tiles.at(x, y);
+                unsigned char key = static_cast<unsigned char>(tile);
+                if (tile == '0' || seen[key]) continue;
+                seen[key] = true;
+                if (!game.findTile(tile)) add("tile", "room", owner, std::string(1, tile));
+            }
+        }
+        for (const auto& placed : room.items) {
+            if (!game.findItem(placed.first)) add("item", "room", owner, std::to_string(placed.first));
+        }
+        for (const Exit& exit : room.exits) checkDialogue(exit.dialogueId, "room", owner);
+        for (const End& end : room.endings) checkDialogue(end.dialogueId, "room", owner);
+    }
+    for (const Sprite& sprite : game.sprites) {
+        std::string owner(1, sprite.id);
+        checkDialogue(sprite.dialogId, "sprite", owner);
+        checkBlip(sprite.blipId, "sprite", owner);
+        if (!game.findRoom(sprite.roomId)) add("room", "sprite", owner, std::to_string(sprite.roomId));
+    }
+    for (const Item& item : game.items) {
+        std::string owner = std::to_string(item.id);
+        checkDialogue(item.dialogId, "item", owner);
+        checkBlip(item.blipId, "item", owner);
+    }
+    if (!game.findRoom(game.avatar.roomId)) add("room", "avatar", "A", std::to_string(game.avatar.roomId));
+    for (int itemId : game.avatar.inventory) {
+        if (!game.findItem(itemId)) add("item", "avatar", "A", std::to_string(itemId));
+    }
+}
@@ -0,0 +1,73 @@
+#include <BitsyArena.h>
+#include <cstdint>
+
+BitsyArena::BitsyArena(size_t initialCapacity) {
+    if (initialCapacity > 0) addBlock(initialCapacity);
+}
+
+void* BitsyArena::allocate(size_t size, size_t alignment) {
+    if (!blocks_.empty()) {
+        Block& block = blocks_.back();
+        uintptr_t base = reinterpret_cast<uintptr_t>(block.memory.get());
+        size_t offset = ((base + used_ + alignment - 1) & ~(uintptr_t(alignment) - 1)) - base;
+        if (offset + size <= block.capacity) {
+            used_ = offset + size;
+            return block.memory.get() + offset;
+        }
+    }
+    addBlock(size + alignment);
+    return allocate(size, alignment);
+}
+
+BitsyStringView BitsyArena::copyString(BitsyStringView text) {
+    if (text.size == 0) return BitsyStringView();
+    char* out = static_cast<char*>(allocate(text.size, 1));
+    std::memcpy(out, text.data, text.size);
+    return BitsyStringView(out, text.size);
+}
+
+void BitsyArena::reserve(size_t bytes) {
+    if (blocks_.empty() || blocks_.back().capacity - used_ < bytes) addBlock(bytes);
+}
+
+void BitsyArena::reset() {
+    // Several blocks mean the last round outgrew the first one: replace them with one block
+    // big enough for everything, so the next round of the same size is a single allocation
+    if (blocks_.size() > 1) {
+        size_t total = bytesReserved();
+        blocks_.clear();
+        used_ = 0;
+        usedBefore_ = 0;
+        addBlock(total);
+    }
+    used_ = 0;
+    usedBefore_ = 0;
+}
+
+void BitsyArena::release() {
+    blocks_.clear();
+    used_ = 0;
+    usedBefore_ = 0;
+}
+
+size_t BitsyArena::bytesUsed() const {
+    return usedBefore_ + used_;
+}
+
+size_t BitsyArena::bytesReserved() const {
+    size_t total = 0;
+    for (size_t i = 0; i < blocks_.size(); ++i) total += blocks_[i].capacity;
+    return total;
+}
+
+void BitsyArena::addBlock(size_t minimum) {
+    // Grow geometrically so a game that outgrows its estimate needs few extra blocks
+    size_t capacity = blocks_.empty() ? 4096 : blocks_.back().capacity * 2;
+    if (capacity < minimum) capacity = minimum;
+    usedBefore_ += used_;
+    used_ = 0;
+    Block block;
+    block.memory.reset(new char[capacity]);
+    block.capacity = capacity;
+    blocks_.push_back(std::move(block));
+}
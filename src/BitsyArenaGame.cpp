@@ -0,0 +1,345 @@
+#include <BitsyArenaGame.h>
+#include <BitsyGameParser.h>
+#include <BitsyGameVisitor.h>
+#include <BitsyMappedFile.h>
+#include <algorithm>
+
+// Visitor that copies each parsed entity into the game's arena
+class BitsyArenaBuilder : public BitsyGameVisitor {
+public:
+    explicit BitsyArenaBuilder(BitsyArenaGame& game) : game_(game), arena_(game.arena_) {}
+
+    bool onTitle(BitsyStringView title) override {
+        game_.title = arena_.copyString(title);
+        return true;
+    }
+
+    bool onSetting(BitsyStringView key, int value) override {
+        if (key == "VER_MAJ") game_.settings.verMaj = value;
+        else if (key == "VER_MIN") game_.settings.verMin = value;
+        else if (key == "ROOM_FORMAT") game_.settings.roomFormat = value;
+        else if (key == "DLG_COMPAT") game_.settings.dlgCompat = value;
+        else if (key == "TXT_MODE") game_.settings.txtMode = value;
+        return true;
+    }
+
+    bool onPalette(Palette& palette) override {
+        ArenaPalette out;
+        out.id = palette.id;
+        out.color1 = palette.color1;
+        out.color2 = palette.color2;
+        out.color3 = palette.color3;
+        out.name = arena_.copyString(palette.name);
+        game_.stagedPalettes_.push_back(out);
+        return true;
+    }
+
+    bool onRoom(Room& room) override {
+        ArenaRoom out;
+        out.id = room.id;
+        out.tiles = room.tiles;
+        out.items = arena_.copyArray(room.items);
+        ArenaExit* exits = arena_.allocateArray<ArenaExit>(room.exits.size());
+        for (size_t i = 0; i < room.exits.size(); ++i) {
+            const Exit& ext = room.exits[i];
+            exits[i].startPosition = ext.startPosition;
+            exits[i].destinationRoomId = ext.destinationRoomId;
+            exits[i].destinationPosition = ext.destinationPosition;
+            exits[i].effect = arena_.copyString(ext.effect);
+            exits[i].dialogueId = ext.dialogueId;
+        }
+        out.exits = BitsySpan<ArenaExit>(exits, room.exits.size());
+        out.endings = arena_.copyArray(room.endings);
+        out.paletteId = room.paletteId;
+        out.tuneId = room.tuneId;
+        out.name = arena_.copyString(room.name);
+        game_.stagedRooms_.push_back(out);
+        return true;
+    }
+
+    bool onTile(Tile& tile) override {
+        ArenaTile out;
+        out.id = tile.id;
+        out.frames = tile.frames;
+        out.name = arena_.copyString(tile.name);
+        out.wall = tile.wall;
+        game_.stagedTiles_.push_back(out);
+        return true;
+    }
+
+    bool onAvatar(Avatar& avatar) override {
+        game_.avatar.frames = avatar.frames;
+        game_.avatar.roomId = avatar.roomId;
+        game_.avatar.position = avatar.position;
+        game_.avatar.inventory = arena_.copyArray(avatar.inventory);
+        return true;
+    }
+
+    bool onSprite(Sprite& sprite) override {
+        ArenaSprite out;
+        out.id = sprite.id;
+        out.frames = sprite.frames;
+        out.name = arena_.copyString(sprite.name);
+        out.dialogId = sprite.dialogId;
+        out.blipId = sprite.blipId;
+        out.roomId = sprite.roomId;
+        out.position = sprite.position;
+        game_.stagedSprites_.push_back(out);
+        return true;
+    }
+
+    bool onItem(Item& item) override {
+        ArenaItem out;
+        out.id = item.id;
+        out.frames = item.frames;
+        out.name = arena_.copyString(item.name);
+        out.dialogId = item.dialogId;
+        out.blipId = item.blipId;
+        game_.stagedItems_.push_back(out);
+        return true;
+    }
+
+    bool onDialogue(Dialogue& dialogue) override {
+        ArenaDialogue out;
+        out.id = dialogue.id;
+        out.text = arena_.copyString(dialogue.text);
+        out.name = arena_.copyString(dialogue.name);
+        game_.stagedDialogues_.push_back(out);
+        return true;
+    }
+
+    bool onVariable(Variable& variable) override {
+        ArenaVariable out;
+        out.name = arena_.copyString(variable.name);
+        out.value = arena_.copyString(variable.value);
+        game_.stagedVariables_.push_back(out);
+        return true;
+    }
+
+    bool onTune(Tune& tune) override {
+        ArenaTune out;
+        out.id = tune.id;
+        out.treblePatterns = copyStrings(tune.treblePatterns);
+        out.bassPatterns = copyStrings(tune.bassPatterns);
+        out.key = arena_.copyString(tune.key);
+        out.tempo = arena_.copyString(tune.tempo);
+        out.trebleInstrument = arena_.copyString(tune.trebleInstrument);
+        out.bassInstrument = arena_.copyString(tune.bassInstrument);
+        out.arpeggio = arena_.copyString(tune.arpeggio);
+        out.name = arena_.copyString(tune.name);
+        game_.stagedTunes_.push_back(out);
+        return true;
+    }
+
+    bool onBlip(Blip& blip) override {
+        ArenaBlip out;
+        out.id = blip.id;
+        out.notes = arena_.copyString(blip.notes);
+        out.env = arena_.copyArray(blip.env);
+        out.beat = arena_.copyArray(blip.beat);
+        out.squareWave = arena_.copyString(blip.squareWave);
+        out.repeat = blip.repeat;
+        out.name = arena_.copyString(blip.name);
+        game_.stagedBlips_.push_back(out);
+        return true;
+    }
+
+    // Move the staged entities into the arena as contiguous arrays
+    void finish() {
+        // Variables behave like the std::map in BitsyGameData: sorted, and the last definition wins
+        std::vector<ArenaVariable>& vars = game_.stagedVariables_;
+        std::stable_sort(vars.begin(), vars.end(), [](const ArenaVariable& a, const ArenaVariable& b) {
+            return std::lexicographical_compare(a.name.begin(), a.name.end(), b.name.begin(), b.name.end());
+        });
+        size_t kept = 0;
+        for (size_t i = 0; i < vars.size(); ++i) {
+            if (kept > 0 && vars[kept - 1].name == vars[i].name) vars[kept - 1] = vars[i];
+            else vars[kept++] = vars[i];
+        }
+        vars.resize(kept);
+
+        game_.palettes = arena_.copyArray(game_.stagedPalettes_);
+        game_.rooms = arena_.copyArray(game_.stagedRooms_);
+        game_.tiles = arena_.copyArray(game_.stagedTiles_);
+        game_.sprites = arena_.copyArray(game_.stagedSprites_);
+        game_.items = arena_.copyArray(game_.stagedItems_);
+        game_.dialogues = arena_.copyArray(game_.stagedDialogues_);
+        game_.variables = arena_.copyArray(vars);
+        game_.tunes = arena_.copyArray(game_.stagedTunes_);
+        game_.blips = arena_.copyArray(game_.stagedBlips_);
+    }
+
+private:
+    BitsySpan<BitsyStringView> copyStrings(const std::vector<std::string>& values) {
+        std::vector<BitsyStringView>& staged = game_.stagedPatterns_;
+        staged.clear();
+        for (size_t i = 0; i < values.size(); ++i) staged.push_back(arena_.copyString(values[i]));
+        return arena_.copyArray(staged);
+    }
+
+    BitsyArenaGame& game_;
+    BitsyArena& arena_;
+};
+
+bool BitsyArenaGame::loadFile(const std::string& filePath, std::string& error) {
+    BitsyMappedFile file;
+
+    if (!file.open(filePath)) {
+        clear();
+        error = "Error: Unable to open file " + filePath;
+        return false;
+    }
+
+    return loadBuffer(file.data(), file.size(), error);
+}
+
+bool BitsyArenaGame::loadBuffer(const char* data, size_t size, std::string& error) {
+    clear();
+    arena_.reserve(size + size / 2);  // The arena copy is smaller than the text for typical games
+
+    BitsyArenaBuilder builder(*this);
+    bool ok = BitsyGameParser::parse(data, size, builder, error);
+    builder.finish();
+    return ok;
+}
+
+void BitsyArenaGame::clear() {
+    arena_.reset();
+    title = BitsyStringView();
+    settings = Settings();
+    avatar = ArenaAvatar();
+    palettes = BitsySpan<ArenaPalette>();
+    rooms = BitsySpan<ArenaRoom>();
+    tiles = BitsySpan<ArenaTile>();
+    sprites = BitsySpan<ArenaSprite>();
+    items = BitsySpan<ArenaItem>();
+    dialogues = BitsySpan<ArenaDialogue>();
+    variables = BitsySpan<ArenaVariable>();
+    tunes = BitsySpan<ArenaTune>();
+    blips = BitsySpan<ArenaBlip>();
+    stagedPalettes_.clear();
+    stagedRooms_.clear();
+    stagedTiles_.clear();
+    stagedSprites_.clear();
+    stagedItems_.clear();
+    stagedDialogues_.clear();
+    stagedVariables_.clear();
+    stagedTunes_.clear();
+    stagedBlips_.clear();
+}
+
+const ArenaVariable* BitsyArenaGame::findVariable(BitsyStringView name) const {
+    const ArenaVariable* it = std::lower_bound(variables.begin(), variables.end(), name,
+        [](const ArenaVariable& var, BitsyStringView key) {
+            return std::lexicographical_compare(var.name.begin(), var.name.end(), key.begin(), key.end());
+        });
+    return it != variables.end() && it->name == name ? it : nullptr;
+}
+
+BitsyGameData BitsyArenaGame::toGameData() const {
+    BitsyGameData game;
+    game.title = title.str();
+    game.settings = settings;
+    game.avatar.frames = avatar.frames;
+    game.avatar.roomId = avatar.roomId;
+    game.avatar.position = avatar.position;
+    game.avatar.inventory.assign(avatar.inventory.begin(), avatar.inventory.end());
+
+    for (const ArenaPalette& in : palettes) {
+        Palette out;
+        out.id = in.id;
+        out.color1 = in.color1;
+        out.color2 = in.color2;
+        out.color3 = in.color3;
+        out.name = in.name.str();
+        game.palettes.push_back(out);
+    }
+    for (const ArenaRoom& in : rooms) {
+        Room out;
+        out.id = in.id;
+        out.tiles = in.tiles;
+        out.items.assign(in.items.begin(), in.items.end());
+        for (const ArenaExit& ext : in.exits) {
+            Exit exitOut;
+            exitOut.startPosition = ext.startPosition;
+            exitOut.destinationRoomId = ext.destinationRoomId;
+            exitOut.destinationPosition = ext.destinationPosition;
+            exitOut.effect = ext.effect.str();
+            exitOut.dialogueId = ext.dialogueId;
+            out.exits.push_back(exitOut);
+        }
+        out.endings.assign(in.endings.begin(), in.endings.end());
+        out.paletteId = in.paletteId;
+        out.tuneId = in.tuneId;
+        out.name = in.name.str();
+        game.rooms.push_back(out);
+    }
+    for (const ArenaTile& in : tiles) {
+        Tile out;
+        out.id = in.id;
+        out.frames = in.frames;
+        out.name = in.name.str();
+        out.wall = in.wall;
+        game.tiles.push_back(out);
+    }
+    for (const ArenaSprite& in : sprites) {
+        Sprite out;
+        out.id = in.id;
+        out.frames = in.frames;
+        out.name = in.name.str();
+        out.dialogId = in.dialogId;
+        out.blipId = in.blipId;
+        out.roomId = in.roomId;
+        out.position = in.position;
+        game.sprites.push_back(out);
+    }
+    for (const ArenaItem& in : items) {
+        Item out;
+        out.id = in.id;
+        out.frames = in.frames;
+        out.name = in.name.str();
+        out.dialogId = in.dialogId;
+        out.blipId = in.blipId;
+        game.items.push_back(out);
+    }
+    for (const ArenaDialogue& in : dialogues) {
+        Dialogue out;
+        out.id = in.id;
+        out.text = in.text.str();
+        out.name = in.name.str();
+        game.dialogues.push_back(out);
+    }
+    for (const ArenaVariable& in : variables) {
+        Variable out;
+        out.name = in.name.str();
+        out.value = in.value.str();
+        game.variables[out.name] = out;
+    }
+    for (const ArenaTune& in : tunes) {
+        Tune out;
+        out.id = in.id;
+        for (BitsyStringView pattern : in.treblePatterns) out.treblePatterns.push_back(pattern.str());
+        for (BitsyStringView pattern : in.bassPatterns) out.bassPatterns.push_back(pattern.str());
+        out.key = in.key.str();
+        out.tempo = in.tempo.str();
+        out.trebleInstrument = in.trebleInstrument.str();
+        out.bassInstrument = in.bassInstrument.str();
+        out.arpeggio = in.arpeggio.str();
+        out.name = in.name.str();
+        game.tunes.push_back(out);
+    }
+    for (const ArenaBlip& in : blips) {
+        Blip out;
+        out.id = in.id;
+        out.notes = in.notes.str();
+        out.env.assign(in.env.begin(), in.env.end());
+        out.beat.assign(in.beat.begin(), in.beat.end());
+        out.squareWave = in.squareWave.str();
+        out.repeat = in.repeat;
+        out.name = in.name.str();
+        game.blips.push_back(out);
+    }
+
+    game.buildIndex();
+    return game;
+}
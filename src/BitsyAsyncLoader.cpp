@@ -0,0 +1,204 @@
+#include <BitsyAsyncLoader.h>
+#include <BitsyGameParser.h>
+#include <BitsyGameVisitor.h>
+#include <BitsyJsonString.h>
+#include <BitsyMappedFile.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+
+struct BitsyLoadHandle::State {
+    std::mutex mutex;
+    std::condition_variable finished;
+    BitsyLoadStatus status = kLoadPending;  // Guarded by mutex; set last, after the callback ran
+    BitsyLoadResult result;  // Owned by the worker until status is set
+
+    std::atomic<size_t> bytes{0};
+    std::atomic<size_t> totalBytes{0};
+    std::atomic<size_t> blocks{0};
+    std::atomic<bool> cancelled{false};
+};
+
+namespace {
+
+const char* statusName(BitsyLoadStatus status) {
+    switch (status) {
+        case kLoadPending: return "pending";
+        case kLoadOk: return "ok";
+        case kLoadOpenFailed: return "open_failed";
+        case kLoadParseFailed: return "parse_failed";
+        case kLoadCancelled: return "cancelled";
+        case kLoadCallbackFailed: return "callback_failed";
+    }
+    return "unknown";
+}
+
+// Builds the game like parseGameData while publishing progress after every block
+class BitsyProgressBuilder : public BitsyGameBuilder {
+public:
+    BitsyProgressBuilder(BitsyGameData& game, std::atomic<size_t>& bytes, std::atomic<size_t>& blocks,
+                         const std::atomic<bool>& cancelled)
+        : BitsyGameBuilder(game), bytes_(bytes), blocks_(blocks), cancelled_(cancelled) {}
+
+    bool onBlockEnd(BitsyBlockType type, size_t offset) override {
+        (void)type;
+        offset_ = offset;
+        bytes_.store(offset, std::memory_order_relaxed);
+        blocks_.fetch_add(1, std::memory_order_relaxed);
+        stopped_ = cancelled_.load(std::memory_order_relaxed);
+        return !stopped_;
+    }
+
+    size_t offset() const { return offset_; }  // End of the last finished block
+    bool stopped() const { return stopped_; }
+
+private:
+    std::atomic<size_t>& bytes_;
+    std::atomic<size_t>& blocks_;
+    const std::atomic<bool>& cancelled_;
+    size_t offset_ = 0;
+    bool stopped_ = false;
+};
+
+}  // namespace
+
+std::string BitsyLoadError::toJson() const {
+    std::ostringstream out;
+    out << "{\"status\": \"" << statusName(status) << "\", \"message\": ";
+    bitsyAppendJsonString(out, message);
+    out << ", \"file\": ";
+    bitsyAppendJsonString(out, filePath);
+    out << ", \"offset\": " << offset << ", \"line\": " << line << '}';
+    return out.str();
+}
+
+BitsyLoadProgress BitsyLoadHandle::progress() const {
+    BitsyLoadProgress progress;
+    if (!state_) return progress;
+    progress.bytes = state_->bytes.load(std::memory_order_relaxed);
+    progress.totalBytes = state_->totalBytes.load(std::memory_order_relaxed);
+    progress.blocks = state_->blocks.load(std::memory_order_relaxed);
+    return progress;
+}
+
+BitsyLoadStatus BitsyLoadHandle::status() const {
+    if (!state_) return kLoadPending;
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->status;
+}
+
+void BitsyLoadHandle::cancel() {
+    if (state_) state_->cancelled.store(true, std::memory_order_relaxed);
+}
+
+void BitsyLoadHandle::wait() const {
+    if (!state_) return;
+    std::unique_lock<std::mutex> lock(state_->mutex);
+    state_->finished.wait(lock, [this]() { return state_->status != kLoadPending; });
+}
+
+bool BitsyLoadHandle::waitFor(double seconds) const {
+    if (!state_) return false;
+    std::unique_lock<std::mutex> lock(state_->mutex);
+    return state_->finished.wait_for(lock, std::chrono::duration<double>(seconds),
+                                     [this]() { return state_->status != kLoadPending; });
+}
+
+BitsyLoadResult& BitsyLoadHandle::result() {
+    wait();
+    return state_->result;
+}
+
+BitsyLoadHandle BitsyAsyncLoader::loadFile(const std::string& filePath, const Callback& callback,
+                                           BitsyExecutor& executor) {
+    BitsyLoadHandle handle;
+    handle.state_ = std::make_shared<BitsyLoadHandle::State>();
+    std::shared_ptr<BitsyLoadHandle::State> state = handle.state_;
+    state->result.error.filePath = filePath;
+
+    executor.submit([state, filePath, callback]() {
+        BitsyMappedFile file;
+        if (state->cancelled.load(std::memory_order_relaxed)) {
+            state->result.error.status = kLoadCancelled;
+            state->result.error.message = "Load cancelled";
+        } else if (!file.open(filePath)) {
+            state->result.error.status = kLoadOpenFailed;
+            state->result.error.message = "Error: Unable to open file " + filePath;
+        } else {
+            run(*state, file.data(), file.size());
+        }
+        finish(*state, callback);
+    });
+    return handle;
+}
+
+BitsyLoadHandle BitsyAsyncLoader::loadBuffer(const char* data, size_t size, const Callback& callback,
+                                             BitsyExecutor& executor) {
+    BitsyLoadHandle handle;
+    handle.state_ = std::make_shared<BitsyLoadHandle::State>();
+    std::shared_ptr<BitsyLoadHandle::State> state = handle.state_;
+
+    executor.submit([state, data, size, callback]() {
+        run(*state, data, size);
+        finish(*state, callback);
+    });
+    return handle;
+}
+
+void BitsyAsyncLoader::run(BitsyLoadHandle::State& state, const char* data, size_t size) {
+    BitsyLoadError& error = state.result.error;
+    state.totalBytes.store(size, std::memory_order_relaxed);
+    if (state.cancelled.load(std::memory_order_relaxed)) {
+        error.status = kLoadCancelled;
+        error.message = "Load cancelled";
+        return;
+    }
+
+    BitsyGameData& game = state.result.game;
+    BitsyProgressBuilder builder(game, state.bytes, state.blocks, state.cancelled);
+    std::string message;
+    bool ok;
+    try {
+        ok = BitsyGameParser::parse(data, size, builder, message);
+        game.buildIndex();
+    } catch (const std::exception& e) {  // The parser catches its own errors; this is running out of memory
+        ok = false;
+        message = std::string("Error while loading game: ") + e.what();
+    }
+
+    if (!ok) {
+        error.status = kLoadParseFailed;
+        error.message = message;
+    } else if (builder.stopped()) {
+        error.status = kLoadCancelled;
+        error.message = "Load cancelled";
+    } else {
+        error.status = kLoadOk;
+        state.bytes.store(size, std::memory_order_relaxed);
+        return;
+    }
+    error.offset = builder.offset();
+    error.line = std::count(data, data + error.offset, '\n') + 1;
+}
+
+void BitsyAsyncLoader::finish(BitsyLoadHandle::State& state, const Callback& callback) {
+    // status stays pending while the callback runs, so waiters only see the result afterwards.
+    // An exception from the callback would end the executor thread, so it becomes the error.
+    if (callback) {
+        try {
+            callback(state.result);
+        } catch (const std::exception& e) {
+            state.result.error.status = kLoadCallbackFailed;
+            state.result.error.message = std::string("Error in load callback: ") + e.what();
+        } catch (...) {
+            state.result.error.status = kLoadCallbackFailed;
+            state.result.error.message = "Error in load callback: unknown exception";
+        }
+    }
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.status = state.result.error.status;
+    state.finished.notify_all();
+}
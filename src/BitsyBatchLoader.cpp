@@ -0,0 +1,107 @@
+#include <BitsyBatchLoader.h>
+#include <BitsyGameParser.h>
+#include <BitsyParallel.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <dirent.h>
+#include <exception>
+#include <mutex>
+#include <sys/stat.h>
+#include <thread>
+
+BitsyBatchLoader::BitsyBatchLoader(unsigned threadCount)
+    : threadCount_(threadCount > 0 ? threadCount : bitsyDefaultThreadCount()), maxPending_(4 * threadCount_) {}
+
+size_t BitsyBatchLoader::load(const std::vector<std::string>& filePaths, const Callback& callback) const {
+    // Largest files first so a huge file never starts last and stalls the batch
+    std::vector<size_t> sizes(filePaths.size(), 0);
+    std::vector<size_t> order(filePaths.size());
+    for (size_t i = 0; i < filePaths.size(); ++i) {
+        struct stat st;
+        if (stat(filePaths[i].c_str(), &st) == 0) sizes[i] = static_cast<size_t>(st.st_size);
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&sizes](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+
+    std::mutex mutex;
+    std::condition_variable resultReady, slotFree;
+    std::deque<BitsyBatchResult> finished;
+    size_t remaining = filePaths.size();
+    size_t failures = 0;
+    std::exception_ptr callbackError;
+
+    // The pool runs on its own thread so this thread can deliver results while files are parsed
+    std::thread pool([&]() {
+        bitsyParallelFor(order.size(), threadCount_, [&](unsigned, size_t task) {
+            BitsyBatchResult result;
+            result.index = order[task];
+            result.filePath = filePaths[result.index];
+            result.bytes = sizes[result.index];
+            try {
+                result.ok = BitsyGameParser::parseGameDataMapped(result.filePath, result.game, result.error);
+            } catch (const std::exception& e) {
+                result.ok = false;
+                result.error = std::string("Error while parsing file: ") + e.what();
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            slotFree.wait(lock, [&]() { return finished.size() < maxPending_; });
+            finished.push_back(std::move(result));
+            resultReady.notify_one();
+        });
+    });
+
+    while (remaining > 0) {
+        BitsyBatchResult result;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            resultReady.wait(lock, [&]() { return !finished.empty(); });
+            result = std::move(finished.front());
+            finished.pop_front();
+            slotFree.notify_one();
+        }
+        --remaining;
+        if (!result.ok) ++failures;
+        if (callbackError) continue;  // Keep draining so the workers can finish
+        try {
+            callback(result);
+        } catch (...) {
+            callbackError = std::current_exception();
+        }
+    }
+
+    pool.join();
+    if (callbackError) std::rethrow_exception(callbackError);
+    return failures;
+}
+
+std::vector<std::string> BitsyBatchLoader::listGameFiles(const std::string& directory) {
+    std::vector<std::string> files;
+    std::vector<std::string> pending(1, directory);
+
+    while (!pending.empty()) {
+        std::string dirPath = pending.back();
+        pending.pop_back();
+
+        DIR* dir = opendir(dirPath.c_str());
+        if (!dir) continue;
+        while (struct dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name == "." || name == "..") continue;
+
+            std::string path = dirPath + "/" + name;
+            struct stat st;
+            if (stat(path.c_str(), &st) != 0) continue;
+            if (S_ISDIR(st.st_mode)) {
+                pending.push_back(path);
+            } else if (S_ISREG(st.st_mode) && name.size() > 6 && name.compare(name.size() - 6, 6, ".bitsy") == 0) {
+                files.push_back(path);
+            }
+        }
+        closedir(dir);
+    }
+
+    std::sort(files.begin(), files.end());
+    return files;
+}
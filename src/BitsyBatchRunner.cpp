@@ -0,0 +1,194 @@
+#include <BitsyBatchRunner.h>
+#include <BitsyParallel.h>
+#include <algorithm>
+#include <sstream>
+
+size_t BitsyCoverage::roomsReached() const {
+    size_t reached = 0;
+    for (size_t count : roomInstances) reached += count > 0;
+    return reached;
+}
+
+size_t BitsyCoverage::endingsHit() const {
+    size_t hit = 0;
+    for (size_t count : endingInstances) hit += count > 0;
+    return hit;
+}
+
+std::string BitsyCoverage::toJson() const {
+    std::ostringstream out;
+    out << "{\"instances\": " << instances << ", \"ticks\": " << ticks << ", \"rooms_reached\": " << roomsReached()
+        << ", \"rooms\": " << roomInstances.size() << ", \"endings_hit\": " << endingsHit()
+        << ", \"endings\": " << endingInstances.size() << ", \"ended_instances\": " << endedInstances
+        << ", \"room_instances\": [";
+    for (size_t i = 0; i < roomInstances.size(); ++i) out << (i ? ", " : "") << roomInstances[i];
+    out << "], \"ending_instances\": [";
+    for (size_t i = 0; i < endingInstances.size(); ++i) out << (i ? ", " : "") << endingInstances[i];
+    out << "], \"dialogue_triggers\": {";
+    bool first = true;
+    for (const auto& entry : dialogueTriggers) {
+        out << (first ? "" : ", ") << '"' << entry.first << "\": " << entry.second;
+        first = false;
+    }
+    out << "}}";
+    return out.str();
+}
+
+BitsyBatchRunner::BitsyBatchRunner(const BitsyWorld& world, size_t instances, unsigned threadCount)
+    : world_(world), instances_(instances), threadCount_(threadCount ? threadCount : bitsyDefaultThreadCount()) {
+    reset();
+}
+
+void BitsyBatchRunner::reset() {
+    BitsyPlayState initial = world_.initialState();
+    size_t n = instances_;
+    ticks_ = 0;
+    room_.assign(n, initial.room);
+    x_.assign(n, initial.x);
+    y_.assign(n, initial.y);
+    ended_.assign(n, 0);
+    endDialogueId_.assign(n, -1);
+
+    inventory_.resize(initial.inventory.size() * n);
+    for (size_t slot = 0; slot < initial.inventory.size(); ++slot) {
+        std::fill(inventory_.begin() + slot * n, inventory_.begin() + (slot + 1) * n, initial.inventory[slot]);
+    }
+    takenItems_.assign(initial.takenItems.size() * n, 0);
+    if (scripts_) initial.variables = scripts_->initialVariables();
+    variables_.resize(initial.variables.size() * n);
+    for (size_t var = 0; var < initial.variables.size(); ++var) {
+        std::fill(variables_.begin() + var * n, variables_.begin() + (var + 1) * n, initial.variables[var]);
+    }
+
+    visitedRooms_.assign((world_.rooms().size() + 63) / 64 * n, 0);
+    if (initial.room >= 0) {
+        uint64_t bit = uint64_t(1) << (initial.room & 63);
+        for (size_t i = 0; i < n; ++i) visitedRooms_[(initial.room >> 6) * n + i] |= bit;
+    }
+    random_.assign(n, 0);
+    dialogueTriggers_.clear();
+}
+
+void BitsyBatchRunner::setScripts(const BitsyDialogueScripts* scripts) {
+    scripts_ = scripts;
+    reset();
+}
+
+BitsyStateRef BitsyBatchRunner::ref(size_t i) {
+    BitsyStateRef state = {&room_[i], &x_[i], &y_[i], &ended_[i], &endDialogueId_[i],
+                           inventory_.empty() ? nullptr : &inventory_[i], instances_,
+                           takenItems_.empty() ? nullptr : &takenItems_[i], instances_};
+    return state;
+}
+
+template <typename InputFn>
+void BitsyBatchRunner::runTicks(size_t ticks, const InputFn& input) {
+    // A few ranges per thread so uneven ones (many instances ended early) balance out
+    const size_t kRangesPerThread = 4;
+    size_t ranges = std::min(instances_, static_cast<size_t>(threadCount_) * kRangesPerThread);
+    if (ranges == 0) return;
+    size_t rangeSize = (instances_ + ranges - 1) / ranges;
+    std::vector<std::map<int, size_t>> dialogues(threadCount_);
+
+    bitsyParallelFor(ranges, threadCount_, [&](unsigned worker, size_t range) {
+        size_t begin = range * rangeSize;
+        size_t end = std::min(instances_, begin + rangeSize);
+        std::map<int, size_t>& seen = dialogues[worker];
+        for (size_t t = 0; t < ticks; ++t) {
+            for (size_t i = begin; i < end; ++i) {
+                if (ended_[i]) continue;
+                BitsyStepResult result = world_.step(ref(i), input(t, i));
+                if (result.events & kEventDialogue) {
+                    ++seen[result.dialogueId];
+                    if (scripts_) {
+                        BitsyScriptContext context = {variables_.empty() ? nullptr : &variables_[i], instances_,
+                                                      inventory_.empty() ? nullptr : &inventory_[i], instances_};
+                        scripts_->run(result.dialogueId, context, nullptr);
+                    }
+                }
+                if (result.events & kEventExit) {
+                    int room = room_[i];
+                    visitedRooms_[(room >> 6) * instances_ + i] |= uint64_t(1) << (room & 63);
+                }
+            }
+        }
+    });
+
+    for (const std::map<int, size_t>& seen : dialogues) {
+        for (const auto& entry : seen) dialogueTriggers_[entry.first] += entry.second;
+    }
+    ticks_ += ticks;
+}
+
+void BitsyBatchRunner::run(const BitsyInput* inputs, size_t ticks) {
+    size_t n = instances_;
+    runTicks(ticks, [inputs, n](size_t t, size_t i) { return inputs[t * n + i]; });
+}
+
+void BitsyBatchRunner::runRandom(size_t ticks, uint32_t seed) {
+    for (size_t i = 0; i < instances_; ++i) {
+        uint32_t state = seed ^ static_cast<uint32_t>(i * 2654435761u);
+        random_[i] = state ? state : 1;  // xorshift32 must not start at zero
+    }
+    uint32_t* random = random_.data();
+    runTicks(ticks, [random](size_t, size_t i) {
+        uint32_t x = random[i];
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        random[i] = x;
+        return static_cast<BitsyInput>(kInputUp + (x >> 30));
+    });
+}
+
+BitsyPlayState BitsyBatchRunner::state(size_t i) const {
+    size_t n = instances_;
+    BitsyPlayState state;
+    state.room = room_[i];
+    state.x = x_[i];
+    state.y = y_[i];
+    state.ended = ended_[i];
+    state.endDialogueId = endDialogueId_[i];
+    state.steps = ticks_;
+    for (size_t slot = 0; slot * n < inventory_.size(); ++slot) state.inventory.push_back(inventory_[slot * n + i]);
+    for (size_t word = 0; word * n < takenItems_.size(); ++word) state.takenItems.push_back(takenItems_[word * n + i]);
+    for (size_t var = 0; var * n < variables_.size(); ++var) state.variables.push_back(variables_[var * n + i]);
+    return state;
+}
+
+BitsyCoverage BitsyBatchRunner::coverage() const {
+    const std::vector<BitsyWorld::RoomInfo>& rooms = world_.rooms();
+    size_t n = instances_;
+    BitsyCoverage coverage;
+    coverage.instances = n;
+    coverage.ticks = ticks_;
+    coverage.roomInstances.assign(rooms.size(), 0);
+    coverage.dialogueTriggers = dialogueTriggers_;
+
+    std::vector<size_t> firstEnding(rooms.size());
+    size_t endingCount = 0;
+    for (size_t slot = 0; slot < rooms.size(); ++slot) {
+        firstEnding[slot] = endingCount;
+        endingCount += rooms[slot].endings.size();
+    }
+    coverage.endingInstances.assign(endingCount, 0);
+
+    for (size_t slot = 0; slot < rooms.size(); ++slot) {
+        const uint64_t* words = &visitedRooms_[(slot >> 6) * n];
+        uint64_t bit = uint64_t(1) << (slot & 63);
+        for (size_t i = 0; i < n; ++i) coverage.roomInstances[slot] += (words[i] & bit) != 0;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        if (!ended_[i]) continue;
+        ++coverage.endedInstances;
+        const std::vector<BitsyWorld::PlacedEnd>& endings = rooms[room_[i]].endings;
+        for (size_t e = 0; e < endings.size(); ++e) {
+            if (endings[e].x == x_[i] && endings[e].y == y_[i]) {
+                ++coverage.endingInstances[firstEnding[room_[i]] + e];
+                break;
+            }
+        }
+    }
+    return coverage;
+}
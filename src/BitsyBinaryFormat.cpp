@@ -0,0 +1,497 @@
+#include <BitsyBinaryFormat.h>
+#include <algorithm>
+#include <fstream>
+#include <unordered_map>
+
+namespace {
+
+template <typename T>
+T zeroed() {
+    T record;
+    std::memset(&record, 0, sizeof(T));  // Keep padding bytes deterministic in the output
+    return record;
+}
+
+// Collects records for every section and deduplicates strings while serializing
+struct BinaryBuilder {
+    std::string strings;
+    std::unordered_map<std::string, BitsyBinString> stringRefs;
+    BitsyBinGame game = zeroed<BitsyBinGame>();
+    std::vector<BitsyBinPalette> palettes;
+    std::vector<BitsyBinRoom> rooms;
+    std::vector<BitsyBinRoomItem> roomItems;
+    std::vector<BitsyBinExit> exits;
+    std::vector<BitsyBinEnd> ends;
+    std::vector<BitsyBinTile> tiles;
+    std::vector<BitsyBinSprite> sprites;
+    std::vector<BitsyBinItem> items;
+    std::vector<BitsyBinDialogue> dialogues;
+    std::vector<BitsyBinVariable> variables;
+    std::vector<BitsyBinTune> tunes;
+    std::vector<BitsyBinString> patterns;
+    std::vector<BitsyBinBlip> blips;
+    std::vector<int32_t> ints;
+    std::vector<BitsyBinRoomIndex> roomIndex;
+
+    BitsyBinString addString(const std::string& value) {
+        std::unordered_map<std::string, BitsyBinString>::const_iterator it = stringRefs.find(value);
+        if (it != stringRefs.end()) return it->second;
+        BitsyBinString ref;
+        ref.offset = static_cast<uint32_t>(strings.size());
+        ref.length = static_cast<uint32_t>(value.size());
+        strings += value;
+        stringRefs[value] = ref;
+        return ref;
+    }
+
+    BitsyBinRange addInts(const std::vector<int>& values) {
+        BitsyBinRange range = {static_cast<uint32_t>(ints.size()), static_cast<uint32_t>(values.size())};
+        ints.insert(ints.end(), values.begin(), values.end());
+        return range;
+    }
+
+    BitsyBinRange addPatterns(const std::vector<std::string>& values) {
+        BitsyBinRange range = {static_cast<uint32_t>(patterns.size()), static_cast<uint32_t>(values.size())};
+        for (size_t i = 0; i < values.size(); ++i) patterns.push_back(addString(values[i]));
+        return range;
+    }
+
+    static void copyFrames(const FrameSet& frames, uint64_t* out, uint32_t& count) {
+        for (int i = 0; i < FrameSet::kMaxFrames; ++i) out[i] = i < frames.count ? frames.frames[i].bits : 0;
+        count = frames.count;
+    }
+};
+
+template <typename T>
+void appendSection(std::string& out, BitsyBinHeader& header, BitsyBinSection section, const T* records, size_t count) {
+    out.append((8 - out.size() % 8) % 8, '\0');
+    header.sections[section].offset = static_cast<uint32_t>(out.size());
+    header.sections[section].count = static_cast<uint32_t>(count);
+    header.sections[section].recordSize = sizeof(T);
+    if (count > 0) out.append(reinterpret_cast<const char*>(records), count * sizeof(T));
+}
+
+template <typename T>
+void appendSection(std::string& out, BitsyBinHeader& header, BitsyBinSection section, const std::vector<T>& records) {
+    appendSection(out, header, section, records.empty() ? nullptr : &records[0], records.size());
+}
+
+void toFrames(const uint64_t* frames, uint32_t count, FrameSet& out) {
+    for (uint32_t i = 0; i < count && i < FrameSet::kMaxFrames; ++i) out.push_back(PackedFrame(frames[i]));
+}
+
+}  // namespace
+
+std::string BitsyBinaryWriter::serialize(const BitsyGameData& game) {
+    BinaryBuilder b;
+
+    b.game.title = b.addString(game.title);
+    b.game.settings[0] = game.settings.verMaj;
+    b.game.settings[1] = game.settings.verMin;
+    b.game.settings[2] = game.settings.roomFormat;
+    b.game.settings[3] = game.settings.dlgCompat;
+    b.game.settings[4] = game.settings.txtMode;
+    b.game.avatarRoomId = game.avatar.roomId;
+    b.game.avatarX = game.avatar.position.first;
+    b.game.avatarY = game.avatar.position.second;
+    BinaryBuilder::copyFrames(game.avatar.frames, b.game.avatarFrames, b.game.avatarFrameCount);
+    b.game.avatarInventory = b.addInts(game.avatar.inventory);
+
+    for (const Palette& palette : game.palettes) {
+        BitsyBinPalette record = zeroed<BitsyBinPalette>();
+        record.id = palette.id;
+        record.colors[0] = std::get<0>(palette.color1);
+        record.colors[1] = std::get<1>(palette.color1);
+        record.colors[2] = std::get<2>(palette.color1);
+        record.colors[3] = std::get<0>(palette.color2);
+        record.colors[4] = std::get<1>(palette.color2);
+        record.colors[5] = std::get<2>(palette.color2);
+        record.colors[6] = std::get<0>(palette.color3);
+        record.colors[7] = std::get<1>(palette.color3);
+        record.colors[8] = std::get<2>(palette.color3);
+        record.name = b.addString(palette.name);
+        b.palettes.push_back(record);
+    }
+
+    for (const Room& room : game.rooms) {
+        BitsyBinRoom record = zeroed<BitsyBinRoom>();
+        record.id = room.id;
+        std::memcpy(record.tiles, room.tiles.cells, sizeof(record.tiles));
+        record.paletteId = room.paletteId;
+        record.tuneId = room.tuneId;
+        record.name = b.addString(room.name);
+
+        record.items.first = static_cast<uint32_t>(b.roomItems.size());
+        record.items.count = static_cast<uint32_t>(room.items.size());
+        for (const auto& item : room.items) {
+            BitsyBinRoomItem itemRecord = {item.first, item.second.first, item.second.second};
+            b.roomItems.push_back(itemRecord);
+        }
+
+        record.exits.first = static_cast<uint32_t>(b.exits.size());
+        record.exits.count = static_cast<uint32_t>(room.exits.size());
+        for (const Exit& ext : room.exits) {
+            BitsyBinExit exitRecord = zeroed<BitsyBinExit>();
+            exitRecord.startX = ext.startPosition.first;
+            exitRecord.startY = ext.startPosition.second;
+            exitRecord.destinationRoomId = ext.destinationRoomId;
+            exitRecord.destinationX = ext.destinationPosition.first;
+            exitRecord.destinationY = ext.destinationPosition.second;
+            exitRecord.dialogueId = ext.dialogueId;
+            exitRecord.effect = b.addString(ext.effect);
+            b.exits.push_back(exitRecord);
+        }
+
+        record.endings.first = static_cast<uint32_t>(b.ends.size());
+        record.endings.count = static_cast<uint32_t>(room.endings.size());
+        for (const End& end : room.endings) {
+            BitsyBinEnd endRecord = {end.dialogueId, end.position.first, end.position.second};
+            b.ends.push_back(endRecord);
+        }
+
+        b.rooms.push_back(record);
+    }
+    for (size_t i = 0; i < b.rooms.size(); ++i) {
+        BitsyBinRoomIndex entry = {b.rooms[i].id, static_cast<uint32_t>(i)};
+        b.roomIndex.push_back(entry);
+    }
+    std::stable_sort(b.roomIndex.begin(), b.roomIndex.end(),
+                     [](const BitsyBinRoomIndex& x, const BitsyBinRoomIndex& y) { return x.id < y.id; });
+
+    for (const Tile& tile : game.tiles) {
+        BitsyBinTile record = zeroed<BitsyBinTile>();
+        BinaryBuilder::copyFrames(tile.frames, record.frames, record.frameCount);
+        record.id = tile.id;
+        record.wall = tile.wall ? 1 : 0;
+        record.name = b.addString(tile.name);
+        b.tiles.push_back(record);
+    }
+
+    for (const Sprite& sprite : game.sprites) {
+        BitsyBinSprite record = zeroed<BitsyBinSprite>();
+        BinaryBuilder::copyFrames(sprite.frames, record.frames, record.frameCount);
+        record.id = sprite.id;
+        record.name = b.addString(sprite.name);
+        record.dialogId = sprite.dialogId;
+        record.blipId = sprite.blipId;
+        record.roomId = sprite.roomId;
+        record.x = sprite.position.first;
+        record.y = sprite.position.second;
+        b.sprites.push_back(record);
+    }
+
+    for (const Item& item : game.items) {
+        BitsyBinItem record = zeroed<BitsyBinItem>();
+        BinaryBuilder::copyFrames(item.frames, record.frames, record.frameCount);
+        record.id = item.id;
+        record.name = b.addString(item.name);
+        record.dialogId = item.dialogId;
+        record.blipId = item.blipId;
+        b.items.push_back(record);
+    }
+
+    for (const Dialogue& dlg : game.dialogues) {
+        BitsyBinDialogue record = zeroed<BitsyBinDialogue>();
+        record.id = dlg.id;
+        record.text = b.addString(dlg.text);
+        record.name = b.addString(dlg.name);
+        b.dialogues.push_back(record);
+    }
+
+    for (const auto& entry : game.variables) {
+        BitsyBinVariable record = zeroed<BitsyBinVariable>();
+        record.name = b.addString(entry.first);
+        record.value = b.addString(entry.second.value);
+        b.variables.push_back(record);
+    }
+
+    for (const Tune& tune : game.tunes) {
+        BitsyBinTune record = zeroed<BitsyBinTune>();
+        record.id = tune.id;
+        record.treblePatterns = b.addPatterns(tune.treblePatterns);
+        record.bassPatterns = b.addPatterns(tune.bassPatterns);
+        record.key = b.addString(tune.key);
+        record.tempo = b.addString(tune.tempo);
+        record.trebleInstrument = b.addString(tune.trebleInstrument);
+        record.bassInstrument = b.addString(tune.bassInstrument);
+        record.arpeggio = b.addString(tune.arpeggio);
+        record.name = b.addString(tune.name);
+        b.tunes.push_back(record);
+    }
+
+    for (const Blip& blip : game.blips) {
+        BitsyBinBlip record = zeroed<BitsyBinBlip>();
+        record.id = blip.id;
+        record.notes = b.addString(blip.notes);
+        record.env = b.addInts(blip.env);
+        record.beat = b.addInts(blip.beat);
+        record.squareWave = b.addString(blip.squareWave);
+        record.repeat = blip.repeat;
+        record.name = b.addString(blip.name);
+        b.blips.push_back(record);
+    }
+
+    BitsyBinHeader header = zeroed<BitsyBinHeader>();
+    std::memcpy(header.magic, "BITSYBIN", 8);
+    header.version = BitsyBinHeader::kVersion;
+    header.byteOrder = BitsyBinHeader::kByteOrder;
+    header.sectionCount = kBinSectionCount;
+
+    std::string out(sizeof(BitsyBinHeader), '\0');
+    appendSection(out, header, kBinStrings, b.strings.data(), b.strings.size());
+    appendSection(out, header, kBinGame, &b.game, 1);
+    appendSection(out, header, kBinPalettes, b.palettes);
+    appendSection(out, header, kBinRooms, b.rooms);
+    appendSection(out, header, kBinRoomItems, b.roomItems);
+    appendSection(out, header, kBinExits, b.exits);
+    appendSection(out, header, kBinEnds, b.ends);
+    appendSection(out, header, kBinTiles, b.tiles);
+    appendSection(out, header, kBinSprites, b.sprites);
+    appendSection(out, header, kBinItems, b.items);
+    appendSection(out, header, kBinDialogues, b.dialogues);
+    appendSection(out, header, kBinVariables, b.variables);
+    appendSection(out, header, kBinTunes, b.tunes);
+    appendSection(out, header, kBinPatterns, b.patterns);
+    appendSection(out, header, kBinBlips, b.blips);
+    appendSection(out, header, kBinInts, b.ints);
+    appendSection(out, header, kBinRoomIndex, b.roomIndex);
+    if (out.size() > UINT32_MAX) return std::string();  // Offsets above would have been truncated
+    std::memcpy(&out[0], &header, sizeof(header));
+    return out;
+}
+
+bool BitsyBinaryWriter::writeFile(const BitsyGameData& game, const std::string& filePath) {
+    std::string image = serialize(game);
+    if (image.empty()) return false;
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return false;
+    file.write(image.data(), image.size());
+    return static_cast<bool>(file);
+}
+
+bool BitsyBinaryGame::open(const std::string& filePath) {
+    header_ = nullptr;
+    if (!file_.open(filePath)) return false;
+    data_ = file_.data();
+    size_ = file_.size();
+    return validate();
+}
+
+bool BitsyBinaryGame::openBuffer(const char* data, size_t size) {
+    file_.close();
+    header_ = nullptr;
+    data_ = data;
+    size_ = size;
+    return validate();
+}
+
+bool BitsyBinaryGame::validate() {
+    static const uint32_t kRecordSizes[kBinSectionCount] = {
+        1, sizeof(BitsyBinGame), sizeof(BitsyBinPalette), sizeof(BitsyBinRoom), sizeof(BitsyBinRoomItem),
+        sizeof(BitsyBinExit), sizeof(BitsyBinEnd), sizeof(BitsyBinTile), sizeof(BitsyBinSprite),
+        sizeof(BitsyBinItem), sizeof(BitsyBinDialogue), sizeof(BitsyBinVariable), sizeof(BitsyBinTune),
+        sizeof(BitsyBinString), sizeof(BitsyBinBlip), sizeof(int32_t), sizeof(BitsyBinRoomIndex)};
+
+    if (!data_ || size_ < sizeof(BitsyBinHeader) || reinterpret_cast<uintptr_t>(data_) % 8 != 0) return false;
+    const BitsyBinHeader* header = reinterpret_cast<const BitsyBinHeader*>(data_);
+    if (std::memcmp(header->magic, "BITSYBIN", 8) != 0 || header->version != BitsyBinHeader::kVersion ||
+        header->byteOrder != BitsyBinHeader::kByteOrder || header->sectionCount != kBinSectionCount) {
+        return false;
+    }
+
+    for (int i = 0; i < kBinSectionCount; ++i) {
+        const BitsyBinSectionEntry& section = header->sections[i];
+        if (section.recordSize != kRecordSizes[i] || section.offset % 8 != 0) return false;
+        if (section.offset > size_ || uint64_t(section.count) * section.recordSize > size_ - section.offset) return false;
+    }
+    if (header->sections[kBinGame].count != 1) return false;
+
+    header_ = header;
+    return true;
+}
+
+BitsyStringView BitsyBinaryGame::string(BitsyBinString ref) const {
+    const BitsyBinSectionEntry& strings = header_->sections[kBinStrings];
+    if (ref.offset > strings.count || ref.length > strings.count - ref.offset) return BitsyStringView();
+    return BitsyStringView(data_ + strings.offset + ref.offset, ref.length);
+}
+
+const BitsyBinRoom* BitsyBinaryGame::findRoom(int id) const {
+    size_t indexCount;
+    const BitsyBinRoomIndex* index = records<BitsyBinRoomIndex>(kBinRoomIndex, indexCount);
+    const BitsyBinRoomIndex* it = std::lower_bound(
+        index, index + indexCount, id, [](const BitsyBinRoomIndex& entry, int key) { return entry.id < key; });
+    if (it == index + indexCount || it->id != id || it->room >= count(kBinRooms)) return nullptr;
+    return records<BitsyBinRoom>(kBinRooms) + it->room;
+}
+
+BitsyGameData BitsyBinaryGame::toGameData() const {
+    BitsyGameData game;
+    if (!header_) return game;
+
+    // Ranges are clamped so a corrupt file yields truncated lists instead of reads past the mapping
+    struct Ranges {
+        const BitsyBinaryGame& bin;
+        bool valid(BitsyBinRange range, BitsyBinSection section) const {
+            return range.first <= bin.count(section) && range.count <= bin.count(section) - range.first;
+        }
+        std::vector<int> ints(BitsyBinRange range) const {
+            if (!valid(range, kBinInts)) return std::vector<int>();
+            const int32_t* values = bin.records<int32_t>(kBinInts) + range.first;
+            return std::vector<int>(values, values + range.count);
+        }
+        std::vector<std::string> patterns(BitsyBinRange range) const {
+            std::vector<std::string> values;
+            if (!valid(range, kBinPatterns)) return values;
+            const BitsyBinString* refs = bin.records<BitsyBinString>(kBinPatterns) + range.first;
+            for (uint32_t i = 0; i < range.count; ++i) values.push_back(bin.string(refs[i]).str());
+            return values;
+        }
+    } ranges = {*this};
+
+    const BitsyBinGame& header = this->game();
+    game.title = string(header.title).str();
+    game.settings.verMaj = header.settings[0];
+    game.settings.verMin = header.settings[1];
+    game.settings.roomFormat = header.settings[2];
+    game.settings.dlgCompat = header.settings[3];
+    game.settings.txtMode = header.settings[4];
+    game.avatar.roomId = header.avatarRoomId;
+    game.avatar.position = std::make_pair(header.avatarX, header.avatarY);
+    toFrames(header.avatarFrames, header.avatarFrameCount, game.avatar.frames);
+    game.avatar.inventory = ranges.ints(header.avatarInventory);
+
+    size_t count;
+    const BitsyBinPalette* palettes = records<BitsyBinPalette>(kBinPalettes, count);
+    game.palettes.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        const int32_t* c = palettes[i].colors;
+        game.palettes[i].id = palettes[i].id;
+        game.palettes[i].color1 = std::make_tuple(c[0], c[1], c[2]);
+        game.palettes[i].color2 = std::make_tuple(c[3], c[4], c[5]);
+        game.palettes[i].color3 = std::make_tuple(c[6], c[7], c[8]);
+        game.palettes[i].name = string(palettes[i].name).str();
+    }
+
+    const BitsyBinRoom* rooms = records<BitsyBinRoom>(kBinRooms, count);
+    const BitsyBinRoomItem* roomItems = records<BitsyBinRoomItem>(kBinRoomItems);
+    const BitsyBinExit* exits = records<BitsyBinExit>(kBinExits);
+    const BitsyBinEnd* ends = records<BitsyBinEnd>(kBinEnds);
+    game.rooms.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        const BitsyBinRoom& record = rooms[i];
+        Room& room = game.rooms[i];
+        room.id = record.id;
+        std::memcpy(room.tiles.cells, record.tiles, sizeof(room.tiles.cells));
+        room.paletteId = record.paletteId;
+        room.tuneId = record.tuneId;
+        room.name = string(record.name).str();
+
+        if (ranges.valid(record.items, kBinRoomItems)) {
+            for (uint32_t j = 0; j < record.items.count; ++j) {
+                const BitsyBinRoomItem& item = roomItems[record.items.first + j];
+                room.items.emplace_back(item.id, std::make_pair(item.x, item.y));
+            }
+        }
+        if (ranges.valid(record.exits, kBinExits)) {
+            for (uint32_t j = 0; j < record.exits.count; ++j) {
+                const BitsyBinExit& exitRecord = exits[record.exits.first + j];
+                Exit ext;
+                ext.startPosition = std::make_pair(exitRecord.startX, exitRecord.startY);
+                ext.destinationRoomId = exitRecord.destinationRoomId;
+                ext.destinationPosition = std::make_pair(exitRecord.destinationX, exitRecord.destinationY);
+                ext.effect = string(exitRecord.effect).str();
+                ext.dialogueId = exitRecord.dialogueId;
+                room.exits.push_back(ext);
+            }
+        }
+        if (ranges.valid(record.endings, kBinEnds)) {
+            for (uint32_t j = 0; j < record.endings.count; ++j) {
+                const BitsyBinEnd& endRecord = ends[record.endings.first + j];
+                End end;
+                end.dialogueId = endRecord.dialogueId;
+                end.position = std::make_pair(endRecord.x, endRecord.y);
+                room.endings.push_back(end);
+            }
+        }
+    }
+
+    const BitsyBinTile* tiles = records<BitsyBinTile>(kBinTiles, count);
+    game.tiles.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        toFrames(tiles[i].frames, tiles[i].frameCount, game.tiles[i].frames);
+        game.tiles[i].id = tiles[i].id;
+        game.tiles[i].wall = tiles[i].wall != 0;
+        game.tiles[i].name = string(tiles[i].name).str();
+    }
+
+    const BitsyBinSprite* sprites = records<BitsyBinSprite>(kBinSprites, count);
+    game.sprites.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        Sprite& sprite = game.sprites[i];
+        toFrames(sprites[i].frames, sprites[i].frameCount, sprite.frames);
+        sprite.id = sprites[i].id;
+        sprite.name = string(sprites[i].name).str();
+        sprite.dialogId = sprites[i].dialogId;
+        sprite.blipId = sprites[i].blipId;
+        sprite.roomId = sprites[i].roomId;
+        sprite.position = std::make_pair(sprites[i].x, sprites[i].y);
+    }
+
+    const BitsyBinItem* items = records<BitsyBinItem>(kBinItems, count);
+    game.items.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        toFrames(items[i].frames, items[i].frameCount, game.items[i].frames);
+        game.items[i].id = items[i].id;
+        game.items[i].name = string(items[i].name).str();
+        game.items[i].dialogId = items[i].dialogId;
+        game.items[i].blipId = items[i].blipId;
+    }
+
+    const BitsyBinDialogue* dialogues = records<BitsyBinDialogue>(kBinDialogues, count);
+    game.dialogues.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        game.dialogues[i].id = dialogues[i].id;
+        game.dialogues[i].text = string(dialogues[i].text).str();
+        game.dialogues[i].name = string(dialogues[i].name).str();
+    }
+
+    const BitsyBinVariable* variables = records<BitsyBinVariable>(kBinVariables, count);
+    for (size_t i = 0; i < count; ++i) {
+        Variable var;
+        var.name = string(variables[i].name).str();
+        var.value = string(variables[i].value).str();
+        game.variables[var.name] = var;
+    }
+
+    const BitsyBinTune* tunes = records<BitsyBinTune>(kBinTunes, count);
+    game.tunes.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        Tune& tune = game.tunes[i];
+        tune.id = tunes[i].id;
+        tune.treblePatterns = ranges.patterns(tunes[i].treblePatterns);
+        tune.bassPatterns = ranges.patterns(tunes[i].bassPatterns);
+        tune.key = string(tunes[i].key).str();
+        tune.tempo = string(tunes[i].tempo).str();
+        tune.trebleInstrument = string(tunes[i].trebleInstrument).str();
+        tune.bassInstrument = string(tunes[i].bassInstrument).str();
+        tune.arpeggio = string(tunes[i].arpeggio).str();
+        tune.name = string(tunes[i].name).str();
+    }
+
+    const BitsyBinBlip* blips = records<BitsyBinBlip>(kBinBlips, count);
+    game.blips.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        Blip& blip = game.blips[i];
+        blip.id = blips[i].id;
+        blip.notes = string(blips[i].notes).str();
+        blip.env = ranges.ints(blips[i].env);
+        blip.beat = ranges.ints(blips[i].beat);
+        blip.squareWave = string(blips[i].squareWave).str();
+        blip.repeat = blips[i].repeat;
+        blip.name = string(blips[i].name).str();
+    }
+
+    game.buildIndex();
+    return game;
+}
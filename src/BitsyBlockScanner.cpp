@@ -0,0 +1,69 @@
+#include <BitsyBlockScanner.h>
+#include <BitsyLineCursor.h>
+
+BitsyBlockType BitsyBlockScanner::classify(BitsyStringView line) {
+    // First whitespace-delimited token, as extracted by operator>> in parseGameData
+    const char* p = line.begin();
+    while (p < line.end() && bitsyIsSpace(*p)) ++p;
+    const char* start = p;
+    while (p < line.end() && !bitsyIsSpace(*p)) ++p;
+    BitsyStringView token(start, p - start);
+
+    if (token == "!") return kBlockSettings;
+    if (token == "PAL") return kBlockPalette;
+    if (token == "ROOM") return kBlockRoom;
+    if (token == "TIL") return kBlockTile;
+    if (token == "SPR") return line.contains("A") ? kBlockAvatar : kBlockSprite;
+    if (token == "ITM") return kBlockItem;
+    if (token == "DLG") return kBlockDialogue;
+    if (token == "TUNE") return kBlockTune;
+    if (token == "BLIP") return kBlockBlip;
+    if (token == "VAR") return kBlockVariable;
+    return kBlockOther;
+}
+
+const char* BitsyBlockScanner::typeName(BitsyBlockType type) {
+    switch (type) {
+        case kBlockOther: return "other";
+        case kBlockSettings: return "settings";
+        case kBlockPalette: return "palette";
+        case kBlockRoom: return "room";
+        case kBlockTile: return "tile";
+        case kBlockAvatar: return "avatar";
+        case kBlockSprite: return "sprite";
+        case kBlockItem: return "item";
+        case kBlockDialogue: return "dialogue";
+        case kBlockVariable: return "variable";
+        case kBlockTune: return "tune";
+        case kBlockBlip: return "blip";
+    }
+    return "other";
+}
+
+std::vector<BitsyBlock> BitsyBlockScanner::scan(const char* data, size_t size) {
+    std::vector<BitsyBlock> blocks;
+    BitsyLineCursor cursor(data, data + size);
+    BitsyStringView line;
+    cursor.nextLine(line);  // Title
+
+    BitsyBlock block;
+    bool inBlock = false;
+    size_t lineStart = cursor.offset();
+    while (cursor.nextLine(line)) {
+        if (!inBlock && !line.empty()) {
+            block.type = classify(line);
+            block.offset = lineStart;
+            inBlock = true;
+        } else if (inBlock && line.empty()) {
+            block.length = cursor.offset() - block.offset;
+            blocks.push_back(block);
+            inBlock = false;
+        }
+        lineStart = cursor.offset();
+    }
+    if (inBlock) {
+        block.length = size - block.offset;
+        blocks.push_back(block);
+    }
+    return blocks;
+}
@@ -0,0 +1,585 @@
+#include <BitsyDialogueScripts.h>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <sstream>
+
+namespace {
+
+const int kStackLimit = 32;  // Deepest expression the compiler accepts
+
+const char* const kTagNames[] = {"wvy", "shk", "rbw", "clr1", "clr2", "clr3", "pg"};
+
+uint16_t readU16(const uint8_t* code) {
+    return static_cast<uint16_t>(code[0] | (code[1] << 8));
+}
+
+uint32_t readU32(const uint8_t* code) {
+    return static_cast<uint32_t>(code[0]) | (static_cast<uint32_t>(code[1]) << 8) |
+           (static_cast<uint32_t>(code[2]) << 16) | (static_cast<uint32_t>(code[3]) << 24);
+}
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+bool isIdentifierStart(char c) {
+    return std::isalpha(static_cast<unsigned char>(c)) || c == '_';
+}
+
+bool isIdentifierChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+int variableValue(const std::string& value) {
+    return value == "true" ? 1 : static_cast<int>(std::strtol(value.c_str(), nullptr, 10));
+}
+
+// Offset of the '}' closing the '{' at open, or npos
+size_t matchingBrace(const std::string& text, size_t open, size_t end) {
+    int depth = 0;
+    for (size_t i = open; i < end; ++i) {
+        if (text[i] == '{') {
+            ++depth;
+        } else if (text[i] == '}' && --depth == 0) {
+            return i;
+        }
+    }
+    return std::string::npos;
+}
+
+}  // namespace
+
+// Compiles one dialogue at a time into the code and pool of a BitsyDialogueScripts.
+// Errors are reported by returning false with error_ set; the caller then rolls the
+// block's code back.
+class BitsyScriptCompiler {
+public:
+    BitsyScriptCompiler(BitsyDialogueScripts& scripts, const BitsyGameData& game) : scripts_(scripts), game_(game) {
+        for (size_t v = 0; v < scripts_.variableNames_.size(); ++v) {
+            variables_[scripts_.variableNames_[v]] = static_cast<int>(v);
+        }
+    }
+
+    void compile(const Dialogue& dialogue) {
+        dialogueId_ = dialogue.id;
+        text_ = &dialogue.text;
+        compileText(0, dialogue.text.size());
+        emit(kOpEnd);
+    }
+
+private:
+    void emit(uint8_t byte) { scripts_.code_.push_back(byte); }
+    void emitU16(uint16_t value) {
+        emit(static_cast<uint8_t>(value));
+        emit(static_cast<uint8_t>(value >> 8));
+    }
+    void emitU32(uint32_t value) {
+        for (int shift = 0; shift < 32; shift += 8) emit(static_cast<uint8_t>(value >> shift));
+    }
+    uint32_t here() const { return static_cast<uint32_t>(scripts_.code_.size()); }
+    void patch(uint32_t at, uint32_t value) {
+        for (int i = 0; i < 4; ++i) scripts_.code_[at + i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+
+    void emitText(size_t begin, size_t end) {
+        if (begin == end) return;
+        emit(kOpText);
+        emitU32(static_cast<uint32_t>(scripts_.pool_.size()));
+        emitU32(static_cast<uint32_t>(end - begin));
+        scripts_.pool_.append(*text_, begin, end - begin);
+    }
+
+    // Text runs and {...} blocks in text_[begin, end)
+    void compileText(size_t begin, size_t end) {
+        const std::string& text = *text_;
+        size_t run = begin;
+        for (size_t i = begin; i < end; ++i) {
+            if (text[i] != '{') continue;
+            size_t close = matchingBrace(text, i, end);
+            if (close == std::string::npos) {
+                fail(i, "unclosed {");
+                break;
+            }
+            emitText(run, i);
+            compileBlock(i, close);
+            run = close + 1;
+            i = close;
+        }
+        emitText(run, end);
+    }
+
+    // The block text_[open] == '{' .. text_[close] == '}'
+    void compileBlock(size_t open, size_t close) {
+        size_t codeSize = scripts_.code_.size(), poolSize = scripts_.pool_.size();
+        pos_ = open + 1;
+        end_ = close;
+        depth_ = 0;
+        error_.clear();
+        if (!statement()) {
+            scripts_.code_.resize(codeSize);
+            scripts_.pool_.resize(poolSize);
+            fail(open, error_);
+        }
+    }
+
+    void fail(size_t column, const std::string& message) {
+        BitsyScriptError error = {dialogueId_, column, message};
+        scripts_.errors_.push_back(error);
+    }
+
+    bool error(const std::string& message) {
+        if (error_.empty()) error_ = message;
+        return false;
+    }
+
+    void skipSpace() {
+        while (pos_ < end_ && isSpace((*text_)[pos_])) ++pos_;
+    }
+
+    bool atEnd() {
+        skipSpace();
+        return pos_ >= end_;
+    }
+
+    bool accept(const char* token) {
+        skipSpace();
+        size_t length = std::strlen(token);
+        if (text_->compare(pos_, length, token) != 0 || pos_ + length > end_) return false;
+        pos_ += length;
+        return true;
+    }
+
+    std::string identifier() {
+        skipSpace();
+        size_t start = pos_;
+        if (pos_ < end_ && isIdentifierStart((*text_)[pos_])) {
+            while (pos_ < end_ && isIdentifierChar((*text_)[pos_])) ++pos_;
+        }
+        return text_->substr(start, pos_ - start);
+    }
+
+    int variable(const std::string& name) {
+        std::map<std::string, int>::const_iterator it = variables_.find(name);
+        if (it != variables_.end()) return it->second;
+        int index = static_cast<int>(scripts_.variableNames_.size());
+        scripts_.variableNames_.push_back(name);
+        scripts_.initialVariables_.push_back(0);
+        variables_[name] = index;
+        return index;
+    }
+
+    bool push(int count = 1) {
+        depth_ += count;
+        return depth_ <= kStackLimit || error("expression too deep");
+    }
+
+    bool statement() {
+        skipSpace();
+        if (pos_ < end_ && (*text_)[pos_] == '-') {
+            ++pos_;
+            return conditional();
+        }
+
+        size_t start = pos_;
+        bool closing = accept("/");
+        std::string word = identifier();
+        if (atEnd()) {
+            if (word == "br" && !closing) {
+                emit(kOpText);
+                emitU32(static_cast<uint32_t>(scripts_.pool_.size()));
+                emitU32(1);
+                scripts_.pool_ += '\n';
+                return true;
+            }
+            for (int tag = kTagWavy; tag <= kTagPage; ++tag) {
+                if (word != kTagNames[tag]) continue;
+                emit(kOpTag);
+                emit(static_cast<uint8_t>(tag));
+                emit(closing ? 1 : 0);
+                return true;
+            }
+        }
+        if (closing) return error("unknown tag");
+
+        if (word == "say" || word == "print") {
+            if (!expression() || !atEnd()) return error("expected one expression after " + word);
+            emit(kOpPrint);
+            depth_ = 0;
+            return true;
+        }
+        if (!word.empty() && accept("=") && !accept("=")) {
+            if (!expression() || !atEnd()) return error("expected an expression after =");
+            int index = variable(word);
+            if (index > 0xffff) return error("too many variables");
+            emit(kOpStoreVariable);
+            emitU16(static_cast<uint16_t>(index));
+            depth_ = 0;
+            return true;
+        }
+
+        // Anything else is an expression evaluated for nothing
+        pos_ = start;
+        if (!expression() || !atEnd()) return error("cannot parse block");
+        emit(kOpPop);
+        depth_ = 0;
+        return true;
+    }
+
+    // "- cond ? body - cond ? body - else ? body", after the first '-'
+    bool conditional() {
+        std::vector<uint32_t> toEnd;
+        uint32_t skip = 0;  // Operand of the failed-condition jump to patch, 0 for else branches
+        for (;;) {
+            skip = 0;
+            bool otherwise = false;
+            size_t before = pos_;
+            if (identifier() == "else" && accept("?")) {
+                otherwise = true;
+            } else {
+                pos_ = before;
+                if (!expression() || !accept("?")) return error("expected ? after a condition");
+                depth_ = 0;
+                emit(kOpJumpIfZero);
+                skip = here();
+                emitU32(0);
+            }
+
+            size_t bodyEnd = branchEnd(pos_);
+            size_t blockEnd = end_, next = bodyEnd;
+            size_t begin = pos_, last = bodyEnd;
+            while (begin < last && isSpace((*text_)[begin])) ++begin;
+            while (last > begin && isSpace((*text_)[last - 1])) --last;
+            compileText(begin, last);  // Nested blocks report and roll back their own errors
+            pos_ = next;
+            end_ = blockEnd;
+
+            if (pos_ >= end_ || otherwise) break;
+            emit(kOpJump);
+            toEnd.push_back(here());
+            emitU32(0);
+            patch(skip, here());
+            ++pos_;  // The '-' starting the next branch
+        }
+        if (pos_ < end_ && !atEnd()) return error("text after else branch");
+        if (skip) patch(skip, here());  // No branch matched
+        for (uint32_t at : toEnd) patch(at, here());
+        return true;
+    }
+
+    // End of a branch body starting at begin: the next top-level " - " with a '?' after it
+    size_t branchEnd(size_t begin) {
+        const std::string& text = *text_;
+        int depth = 0;
+        for (size_t i = begin; i < end_; ++i) {
+            char c = text[i];
+            if (c == '{') ++depth;
+            if (c == '}') --depth;
+            if (depth != 0 || c != '-' || (i > begin && !isSpace(text[i - 1])) || i + 1 >= end_ ||
+                !isSpace(text[i + 1])) {
+                continue;
+            }
+            int inner = 0;
+            for (size_t j = i + 1; j < end_; ++j) {
+                if (text[j] == '{') ++inner;
+                if (text[j] == '}') --inner;
+                if (inner == 0 && text[j] == '?') return i;
+            }
+        }
+        return end_;
+    }
+
+    // comparison := sum [op sum]
+    bool expression() {
+        if (!sum()) return false;
+        static const struct {
+            const char* token;
+            BitsyScriptOp op;
+        } kComparisons[] = {{"==", kOpEqual}, {"!=", kOpNotEqual}, {"<=", kOpLessEqual}, {">=", kOpGreaterEqual},
+                            {"<", kOpLess}, {">", kOpGreater}};
+        for (const auto& comparison : kComparisons) {
+            if (!accept(comparison.token)) continue;
+            if (!sum()) return false;
+            emit(comparison.op);
+            --depth_;
+            return true;
+        }
+        return true;
+    }
+
+    bool sum() {
+        if (!product()) return false;
+        for (;;) {
+            BitsyScriptOp op;
+            if (accept("+")) {
+                op = kOpAdd;
+            } else if (accept("-")) {
+                op = kOpSubtract;
+            } else {
+                return true;
+            }
+            if (!product()) return false;
+            emit(op);
+            --depth_;
+        }
+    }
+
+    bool product() {
+        if (!primary()) return false;
+        for (;;) {
+            BitsyScriptOp op;
+            if (accept("*")) {
+                op = kOpMultiply;
+            } else if (accept("/")) {
+                op = kOpDivide;
+            } else {
+                return true;
+            }
+            if (!primary()) return false;
+            emit(op);
+            --depth_;
+        }
+    }
+
+    bool primary() {
+        skipSpace();
+        if (pos_ >= end_) return error("expected a value");
+        char c = (*text_)[pos_];
+        if (c == '(' || c == '{') {
+            char closer = c == '(' ? ')' : '}';
+            ++pos_;
+            size_t before = pos_;
+            if (c == '{' && identifier() == "item") return item() && accept("}") ? true : error("expected }");
+            pos_ = before;
+            if (!expression() || !accept(closer == ')' ? ")" : "}")) return error("unbalanced brackets");
+            return true;
+        }
+        if (c == '-') {
+            ++pos_;
+            emit(kOpPushInt);
+            emitU32(0);
+            if (!push() || !primary()) return false;
+            emit(kOpSubtract);
+            --depth_;
+            return true;
+        }
+        if (std::isdigit(static_cast<unsigned char>(c))) {
+            long value = 0;
+            while (pos_ < end_ && std::isdigit(static_cast<unsigned char>((*text_)[pos_]))) {
+                value = value * 10 + ((*text_)[pos_++] - '0');
+                if (value > 0x7fffffff) return error("number too large");
+            }
+            emit(kOpPushInt);
+            emitU32(static_cast<uint32_t>(value));
+            return push();
+        }
+        std::string word = identifier();
+        if (word.empty()) return error("unexpected character");
+        if (word == "item") return item();
+        if (word == "true" || word == "false") {
+            emit(kOpPushInt);
+            emitU32(word == "true" ? 1 : 0);
+            return push();
+        }
+        int index = variable(word);
+        if (index > 0xffff) return error("too many variables");
+        emit(kOpPushVariable);
+        emitU16(static_cast<uint16_t>(index));
+        return push();
+    }
+
+    // After "item": an item ID or name, quoted or not
+    bool item() {
+        skipSpace();
+        std::string name;
+        if (accept("\"")) {
+            size_t quote = text_->find('"', pos_);
+            if (quote == std::string::npos || quote >= end_) return error("unclosed \"");
+            name = text_->substr(pos_, quote - pos_);
+            pos_ = quote + 1;
+        } else {
+            while (pos_ < end_ && isIdentifierChar((*text_)[pos_])) name += (*text_)[pos_++];
+        }
+
+        const Item* found = nullptr;
+        bool numeric = !name.empty() && name.find_first_not_of("0123456789") == std::string::npos;
+        if (numeric) found = game_.findItem(std::atoi(name.c_str()));
+        for (size_t slot = 0; !found && slot < game_.items.size(); ++slot) {
+            if (game_.items[slot].name == name) found = &game_.items[slot];
+        }
+        if (!found) return error("unknown item \"" + name + "\"");
+        emit(kOpPushItem);
+        emitU16(static_cast<uint16_t>(found - game_.items.data()));
+        return push();
+    }
+
+    BitsyDialogueScripts& scripts_;
+    const BitsyGameData& game_;
+    std::map<std::string, int> variables_;
+    int dialogueId_ = -1;
+    const std::string* text_ = nullptr;
+    size_t pos_ = 0, end_ = 0;  // Cursor and end of the block being compiled
+    int depth_ = 0;  // Stack depth the code emitted so far leaves behind
+    std::string error_;
+};
+
+BitsyDialogueScripts::BitsyDialogueScripts(const BitsyGameData& game) : itemCount_(game.items.size()) {
+    for (const auto& var : game.variables) {
+        variableNames_.push_back(var.first);
+        initialVariables_.push_back(variableValue(var.second.value));
+    }
+    if (game.items.size() > 0x10000) {
+        BitsyScriptError error = {-1, 0, "too many items for item counts"};
+        errors_.push_back(error);
+    }
+
+    BitsyScriptCompiler compiler(*this, game);
+    for (const Dialogue& dialogue : game.dialogues) {
+        Program program = {dialogue.id, static_cast<uint32_t>(code_.size())};
+        programs_.push_back(program);
+        compiler.compile(dialogue);
+    }
+    programIndex_.build(programs_);
+}
+
+int BitsyDialogueScripts::variableIndex(const std::string& name) const {
+    for (size_t v = 0; v < variableNames_.size(); ++v) {
+        if (variableNames_[v] == name) return static_cast<int>(v);
+    }
+    return -1;
+}
+
+bool BitsyDialogueScripts::run(int dialogueId, const BitsyScriptContext& context, BitsyDialogueOutput* output) const {
+    int slot = programIndex_.slot(dialogueId);
+    if (slot < 0) return false;
+
+    const uint8_t* code = code_.data();
+    size_t pc = programs_[slot].start;
+    int stack[kStackLimit];
+    int top = 0;  // Entries in use
+    for (;;) {
+        uint8_t op = code[pc++];
+        switch (op) {
+            case kOpEnd:
+                return true;
+            case kOpText:
+                if (output) output->text.append(pool_, readU32(code + pc), readU32(code + pc + 4));
+                pc += 8;
+                break;
+            case kOpTag:
+                if (output) {
+                    BitsyTextTag tag = {static_cast<BitsyTextTagType>(code[pc]), code[pc + 1] != 0,
+                                        output->text.size()};
+                    output->tags.push_back(tag);
+                }
+                pc += 2;
+                break;
+            case kOpPushInt:
+                stack[top++] = static_cast<int>(readU32(code + pc));
+                pc += 4;
+                break;
+            case kOpPushVariable:
+                stack[top++] = context.variables[readU16(code + pc) * context.variableStride];
+                pc += 2;
+                break;
+            case kOpPushItem:
+                stack[top++] = context.inventory[readU16(code + pc) * context.inventoryStride];
+                pc += 2;
+                break;
+            case kOpStoreVariable:
+                context.variables[readU16(code + pc) * context.variableStride] = stack[--top];
+                pc += 2;
+                break;
+            case kOpPop:
+                --top;
+                break;
+            case kOpPrint:
+                --top;
+                if (output) output->text += std::to_string(stack[top]);
+                break;
+            case kOpJump:
+                pc = readU32(code + pc);
+                break;
+            case kOpJumpIfZero:
+                pc = stack[--top] == 0 ? readU32(code + pc) : pc + 4;
+                break;
+            default: {
+                // Binary operators; unsigned arithmetic so overflow wraps instead of being undefined
+                int b = stack[--top], a = stack[top - 1];
+                unsigned ua = static_cast<unsigned>(a), ub = static_cast<unsigned>(b);
+                int result = 0;
+                switch (op) {
+                    case kOpAdd: result = static_cast<int>(ua + ub); break;
+                    case kOpSubtract: result = static_cast<int>(ua - ub); break;
+                    case kOpMultiply: result = static_cast<int>(ua * ub); break;
+                    case kOpDivide: result = b == 0 || (b == -1 && a == INT32_MIN) ? 0 : a / b; break;
+                    case kOpEqual: result = a == b; break;
+                    case kOpNotEqual: result = a != b; break;
+                    case kOpLess: result = a < b; break;
+                    case kOpGreater: result = a > b; break;
+                    case kOpLessEqual: result = a <= b; break;
+                    case kOpGreaterEqual: result = a >= b; break;
+                }
+                stack[top - 1] = result;
+                break;
+            }
+        }
+    }
+}
+
+bool BitsyDialogueScripts::run(int dialogueId, BitsyPlayState& state, BitsyDialogueOutput* output) const {
+    for (size_t v = state.variables.size(); v < variableNames_.size(); ++v) {
+        state.variables.push_back(initialVariables_[v]);
+    }
+    if (state.inventory.size() < itemCount_) state.inventory.resize(itemCount_, 0);
+    BitsyScriptContext context = {state.variables.data(), 1, state.inventory.data(), 1};
+    return run(dialogueId, context, output);
+}
+
+std::string BitsyDialogueScripts::disassemble(int dialogueId) const {
+    static const char* const kNames[] = {"end", "text", "tag", "push", "load", "item", "store", "pop", "print",
+                                         "add", "sub", "mul", "div", "eq", "ne", "lt", "gt", "le", "ge",
+                                         "jump", "jz"};
+    std::ostringstream out;
+    int slot = programIndex_.slot(dialogueId);
+    if (slot < 0) return std::string();
+
+    const uint8_t* code = code_.data();
+    for (size_t pc = programs_[slot].start;;) {
+        uint8_t op = code[pc];
+        out << pc << ' ' << kNames[op];
+        ++pc;
+        switch (op) {
+            case kOpText:
+                out << " \"" << pool_.substr(readU32(code + pc), readU32(code + pc + 4)) << '"';
+                pc += 8;
+                break;
+            case kOpTag:
+                out << ' ' << (code[pc + 1] ? "/" : "") << kTagNames[code[pc]];
+                pc += 2;
+                break;
+            case kOpPushInt:
+                out << ' ' << static_cast<int>(readU32(code + pc));
+                pc += 4;
+                break;
+            case kOpPushVariable:
+            case kOpStoreVariable:
+                out << ' ' << variableNames_[readU16(code + pc)];
+                pc += 2;
+                break;
+            case kOpPushItem:
+                out << ' ' << readU16(code + pc);
+                pc += 2;
+                break;
+            case kOpJump:
+            case kOpJumpIfZero:
+                out << ' ' << readU32(code + pc);
+                pc += 4;
+                break;
+        }
+        out << '\n';
+        if (op == kOpEnd) break;
+    }
+    return out.str();
+}
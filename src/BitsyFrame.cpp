@@ -0,0 +1,71 @@
+#include <BitsyFrame.h>
+
+PackedFrame PackedFrame::flippedHorizontal() const {
+    // Reverse the bit order inside every byte
+    uint64_t b = bits;
+    b = ((b >> 1) & 0x5555555555555555ULL) | ((b & 0x5555555555555555ULL) << 1);
+    b = ((b >> 2) & 0x3333333333333333ULL) | ((b & 0x3333333333333333ULL) << 2);
+    b = ((b >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((b & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    return PackedFrame(b);
+}
+
+PackedFrame PackedFrame::flippedVertical() const {
+    return PackedFrame(__builtin_bswap64(bits));  // Rows are bytes, so reverse the bytes
+}
+
+PackedFrame PackedFrame::transposed() const {
+    // 8x8 bit-matrix transpose in three delta swaps (Hacker's Delight 7-3)
+    uint64_t b = bits, t;
+    t = (b ^ (b >> 7)) & 0x00AA00AA00AA00AAULL;
+    b = b ^ t ^ (t << 7);
+    t = (b ^ (b >> 14)) & 0x0000CCCC0000CCCCULL;
+    b = b ^ t ^ (t << 14);
+    t = (b ^ (b >> 28)) & 0x00000000F0F0F0F0ULL;
+    b = b ^ t ^ (t << 28);
+    return PackedFrame(b);
+}
+
+PackedFrame PackedFrame::rotatedClockwise() const {
+    return transposed().flippedHorizontal();
+}
+
+PackedFrame PackedFrame::rotatedCounterClockwise() const {
+    return transposed().flippedVertical();
+}
+
+PackedFrame PackedFrame::fromRow(PackedFrame frame, int y, BitsyStringView text) {
+    uint64_t row = 0;
+    for (size_t x = 0; x < 8 && x < text.size; ++x) {
+        if (text.data[x] == '1') row |= uint64_t(1) << x;
+    }
+    frame.bits = (frame.bits & ~(uint64_t(0xFF) << (y * 8))) | (row << (y * 8));
+    return frame;
+}
+
+std::vector<std::string> PackedFrame::toText() const {
+    std::vector<std::string> rows(8, std::string(8, '0'));
+    for (int y = 0; y < 8; ++y) {
+        for (int x = 0; x < 8; ++x) {
+            if (pixel(x, y)) rows[y][x] = '1';
+        }
+    }
+    return rows;
+}
+
+std::vector<std::string> FrameSet::toText() const {
+    std::vector<std::string> rows;
+    rows.reserve(count * 8);
+    for (int i = 0; i < count; ++i) {
+        std::vector<std::string> frameRows = frames[i].toText();
+        rows.insert(rows.end(), frameRows.begin(), frameRows.end());
+    }
+    return rows;
+}
+
+bool operator==(const FrameSet& a, const FrameSet& b) {
+    if (a.count != b.count) return false;
+    for (int i = 0; i < a.count; ++i) {
+        if (a.frames[i] != b.frames[i]) return false;
+    }
+    return true;
+}
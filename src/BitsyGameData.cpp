@@ -1,5 +1,11 @@
 #include <BitsyGameData.h>
+#include <algorithm>
 #include <iostream>
+#include <sstream>
+
+BitsyGameData::BitsyGameData() {
+    buildIndex();
+}
 
 void BitsyGameData::printGameStats() const {
     std::cout << "Game Title: " << title << std::endl;
@@ -14,3 +20,243 @@ void BitsyGameData::printGameStats() const {
     std::cout << "Number of Blips: " << blips.size() << std::endl;
     std::cout << "Number of Variables: " << variables.size() << std::endl;
 }
+
+namespace {
+
+// Heap bytes owned by a string: nothing while it fits the small-string buffer
+size_t heapBytes(const std::string& text) {
+    const char* data = text.data();
+    const char* object = reinterpret_cast<const char*>(&text);
+    bool inline_ = data >= object && data < object + sizeof(text);
+    return inline_ ? 0 : text.capacity() + 1;
+}
+
+template <typename T>
+size_t heapBytes(const std::vector<T>& values) {
+    return values.capacity() * sizeof(T);
+}
+
+size_t heapBytes(const std::vector<std::string>& values) {
+    size_t bytes = values.capacity() * sizeof(std::string);
+    for (const std::string& value : values) bytes += heapBytes(value);
+    return bytes;
+}
+
+}  // namespace
+
+size_t BitsyMemoryFootprint::total() const {
+    return object + title + palettes + rooms + tiles + sprites + avatar + items + dialogues + variables + tunes +
+           blips + index;
+}
+
+std::string BitsyMemoryFootprint::toJson() const {
+    std::ostringstream out;
+    out << "{\"object\": " << object << ", \"title\": " << title << ", \"palettes\": " << palettes
+        << ", \"rooms\": " << rooms << ", \"tiles\": " << tiles << ", \"sprites\": " << sprites
+        << ", \"avatar\": " << avatar << ", \"items\": " << items << ", \"dialogues\": " << dialogues
+        << ", \"variables\": " << variables << ", \"tunes\": " << tunes << ", \"blips\": " << blips
+        << ", \"index\": " << index << ", \"total\": " << total() << "}";
+    return out.str();
+}
+
+BitsyMemoryFootprint BitsyGameData::memoryFootprint() const {
+    // Per-node overhead of std::map: three links and the colour flag, rounded up
+    const size_t kMapNodeOverhead = 4 * sizeof(void*);
+
+    BitsyMemoryFootprint footprint;
+    footprint.object = sizeof(BitsyGameData);
+    footprint.title = heapBytes(title);
+
+    footprint.palettes = heapBytes(palettes);
+    for (const Palette& palette : palettes) footprint.palettes += heapBytes(palette.name);
+
+    footprint.rooms = heapBytes(rooms);
+    for (const Room& room : rooms) {
+        footprint.rooms += heapBytes(room.name) + heapBytes(room.items) + heapBytes(room.exits);
+        footprint.rooms += heapBytes(room.endings);
+        for (const Exit& exit : room.exits) footprint.rooms += heapBytes(exit.effect);
+    }
+
+    footprint.tiles = heapBytes(tiles);
+    for (const Tile& tile : tiles) footprint.tiles += heapBytes(tile.name);
+
+    footprint.sprites = heapBytes(sprites);
+    for (const Sprite& sprite : sprites) footprint.sprites += heapBytes(sprite.name);
+
+    footprint.avatar = heapBytes(avatar.inventory);
+
+    footprint.items = heapBytes(items);
+    for (const Item& item : items) footprint.items += heapBytes(item.name);
+
+    footprint.dialogues = heapBytes(dialogues);
+    for (const Dialogue& dialogue : dialogues) {
+        footprint.dialogues += heapBytes(dialogue.text) + heapBytes(dialogue.name);
+    }
+
+    for (const auto& var : variables) {
+        footprint.variables += sizeof(var) + kMapNodeOverhead + heapBytes(var.first) + heapBytes(var.second.name) +
+                               heapBytes(var.second.value);
+    }
+
+    footprint.tunes = heapBytes(tunes);
+    for (const Tune& tune : tunes) {
+        footprint.tunes += heapBytes(tune.treblePatterns) + heapBytes(tune.bassPatterns) + heapBytes(tune.key) +
+                           heapBytes(tune.tempo) + heapBytes(tune.trebleInstrument) + heapBytes(tune.bassInstrument) +
+                           heapBytes(tune.arpeggio) + heapBytes(tune.name);
+    }
+
+    footprint.blips = heapBytes(blips);
+    for (const Blip& blip : blips) {
+        footprint.blips += heapBytes(blip.notes) + heapBytes(blip.env) + heapBytes(blip.beat) +
+                           heapBytes(blip.squareWave) + heapBytes(blip.name);
+    }
+
+    footprint.index = paletteIndex_.memoryUsage() + roomIndex_.memoryUsage() + itemIndex_.memoryUsage() +
+                      dialogueIndex_.memoryUsage() + tuneIndex_.memoryUsage() + blipIndex_.memoryUsage();
+    return footprint;
+}
+
+size_t BitsyIdIndex::memoryUsage() const {
+    return dense_.capacity() * sizeof(int) + sparse_.capacity() * sizeof(std::pair<int, int>);
+}
+
+void BitsyIdIndex::insert(int id, int slot) {
+    if (id >= 0 && id < kDenseLimit) {
+        if (id >= static_cast<int>(dense_.size())) dense_.resize(id + 1, -1);
+        if (dense_[id] < 0) dense_[id] = slot;
+    } else {
+        sparse_.push_back(std::make_pair(id, slot));
+    }
+}
+
+void BitsyIdIndex::finish() {
+    // Stable sort keeps the first of several entries sharing an ID in front
+    std::stable_sort(sparse_.begin(), sparse_.end(),
+                     [](const std::pair<int, int>& a, const std::pair<int, int>& b) { return a.first < b.first; });
+}
+
+int BitsyIdIndex::sparseSlot(int id) const {
+    std::vector<std::pair<int, int>>::const_iterator it = std::lower_bound(
+        sparse_.begin(), sparse_.end(), id, [](const std::pair<int, int>& entry, int key) { return entry.first < key; });
+    return it != sparse_.end() && it->first == id ? it->second : -1;
+}
+
+void BitsyGameData::buildIndex() {
+    paletteIndex_.build(palettes);
+    roomIndex_.build(rooms);
+    itemIndex_.build(items);
+    dialogueIndex_.build(dialogues);
+    tuneIndex_.build(tunes);
+    blipIndex_.build(blips);
+
+    std::fill(tileSlots_, tileSlots_ + 256, -1);
+    for (size_t slot = tiles.size(); slot-- > 0;) {
+        tileSlots_[static_cast<unsigned char>(tiles[slot].id)] = static_cast<int>(slot);
+    }
+    std::fill(spriteSlots_, spriteSlots_ + 256, -1);
+    for (size_t slot = sprites.size(); slot-- > 0;) {
+        spriteSlots_[static_cast<unsigned char>(sprites[slot].id)] = static_cast<int>(slot);
+    }
+}
+
+const Palette* BitsyGameData::findPalette(int id) const {
+    return entryAt(palettes, paletteIndex_.slot(id));
+}
+
+const Room* BitsyGameData::findRoom(int id) const {
+    return entryAt(rooms, roomIndex_.slot(id));
+}
+
+const Tile* BitsyGameData::findTile(char id) const {
+    return entryAt(tiles, tileSlots_[static_cast<unsigned char>(id)]);
+}
+
+const Sprite* BitsyGameData::findSprite(char id) const {
+    return entryAt(sprites, spriteSlots_[static_cast<unsigned char>(id)]);
+}
+
+const Item* BitsyGameData::findItem(int id) const {
+    return entryAt(items, itemIndex_.slot(id));
+}
+
+const Dialogue* BitsyGameData::findDialogue(int id) const {
+    return entryAt(dialogues, dialogueIndex_.slot(id));
+}
+
+const Tune* BitsyGameData::findTune(int id) const {
+    return entryAt(tunes, tuneIndex_.slot(id));
+}
+
+const Blip* BitsyGameData::findBlip(int id) const {
+    return entryAt(blips, blipIndex_.slot(id));
+}
+
+bool operator==(const Palette& a, const Palette& b) {
+    return a.id == b.id && a.color1 == b.color1 && a.color2 == b.color2 && a.color3 == b.color3 && a.name == b.name;
+}
+
+bool operator==(const RoomGrid& a, const RoomGrid& b) {
+    return std::memcmp(a.cells, b.cells, sizeof(a.cells)) == 0;
+}
+
+bool operator==(const Room& a, const Room& b) {
+    return a.id == b.id && a.tiles == b.tiles && a.items == b.items && a.exits == b.exits &&
+           a.endings == b.endings && a.paletteId == b.paletteId && a.tuneId == b.tuneId && a.name == b.name;
+}
+
+bool operator==(const Tile& a, const Tile& b) {
+    return a.id == b.id && a.frames == b.frames && a.name == b.name && a.wall == b.wall;
+}
+
+bool operator==(const Sprite& a, const Sprite& b) {
+    return a.id == b.id && a.frames == b.frames && a.name == b.name && a.dialogId == b.dialogId &&
+           a.blipId == b.blipId && a.roomId == b.roomId && a.position == b.position;
+}
+
+bool operator==(const Avatar& a, const Avatar& b) {
+    return a.id == b.id && a.frames == b.frames && a.roomId == b.roomId && a.position == b.position &&
+           a.inventory == b.inventory;
+}
+
+bool operator==(const Item& a, const Item& b) {
+    return a.id == b.id && a.frames == b.frames && a.name == b.name && a.dialogId == b.dialogId && a.blipId == b.blipId;
+}
+
+bool operator==(const Exit& a, const Exit& b) {
+    return a.startPosition == b.startPosition && a.destinationRoomId == b.destinationRoomId &&
+           a.destinationPosition == b.destinationPosition && a.effect == b.effect && a.dialogueId == b.dialogueId;
+}
+
+bool operator==(const End& a, const End& b) {
+    return a.dialogueId == b.dialogueId && a.position == b.position;
+}
+
+bool operator==(const Dialogue& a, const Dialogue& b) {
+    return a.id == b.id && a.text == b.text && a.name == b.name;
+}
+
+bool operator==(const Variable& a, const Variable& b) {
+    return a.name == b.name && a.value == b.value;
+}
+
+bool operator==(const Tune& a, const Tune& b) {
+    return a.id == b.id && a.treblePatterns == b.treblePatterns && a.bassPatterns == b.bassPatterns &&
+           a.key == b.key && a.tempo == b.tempo && a.trebleInstrument == b.trebleInstrument &&
+           a.bassInstrument == b.bassInstrument && a.arpeggio == b.arpeggio && a.name == b.name;
+}
+
+bool operator==(const Blip& a, const Blip& b) {
+    return a.id == b.id && a.notes == b.notes && a.env == b.env && a.beat == b.beat &&
+           a.squareWave == b.squareWave && a.repeat == b.repeat && a.name == b.name;
+}
+
+bool operator==(const Settings& a, const Settings& b) {
+    return a.verMaj == b.verMaj && a.verMin == b.verMin && a.roomFormat == b.roomFormat &&
+           a.dlgCompat == b.dlgCompat && a.txtMode == b.txtMode;
+}
+
+bool operator==(const BitsyGameData& a, const BitsyGameData& b) {
+    return a.title == b.title && a.settings == b.settings && a.palettes == b.palettes && a.rooms == b.rooms &&
+           a.tiles == b.tiles && a.sprites == b.sprites && a.avatar == b.avatar && a.items == b.items &&
+           a.dialogues == b.dialogues && a.variables == b.variables && a.tunes == b.tunes && a.blips == b.blips;
+}
@@ -0,0 +1,180 @@
+#include <BitsyGameGenerator.h>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+// xorshift32: tiny, fast and identical on every platform
+struct Random {
+    uint32_t state;
+    explicit Random(uint32_t seed) : state(seed ? seed : 0x9E3779B9u) {}
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    int below(int bound) { return bound > 0 ? static_cast<int>(next() % static_cast<uint32_t>(bound)) : 0; }
+};
+
+const char* const kWords[] = {"cat", "tea", "key", "door", "moon", "garden", "river", "lamp", "owl", "bread",
+                              "stone", "cloud", "tower", "song", "shell", "fern"};
+const int kWordCount = sizeof(kWords) / sizeof(kWords[0]);
+const char* const kNotes[] = {"C", "D", "E", "F", "G", "A", "B", "C#", "F#", "d", "r", "m", "s", "l"};
+const int kNoteCount = sizeof(kNotes) / sizeof(kNotes[0]);
+
+void writeFrame(std::ostringstream& out, Random& random) {
+    for (int y = 0; y < 8; ++y) {
+        uint32_t bits = random.next();
+        for (int x = 0; x < 8; ++x) out << ((bits >> x) & 1 ? '1' : '0');
+        out << '\n';
+    }
+}
+
+void writeFrames(std::ostringstream& out, Random& random) {
+    writeFrame(out, random);
+    if (random.below(2)) {
+        out << ">\n";
+        writeFrame(out, random);
+    }
+}
+
+std::string phrase(Random& random, int words) {
+    std::string text;
+    for (int i = 0; i < words; ++i) {
+        if (i > 0) text += ' ';
+        text += kWords[random.below(kWordCount)];
+    }
+    return text;
+}
+
+std::string pattern(Random& random) {
+    std::string text;
+    for (int step = 0; step < 16; ++step) {
+        if (step > 0) text += ',';
+        if (random.below(3) == 0) {
+            if (random.below(4) == 0) text += static_cast<char>('2' + random.below(3));
+            text += kNotes[random.below(kNoteCount)];
+        } else {
+            text += '0';
+        }
+    }
+    return text;
+}
+
+}  // namespace
+
+char BitsyGameGenerator::tileId(int index) {
+    // Printable characters that cannot be confused with the empty tile, commas or the avatar
+    static const std::string ids = "abcdefghijklmnopqrstuvwxyzBCDEFGHIJKLMNOPQRSTUVWXYZ123456789!#$%&*+-./:;<=>?@^_~";
+    return ids[static_cast<size_t>(index) % ids.size()];
+}
+
+std::string BitsyGameGenerator::generate(const BitsyGeneratorOptions& options) {
+    Random random(options.seed);
+    std::ostringstream out;
+    int dialogueCount = options.dialogues;
+    int tuneCount = options.tunes;
+
+    out << "generated game " << options.seed << "\n\n# BITSY VERSION 8.12\n\n";
+    out << "! VER_MAJ 8\n! VER_MIN 12\n! ROOM_FORMAT 1\n! DLG_COMPAT 0\n! TXT_MODE 0\n\n";
+    out << "PAL 0\n0,82,204\n128,159,255\n255,255,255\nNAME blueprint\n\n";
+
+    for (int r = 0; r < options.rooms; ++r) {
+        out << "ROOM " << r << '\n';
+        for (int y = 0; y < 16; ++y) {
+            for (int x = 0; x < 16; ++x) {
+                if (x > 0) out << ',';
+                bool border = x == 0 || y == 0 || x == 15 || y == 15;
+                if (options.tiles > 0 && (border || random.below(8) == 0)) {
+                    out << tileId(random.below(options.tiles));
+                } else {
+                    out << '0';
+                }
+            }
+            out << '\n';
+        }
+        out << "NAME " << phrase(random, 2) << ' ' << r << '\n';
+        if (options.items > 0) {
+            out << "ITM " << random.below(options.items) << ' ' << 1 + random.below(14) << ',' << 1 + random.below(14)
+                << '\n';
+        }
+        if (options.rooms > 1) {
+            out << "EXT 0," << 1 + random.below(14) << ' ' << (r + 1) % options.rooms << " 14," << 1 + random.below(14)
+                << " FX fade";
+            if (dialogueCount > 0) out << " DLG " << random.below(dialogueCount);
+            out << '\n';
+        }
+        if (r % 8 == 7 && dialogueCount > 0) {
+            out << "END " << random.below(dialogueCount) << ' ' << 1 + random.below(14) << ",1\n";
+        }
+        out << "PAL 0\n";
+        if (tuneCount > 0) out << "TUNE " << 1 + random.below(tuneCount) << '\n';
+        out << '\n';
+    }
+
+    for (int t = 0; t < options.tiles; ++t) {
+        out << "TIL " << tileId(t) << '\n';
+        writeFrames(out, random);
+        out << "NAME " << phrase(random, 1) << ' ' << t << '\n';
+        if (random.below(2)) out << "WAL true\n";
+        out << '\n';
+    }
+
+    out << "SPR A\n";
+    writeFrames(out, random);
+    out << "POS 0 4,4\n\n";
+
+    for (int s = 0; s < options.sprites; ++s) {
+        out << "SPR " << tileId(s) << '\n';
+        writeFrames(out, random);
+        out << "NAME " << phrase(random, 1) << ' ' << s << '\n';
+        if (dialogueCount > 0) out << "DLG " << random.below(dialogueCount) << '\n';
+        if (options.rooms > 0) {
+            out << "POS " << random.below(options.rooms) << ' ' << 1 + random.below(14) << ',' << 1 + random.below(14)
+                << '\n';
+        }
+        if (options.blips > 0) out << "BLIP " << 1 + random.below(options.blips) << '\n';
+        out << '\n';
+    }
+
+    for (int i = 0; i < options.items; ++i) {
+        out << "ITM " << i << '\n';
+        writeFrames(out, random);
+        out << "NAME " << phrase(random, 1) << ' ' << i << '\n';
+        if (dialogueCount > 0) out << "DLG " << random.below(dialogueCount) << '\n';
+        out << '\n';
+    }
+
+    for (int d = 0; d < options.dialogues; ++d) {
+        out << "DLG " << d << '\n' << phrase(random, 4 + random.below(12)) << "\nNAME dialog " << d << "\n\n";
+    }
+
+    for (int v = 0; v < options.variables; ++v) {
+        out << "VAR v" << v << '\n' << random.below(100) << "\n\n";
+    }
+
+    for (int t = 0; t < options.tunes; ++t) {
+        out << "TUNE " << t + 1 << '\n';
+        int bars = 1 + random.below(8);
+        for (int bar = 0; bar < bars; ++bar) {
+            if (bar > 0) out << ">\n";
+            out << pattern(random) << '\n' << pattern(random) << '\n';
+        }
+        out << "NAME " << phrase(random, 2) << "\nKEY C,D,E,F,G,A,B d,r,m,s,l\nTMP MED\nSQR P2 P4\n\n";
+    }
+
+    for (int b = 0; b < options.blips; ++b) {
+        out << "BLIP " << b + 1 << '\n' << kNotes[random.below(7)] << "5,E5,B5\nNAME " << phrase(random, 2) << '\n';
+        out << "ENV 40 99 4 185 138\nBEAT 61 115\nSQR P2\n\n";
+    }
+
+    return out.str();
+}
+
+bool BitsyGameGenerator::writeFile(const BitsyGeneratorOptions& options, const std::string& filePath) {
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return false;
+    file << generate(options);
+    return static_cast<bool>(file);
+}
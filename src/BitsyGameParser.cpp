@@ -1,333 +1,663 @@
 #include <BitsyGameParser.h>
-#include <fstream>
-#include <sstream>
-
-// Helper functions for reading multiple lines and frames
-std::vector<std::string> readLines(std::istream& file, int count) {
-    std::vector<std::string> lines;
-    std::string line;
-    for (int i = 0; i < count; ++i) {
-        if (std::getline(file, line)) {
-            lines.push_back(line);
+#include <BitsyMappedFile.h>
+#include <BitsyBlockScanner.h>
+#include <BitsyParallel.h>
+#include <algorithm>
+#include <chrono>
+
+// Helper functions for reading frames; each frame is eight "0"/"1" rows packed into one word
+bool readFrame(BitsyLineCursor& cursor, PackedFrame& frame) {
+    BitsyStringView line;
+    bool read = false;
+    for (int y = 0; y < 8; ++y) {
+        if (cursor.nextLine(line)) {
+            frame = PackedFrame::fromRow(frame, y, line);
+            read = true;
         }
     }
-    return lines;
+    return read;
 }
 
-std::vector<std::string> readFrames(std::istream& file) {
-    std::vector<std::string> frames = readLines(file, 8);
-    std::string line;
-    if (std::getline(file, line) && line.find(">") != std::string::npos) {
-        std::vector<std::string> secondFrame = readLines(file, 8);
-        frames.insert(frames.end(), secondFrame.begin(), secondFrame.end());
-    } else {
-        file.seekg(-line.size() - 1, std::ios_base::cur);
+FrameSet readFrames(BitsyLineCursor& cursor) {
+    FrameSet frames;
+    PackedFrame frame;
+    if (readFrame(cursor, frame)) frames.push_back(frame);
+    BitsyStringView line;
+    if (cursor.nextLine(line)) {
+        if (line.contains(">")) {
+            PackedFrame secondFrame;
+            if (readFrame(cursor, secondFrame)) frames.push_back(secondFrame);
+        } else {
+            cursor.unreadLine();
+        }
     }
     return frames;
 }
 
+namespace {
+
+// Lines in [begin, end), counting an unterminated last line
+size_t countLines(const char* begin, const char* end) {
+    size_t lines = std::count(begin, end, '\n');
+    return begin < end && end[-1] != '\n' ? lines + 1 : lines;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Records one top-level block into BitsyParseStats; does nothing when stats is null
+class BlockRecorder {
+public:
+    BlockRecorder(BitsyParseStats* stats, BitsyBlockType type, const char* start)
+        : stats_(stats), type_(type), start_(start), allocations_(0) {
+        if (!stats_) return;
+        if (stats_->allocationCounter) allocations_ = stats_->allocationCounter();
+        time_ = std::chrono::steady_clock::now();
+    }
+
+    void finish(const char* end, bool skipped) {
+        if (!stats_) return;
+        BitsyParseStats::Section& section = stats_->sections[type_];
+        size_t lines = countLines(start_, end);
+        section.seconds += secondsSince(time_);
+        section.bytes += end - start_;
+        section.lines += lines;
+        ++(skipped ? section.skippedBlocks : section.blocks);
+        if (stats_->allocationCounter) section.allocations += stats_->allocationCounter() - allocations_;
+        stats_->lines += lines;
+    }
+
+private:
+    BitsyParseStats* stats_;
+    BitsyBlockType type_;
+    const char* start_;
+    uint64_t allocations_;
+    std::chrono::steady_clock::time_point time_;
+};
+
+// Tally a line outside any block
+void recordOtherLine(BitsyParseStats& stats, BitsyStringView line) {
+    ++stats.lines;
+    if (line.empty()) {
+        ++stats.blankLines;
+    } else if (line[0] == '#') {
+        ++stats.commentLines;
+    } else {
+        ++stats.unrecognizedLines;
+        if (stats.unrecognizedSamples.size() < BitsyParseStats::kMaxSamples) {
+            BitsyParseStats::LineSample sample;
+            sample.line = stats.lines;
+            sample.text = line.str();
+            stats.unrecognizedSamples.push_back(sample);
+        }
+    }
+}
+
+// Reset stats and record a failure that happened before parsing started
+void recordOpenFailure(BitsyParseStats* stats, const std::string& error) {
+    if (!stats) return;
+    stats->reset();
+    stats->ok = false;
+    stats->error = error;
+}
+
+}  // namespace
+
 BitsyGameData BitsyGameParser::parseGameData(const std::string& filePath) {
+    return parseGameDataMapped(filePath);
+}
+
+BitsyGameData BitsyGameParser::parseGameDataMapped(const std::string& filePath) {
     BitsyGameData gameData;
-    std::ifstream file(filePath);
+    std::string error;
+    if (!parseGameDataMapped(filePath, gameData, error)) {
+        std::cerr << error << std::endl;
+    }
+    return gameData;
+}
 
-    if (!file.is_open()) {
+BitsyGameData BitsyGameParser::parseGameBuffer(const char* data, size_t size) {
+    BitsyGameData gameData;
+    std::string error;
+    if (!parseGameBuffer(data, size, gameData, error)) {
+        std::cerr << error << std::endl;
+    }
+    return gameData;
+}
+
+bool BitsyGameParser::parseGameDataMapped(const std::string& filePath, BitsyGameData& gameData, std::string& error,
+                                          BitsyParseStats* stats) {
+    BitsyMappedFile file;
+
+    if (!file.open(filePath)) {
+        gameData = BitsyGameData();
+        error = "Error: Unable to open file " + filePath;
+        recordOpenFailure(stats, error);
+        return false;
+    }
+
+    return parseGameBuffer(file.data(), file.size(), gameData, error, stats);
+}
+
+bool BitsyGameParser::parseGameBuffer(const char* data, size_t size, BitsyGameData& gameData, std::string& error,
+                                      BitsyParseStats* stats) {
+    gameData = BitsyGameData();
+    BitsyGameBuilder builder(gameData);
+    bool ok = parse(data, size, builder, error, stats);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    gameData.buildIndex();
+    if (stats) stats->indexSeconds = secondsSince(start);
+    return ok;
+}
+
+BitsyGameData BitsyGameParser::parseGameDataParallel(const std::string& filePath, unsigned threadCount) {
+    BitsyGameData gameData;
+    BitsyMappedFile file;
+
+    if (!file.open(filePath)) {
         std::cerr << "Error: Unable to open file " << filePath << std::endl;
         return gameData;
     }
 
-    std::string line;
-    try {
-        if (std::getline(file, line)) {
-            parseGameTitle(gameData, line);
+    std::string error;
+    if (!parseGameBufferParallel(file.data(), file.size(), gameData, error, threadCount)) {
+        std::cerr << error << std::endl;
+    }
+    return gameData;
+}
+
+bool BitsyGameParser::parseGameBufferParallel(const char* data, size_t size, BitsyGameData& gameData,
+                                              std::string& error, unsigned threadCount) {
+    const size_t kMinChunkBytes = 64 * 1024;  // Below this, splitting costs more than it saves
+    if (threadCount == 0) threadCount = bitsyDefaultThreadCount();
+    if (threadCount == 1 || size < 2 * kMinChunkBytes) {
+        return parseGameBuffer(data, size, gameData, error);
+    }
+
+    // Group consecutive blocks into chunks of roughly equal size. Settings and avatar blocks
+    // assign fields instead of appending, so they get chunks of their own that are applied
+    // in file order during the merge.
+    struct Chunk {
+        size_t begin, end;  // Byte range
+        bool serial;  // Parsed straight into gameData while merging
+        BitsyGameData part;
+        std::string error;
+    };
+    std::vector<BitsyBlock> blocks = BitsyBlockScanner::scan(data, size);
+    size_t chunkBytes = std::max(kMinChunkBytes, size / (4 * threadCount));
+    std::vector<Chunk> chunks;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        const BitsyBlock& block = blocks[i];
+        bool serial = block.type == kBlockSettings || block.type == kBlockAvatar;
+        if (chunks.empty() || serial || chunks.back().serial || chunks.back().end - chunks.back().begin >= chunkBytes) {
+            Chunk chunk;
+            chunk.begin = block.offset;
+            chunk.serial = serial;
+            chunks.push_back(chunk);
         }
+        chunks.back().end = block.offset + block.length;
+    }
 
-        while (std::getline(file, line)) {
-            std::stringstream ss(line);
-            std::string token;
-            ss >> token;
-
-            if (token == "!") {
-                parseSettings(gameData, line);
-            } else if (token == "PAL") {
-                parsePalette(gameData, file, line);
-            } else if (token == "ROOM") {
-                parseRoom(gameData, file, line);
-            } else if (token == "TIL") {
-                parseTile(gameData, file, line);
-            } else if (token == "SPR" && line.find("A") != std::string::npos) {
-                parseAvatar(gameData, file, line);
-            } else if (token == "SPR") {
-                parseSprite(gameData, file, line);
-            } else if (token == "ITM") {
-                parseItem(gameData, file, line);
-            } else if (token == "DLG") {
-                parseDialogue(gameData, file, line);
-            } else if (token == "TUNE") {
-                parseTune(gameData, file, line);
-            } else if (token == "BLIP") {
-                parseBlip(gameData, file, line);
-            } else if (token == "VAR") {
-                parseVariable(gameData, file, line);
-            }
+    // Parse one chunk's lines into a game, keeping the error message if it fails
+    auto parseChunk = [data](Chunk& chunk, BitsyGameData& target) {
+        BitsyLineCursor cursor(data + chunk.begin, data + chunk.end);
+        BitsyGameBuilder builder(target);
+        try {
+            parseLines(cursor, builder);
+        } catch (const std::exception& e) {
+            chunk.error = std::string("Error while parsing file: ") + e.what();
+        }
+    };
+
+    bitsyParallelFor(chunks.size(), threadCount, [&](unsigned, size_t index) {
+        if (!chunks[index].serial) parseChunk(chunks[index], chunks[index].part);
+    });
+
+    // Merge in file order; like the sequential parse, stop after the first chunk that failed
+    gameData = BitsyGameData();
+    BitsyLineCursor titleCursor(data, data + size);
+    BitsyStringView line;
+    if (titleCursor.nextLine(line)) {
+        gameData.title = line.str();
+    }
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        Chunk& chunk = chunks[i];
+        if (chunk.serial) {
+            parseChunk(chunk, gameData);
+        } else {
+            BitsyGameData& part = chunk.part;
+            gameData.palettes.insert(gameData.palettes.end(), part.palettes.begin(), part.palettes.end());
+            gameData.rooms.insert(gameData.rooms.end(), part.rooms.begin(), part.rooms.end());
+            gameData.tiles.insert(gameData.tiles.end(), part.tiles.begin(), part.tiles.end());
+            gameData.sprites.insert(gameData.sprites.end(), part.sprites.begin(), part.sprites.end());
+            gameData.items.insert(gameData.items.end(), part.items.begin(), part.items.end());
+            gameData.dialogues.insert(gameData.dialogues.end(), part.dialogues.begin(), part.dialogues.end());
+            gameData.tunes.insert(gameData.tunes.end(), part.tunes.begin(), part.tunes.end());
+            gameData.blips.insert(gameData.blips.end(), part.blips.begin(), part.blips.end());
+            for (const auto& var : part.variables) gameData.variables[var.first] = var.second;
+            part = BitsyGameData();
+        }
+        if (!chunk.error.empty()) {
+            error = chunk.error;
+            gameData.buildIndex();
+            return false;
+        }
+    }
+
+    gameData.buildIndex();
+    return true;
+}
+
+bool BitsyGameParser::parse(const char* data, size_t size, BitsyGameVisitor& visitor, std::string& error,
+                            BitsyParseStats* stats) {
+    BitsyLineCursor cursor(data, data + size);
+    std::chrono::steady_clock::time_point start;
+    uint64_t allocations = 0;
+    if (stats) {
+        stats->reset();
+        start = std::chrono::steady_clock::now();
+        if (stats->allocationCounter) allocations = stats->allocationCounter();
+    }
+
+    bool ok = true;
+    BitsyStringView line;
+    try {
+        if (cursor.nextLine(line)) {
+            if (stats) ++stats->lines;
+            if (visitor.onTitle(line)) parseLines(cursor, visitor, stats);
         }
     } catch (const std::exception& e) {
-        std::cerr << "Error while parsing file: " << e.what() << std::endl;
+        error = std::string("Error while parsing file: ") + e.what();
+        ok = false;
     }
 
-    file.close();
-    return gameData;
+    if (stats) {
+        stats->totalSeconds = secondsSince(start);
+        stats->bytes = cursor.offset();
+        if (stats->allocationCounter) stats->allocations = stats->allocationCounter() - allocations;
+        if (!ok) {
+            stats->ok = false;
+            stats->error = error;
+            stats->errorLine = countLines(data, cursor.position());
+        }
+    }
+    return ok;
 }
 
-void BitsyGameParser::parseGameTitle(BitsyGameData& gameData, const std::string& line) {
-    gameData.title = line;
+bool BitsyGameParser::parseFile(const std::string& filePath, BitsyGameVisitor& visitor, std::string& error,
+                                BitsyParseStats* stats) {
+    BitsyMappedFile file;
+
+    if (!file.open(filePath)) {
+        error = "Error: Unable to open file " + filePath;
+        recordOpenFailure(stats, error);
+        return false;
+    }
+
+    return parse(file.data(), file.size(), visitor, error, stats);
+}
+
+bool BitsyGameParser::parseBlocks(const char* data, size_t size, BitsyGameVisitor& visitor, std::string& error) {
+    BitsyLineCursor cursor(data, data + size);
+    try {
+        parseLines(cursor, visitor);
+    } catch (const std::exception& e) {
+        error = std::string("Error while parsing file: ") + e.what();
+        return false;
+    }
+    return true;
+}
+
+bool BitsyGameParser::parseLines(BitsyLineCursor& cursor, BitsyGameVisitor& visitor, BitsyParseStats* stats) {
+    BitsyStringView line;
+    while (cursor.nextLine(line)) {
+        BitsyBlockType type = BitsyBlockScanner::classify(line);
+        if (type == kBlockOther) {
+            if (stats) recordOtherLine(*stats, line);
+            continue;
+        }
+        BlockRecorder recorder(stats, type, line.begin());
+        if (!visitor.wants(type)) {
+            if (type != kBlockSettings) skipBlock(cursor);  // Settings are single lines
+            recorder.finish(cursor.position(), true);
+            if (!visitor.onBlockEnd(type, cursor.offset())) return false;
+            continue;
+        }
+
+        bool keepGoing = true;
+        switch (type) {
+            case kBlockSettings: keepGoing = parseSettings(visitor, line); break;
+            case kBlockPalette: {
+                Palette palette = parsePalette(cursor, line);
+                keepGoing = visitor.onPalette(palette);
+                break;
+            }
+            case kBlockRoom: {
+                Room room = parseRoom(cursor, line);
+                for (size_t i = 0; keepGoing && i < room.exits.size(); ++i) {
+                    keepGoing = visitor.onExit(room, room.exits[i]);
+                }
+                for (size_t i = 0; keepGoing && i < room.endings.size(); ++i) {
+                    keepGoing = visitor.onEnding(room, room.endings[i]);
+                }
+                keepGoing = keepGoing && visitor.onRoom(room);
+                break;
+            }
+            case kBlockTile: {
+                Tile tile = parseTile(cursor, line);
+                keepGoing = visitor.onTile(tile);
+                break;
+            }
+            case kBlockAvatar: {
+                Avatar avatar = parseAvatar(cursor, line);
+                keepGoing = visitor.onAvatar(avatar);
+                break;
+            }
+            case kBlockSprite: {
+                Sprite sprite = parseSprite(cursor, line);
+                keepGoing = visitor.onSprite(sprite);
+                break;
+            }
+            case kBlockItem: {
+                Item item = parseItem(cursor, line);
+                keepGoing = visitor.onItem(item);
+                break;
+            }
+            case kBlockDialogue: {
+                Dialogue dialogue = parseDialogue(cursor, line);
+                keepGoing = visitor.onDialogue(dialogue);
+                break;
+            }
+            case kBlockVariable: {
+                Variable variable = parseVariable(cursor, line);
+                keepGoing = visitor.onVariable(variable);
+                break;
+            }
+            case kBlockTune: {
+                Tune tune = parseTune(cursor, line);
+                keepGoing = visitor.onTune(tune);
+                break;
+            }
+            case kBlockBlip: {
+                Blip blip = parseBlip(cursor, line);
+                keepGoing = visitor.onBlip(blip);
+                break;
+            }
+            case kBlockOther: break;
+        }
+        recorder.finish(cursor.position(), false);
+        if (!keepGoing || !visitor.onBlockEnd(type, cursor.offset())) return false;
+    }
+    return true;
 }
 
-void BitsyGameParser::parseSettings(BitsyGameData& gameData, const std::string& line) {
-    std::stringstream ss(line);
-    std::string key;
-    int value;
-    ss >> key >> key >> value;
-
-    if (key == "VER_MAJ") gameData.settings.verMaj = value;
-    else if (key == "VER_MIN") gameData.settings.verMin = value;
-    else if (key == "ROOM_FORMAT") gameData.settings.roomFormat = value;
-    else if (key == "DLG_COMPAT") gameData.settings.dlgCompat = value;
-    else if (key == "TXT_MODE") gameData.settings.txtMode = value;
+bool BitsyGameParser::parseSettings(BitsyGameVisitor& visitor, BitsyStringView line) {
+    BitsyFieldScanner scanner(line);
+    BitsyStringView bang, key;
+    int value = 0;
+    if (!scanner.word(bang) || !scanner.word(key)) return true;
+    scanner.integer(value);
+
+    return visitor.onSetting(key, value);
 }
 
-void BitsyGameParser::parsePalette(BitsyGameData& gameData, std::istream& file, const std::string& firstLine) {
+Palette BitsyGameParser::parsePalette(BitsyLineCursor& cursor, BitsyStringView firstLine) {
     Palette palette;
-    palette.id = std::stoi(firstLine.substr(4));  // Extract palette ID
+    palette.id = bitsyParseInt(firstLine.substr(4));  // Extract palette ID
 
-    int r, g, b;
+    int r = 0, g = 0, b = 0;
+    BitsyStringView line;
     for (int i = 0; i < 3; ++i) {
-        std::string line;
-        std::getline(file, line);
-        sscanf(line.c_str(), "%d,%d,%d", &r, &g, &b);
+        cursor.nextLine(line);
+        BitsyFieldScanner scanner(line);
+        scanner.integer(r) && scanner.literal(",") && scanner.integer(g) && scanner.literal(",") && scanner.integer(b);
         if (i == 0) palette.color1 = std::make_tuple(r, g, b);
         else if (i == 1) palette.color2 = std::make_tuple(r, g, b);
         else palette.color3 = std::make_tuple(r, g, b);
     }
 
-    std::string nameLine;
-    std::getline(file, nameLine);
-    if (nameLine.find("NAME") != std::string::npos) {
-        palette.name = nameLine.substr(5);
+    cursor.nextLine(line);
+    if (line.contains("NAME")) {
+        palette.name = line.substr(5).str();
     }
 
-    gameData.palettes.push_back(palette);
+    return palette;
 }
 
-void BitsyGameParser::parseRoom(BitsyGameData& gameData, std::istream& file, const std::string& firstLine) {
+Room BitsyGameParser::parseRoom(BitsyLineCursor& cursor, BitsyStringView firstLine) {
     Room room;
-    room.id = std::stoi(firstLine.substr(5));  // Extract room ID
+    room.id = bitsyParseInt(firstLine.substr(5));  // Extract room ID
 
-    for (int i = 0; i < 16; ++i) {
-        std::string line;
-        std::getline(file, line);
-        std::vector<char> row;
+    BitsyStringView line;
+    for (int y = 0; y < RoomGrid::kSize; ++y) {
+        cursor.nextLine(line);
+        char* row = room.tiles[y];
 
+        int x = 0;
         for (char c : line) {
-            if (c != ',') row.push_back(c);
+            if (c != ',' && x < RoomGrid::kSize) row[x++] = c;
         }
-
-        room.tiles.push_back(row);
     }
 
-    std::string line;
-    while (std::getline(file, line) && !line.empty()) {
-        if (line.find("NAME") != std::string::npos) {
-            room.name = line.substr(5);  // Extract room name
-        } else if (line.find("ITM") != std::string::npos) {
-            int itemId, x, y;
-            sscanf(line.c_str(), "ITM %d %d,%d", &itemId, &x, &y);
+    while (cursor.nextLine(line) && !line.empty()) {
+        if (line.contains("NAME")) {
+            room.name = line.substr(5).str();  // Extract room name
+        } else if (line.contains("ITM")) {
+            int itemId = 0, x = 0, y = 0;
+            BitsyFieldScanner scanner(line);
+            scanner.literal("ITM") && scanner.integer(itemId) && scanner.space() && scanner.integer(x) &&
+                scanner.literal(",") && scanner.integer(y);
             room.items.emplace_back(itemId, std::make_pair(x, y));
-        } else if (line.find("EXT") != std::string::npos) {
+        } else if (line.contains("EXT")) {
             Exit ext;
-            char effect[64] = {0};
-            sscanf(line.c_str(), "EXT %d,%d %d %d,%d FX %s DLG %d",
-                   &ext.startPosition.first, &ext.startPosition.second,
-                   &ext.destinationRoomId, &ext.destinationPosition.first,
-                   &ext.destinationPosition.second, effect, &ext.dialogueId);
-            ext.effect = effect;
+            BitsyStringView effect;
+            BitsyFieldScanner scanner(line);
+            scanner.literal("EXT") && scanner.integer(ext.startPosition.first) && scanner.literal(",") &&
+                scanner.integer(ext.startPosition.second) && scanner.integer(ext.destinationRoomId) &&
+                scanner.integer(ext.destinationPosition.first) && scanner.literal(",") &&
+                scanner.integer(ext.destinationPosition.second) && scanner.space() && scanner.literal("FX") &&
+                scanner.word(effect) && scanner.space() && scanner.literal("DLG") && scanner.integer(ext.dialogueId);
+            ext.effect = effect.str();
             room.exits.push_back(ext);
-        } else if (line.find("END") != std::string::npos) {
+        } else if (line.contains("END")) {
             End end;
-            sscanf(line.c_str(), "END %d %d,%d", &end.dialogueId, &end.position.first, &end.position.second);
+            BitsyFieldScanner scanner(line);
+            scanner.literal("END") && scanner.integer(end.dialogueId) && scanner.integer(end.position.first) &&
+                scanner.literal(",") && scanner.integer(end.position.second);
             room.endings.push_back(end);
-        } else if (line.find("PAL") != std::string::npos) {
-            room.paletteId = std::stoi(line.substr(4));
-        } else if (line.find("TUNE") != std::string::npos) {
-            room.tuneId = std::stoi(line.substr(5));
+        } else if (line.contains("PAL")) {
+            room.paletteId = bitsyParseInt(line.substr(4));
+        } else if (line.contains("TUNE")) {
+            room.tuneId = bitsyParseInt(line.substr(5));
         }
     }
 
-    gameData.rooms.push_back(room);
+    return room;
 }
 
-void BitsyGameParser::parseTile(BitsyGameData& gameData, std::istream& file, const std::string& firstLine) {
+Tile BitsyGameParser::parseTile(BitsyLineCursor& cursor, BitsyStringView firstLine) {
     Tile tile;
     tile.id = firstLine[4];
-    tile.frames = readFrames(file);  // Read frames
-
-    std::string line;
-    std::getline(file, line);
-    if (line.find("NAME") != std::string::npos) {
-        tile.name = line.substr(5);  // Extract tile name
+    tile.frames = readFrames(cursor);  // Read frames
+
+    BitsyStringView line;
+    while (cursor.nextLine(line) && !line.empty()) {
+        if (line.contains("NAME")) {
+            tile.name = line.substr(5).str();  // Extract tile name
+        } else if (line.contains("WAL")) {
+            tile.wall = true;  // Wall property
+        }
     }
 
-    std::getline(file, line);
-    tile.wall = (line.find("WAL") != std::string::npos);
-
-    gameData.tiles.push_back(tile);
+    return tile;
 }
 
-void BitsyGameParser::parseAvatar(BitsyGameData& gameData, std::istream& file, const std::string& firstLine) {
+Avatar BitsyGameParser::parseAvatar(BitsyLineCursor& cursor, BitsyStringView firstLine) {
     Avatar avatar;
     avatar.id = 'A';  // Avatar always has the ID 'A'
-    avatar.frames = readFrames(file);  // Read frames
-
-    std::string line;
-    std::getline(file, line);
-    sscanf(line.c_str(), "POS %d %d,%d", &avatar.roomId, &avatar.position.first, &avatar.position.second);
-
-    while (std::getline(file, line) && !line.empty()) {
-        if (line.find("ITM") != std::string::npos) {
-            int itemId;
-            sscanf(line.c_str(), "ITM %d", &itemId);
+    avatar.frames = readFrames(cursor);  // Read frames
+
+    BitsyStringView line;
+    cursor.nextLine(line);
+    BitsyFieldScanner pos(line);
+    pos.literal("POS") && pos.integer(avatar.roomId) && pos.integer(avatar.position.first) && pos.literal(",") &&
+        pos.integer(avatar.position.second);
+
+    while (cursor.nextLine(line) && !line.empty()) {
+        if (line.contains("ITM")) {
+            int itemId = 0;
+            BitsyFieldScanner scanner(line);
+            scanner.literal("ITM") && scanner.integer(itemId);
             avatar.inventory.push_back(itemId);
         }
     }
 
-    gameData.avatar = avatar;
+    return avatar;
 }
 
-void BitsyGameParser::parseSprite(BitsyGameData& gameData, std::istream& file, const std::string& firstLine) {
+Sprite BitsyGameParser::parseSprite(BitsyLineCursor& cursor, BitsyStringView firstLine) {
     Sprite sprite;
     sprite.id = firstLine[4];
-    sprite.frames = readFrames(file);  // Read frames
-
-    std::string line;
-    while (std::getline(file, line) && !line.empty()) {
-        if (line.find("NAME") != std::string::npos) {
-            sprite.name = line.substr(5);  // Extract sprite name
-        } else if (line.find("DLG") != std::string::npos) {
-            sprite.dialogId = std::stoi(line.substr(4));  // Extract dialogue ID
-        } else if (line.find("BLIP") != std::string::npos) {
-            sprite.blipId = std::stoi(line.substr(5));  // Extract blip sound ID
-        } else if (line.find("POS") != std::string::npos) {
-            sscanf(line.c_str(), "POS %d %d,%d", &sprite.roomId, &sprite.position.first, &sprite.position.second);
+    sprite.frames = readFrames(cursor);  // Read frames
+
+    BitsyStringView line;
+    while (cursor.nextLine(line) && !line.empty()) {
+        if (line.contains("NAME")) {
+            sprite.name = line.substr(5).str();  // Extract sprite name
+        } else if (line.contains("DLG")) {
+            sprite.dialogId = bitsyParseInt(line.substr(4));  // Extract dialogue ID
+        } else if (line.contains("BLIP")) {
+            sprite.blipId = bitsyParseInt(line.substr(5));  // Extract blip sound ID
+        } else if (line.contains("POS")) {
+            BitsyFieldScanner scanner(line);
+            scanner.literal("POS") && scanner.integer(sprite.roomId) && scanner.integer(sprite.position.first) &&
+                scanner.literal(",") && scanner.integer(sprite.position.second);
         }
     }
 
-    gameData.sprites.push_back(sprite);
+    return sprite;
 }
 
-void BitsyGameParser::parseItem(BitsyGameData& gameData, std::istream& file, const std::string& firstLine) {
+Item BitsyGameParser::parseItem(BitsyLineCursor& cursor, BitsyStringView firstLine) {
     Item item;
-    item.id = std::stoi(firstLine.substr(4));
-    item.frames = readFrames(file);  // Read frames
-
-    std::string line;
-    while (std::getline(file, line) && !line.empty()) {
-        if (line.find("NAME") != std::string::npos) {
-            item.name = line.substr(5);  // Extract item name
-        } else if (line.find("DLG") != std::string::npos) {
-            item.dialogId = std::stoi(line.substr(4));  // Extract dialogue ID
-        } else if (line.find("BLIP") != std::string::npos) {
-            item.blipId = std::stoi(line.substr(5));  // Extract blip sound ID
+    item.id = bitsyParseInt(firstLine.substr(4));
+    item.frames = readFrames(cursor);  // Read frames
+
+    BitsyStringView line;
+    while (cursor.nextLine(line) && !line.empty()) {
+        if (line.contains("NAME")) {
+            item.name = line.substr(5).str();  // Extract item name
+        } else if (line.contains("DLG")) {
+            item.dialogId = bitsyParseInt(line.substr(4));  // Extract dialogue ID
+        } else if (line.contains("BLIP")) {
+            item.blipId = bitsyParseInt(line.substr(5));  // Extract blip sound ID
         }
     }
 
-    gameData.items.push_back(item);
+    return item;
 }
 
-void BitsyGameParser::parseDialogue(BitsyGameData& gameData, std::istream& file, const std::string& firstLine) {
+Dialogue BitsyGameParser::parseDialogue(BitsyLineCursor& cursor, BitsyStringView firstLine) {
     Dialogue dlg;
-    dlg.id = std::stoi(firstLine.substr(4));
-    std::getline(file, dlg.text);
+    dlg.id = bitsyParseInt(firstLine.substr(4));
+
+    BitsyStringView line;
+    cursor.nextLine(line);
+    dlg.text = line.str();
 
-    std::string line;
-    std::getline(file, line);
-    if (line.find("NAME") != std::string::npos) {
-        dlg.name = line.substr(5);  // Extract dialogue name
+    cursor.nextLine(line);
+    if (line.contains("NAME")) {
+        dlg.name = line.substr(5).str();  // Extract dialogue name
     }
 
-    gameData.dialogues.push_back(dlg);
+    return dlg;
 }
 
-void BitsyGameParser::parseVariable(BitsyGameData& gameData, std::istream& file, const std::string& firstLine) {
+Variable BitsyGameParser::parseVariable(BitsyLineCursor& cursor, BitsyStringView firstLine) {
     Variable var;
-    var.name = firstLine.substr(4);  // Extract variable name
+    var.name = firstLine.substr(4).str();  // Extract variable name
 
-    std::string line;
-    std::getline(file, line);
-    var.value = line;  // Assign the value to the variable
+    BitsyStringView line;
+    cursor.nextLine(line);
+    var.value = line.str();  // Assign the value to the variable
 
-    gameData.variables[var.name] = var;
+    return var;
 }
 
-void BitsyGameParser::parseTune(BitsyGameData& gameData, std::istream& file, const std::string& firstLine) {
+Tune BitsyGameParser::parseTune(BitsyLineCursor& cursor, BitsyStringView firstLine) {
     Tune tune;
-    tune.id = std::stoi(firstLine.substr(5));  // Extract tune ID
+    tune.id = bitsyParseInt(firstLine.substr(5));  // Extract tune ID
 
-    std::string line;
+    BitsyStringView line;
     bool isTreble = true;
-    while (std::getline(file, line) && !line.empty()) {
-        if (line.find(">") != std::string::npos) {
+    while (cursor.nextLine(line) && !line.empty()) {
+        if (line.contains(">")) {
             isTreble = true;
-        } else if (line.find("NAME") != std::string::npos) {
-            tune.name = line.substr(5);
-        } else if (line.find("KEY") != std::string::npos) {
-            tune.key = line.substr(4);
-        } else if (line.find("TMP") != std::string::npos) {
-            tune.tempo = line.substr(4);
-        } else if (line.find("SQR") != std::string::npos) {
-            std::stringstream ss(line.substr(4));
-            ss >> tune.trebleInstrument >> tune.bassInstrument;
-        } else if (line.find("ARP") != std::string::npos) {
-            tune.arpeggio = line.substr(4);
+        } else if (line.contains("NAME")) {
+            tune.name = line.substr(5).str();
+        } else if (line.contains("KEY")) {
+            tune.key = line.substr(4).str();
+        } else if (line.contains("TMP")) {
+            tune.tempo = line.substr(4).str();
+        } else if (line.contains("SQR")) {
+            BitsyFieldScanner scanner(line.substr(4));
+            BitsyStringView treble, bass;
+            if (scanner.word(treble)) {
+                tune.trebleInstrument = treble.str();
+                if (scanner.word(bass)) tune.bassInstrument = bass.str();
+            }
+        } else if (line.contains("ARP")) {
+            tune.arpeggio = line.substr(4).str();
         } else {
             if (isTreble) {
-                tune.treblePatterns.push_back(line);
+                tune.treblePatterns.push_back(line.str());
             } else {
-                tune.bassPatterns.push_back(line);
+                tune.bassPatterns.push_back(line.str());
             }
             isTreble = !isTreble;
         }
     }
 
-    gameData.tunes.push_back(tune);
+    return tune;
 }
 
-void BitsyGameParser::parseBlip(BitsyGameData& gameData, std::istream& file, const std::string& firstLine) {
+Blip BitsyGameParser::parseBlip(BitsyLineCursor& cursor, BitsyStringView firstLine) {
     Blip blip;
-    blip.id = std::stoi(firstLine.substr(5));  // Extract blip ID
+    blip.id = bitsyParseInt(firstLine.substr(5));  // Extract blip ID
 
-    std::getline(file, blip.notes);  // Read blip notes
+    BitsyStringView line;
+    cursor.nextLine(line);
+    blip.notes = line.str();  // Read blip notes
 
-    std::string line;
-    while (std::getline(file, line) && !line.empty()) {
-        if (line.find("NAME") != std::string::npos) {
-            blip.name = line.substr(5);
-        } else if (line.find("ENV") != std::string::npos) {
-            std::stringstream ss(line.substr(4));
+    while (cursor.nextLine(line) && !line.empty()) {
+        if (line.contains("NAME")) {
+            blip.name = line.substr(5).str();
+        } else if (line.contains("ENV")) {
+            BitsyFieldScanner scanner(line.substr(4));
             int envVal;
-            while (ss >> envVal) {
+            while (scanner.integer(envVal)) {
                 blip.env.push_back(envVal);  // Add envelope values
             }
-        } else if (line.find("BEAT") != std::string::npos) {
-            std::stringstream ss(line.substr(5));
+        } else if (line.contains("BEAT")) {
+            BitsyFieldScanner scanner(line.substr(5));
             int beatVal;
-            while (ss >> beatVal) {
+            while (scanner.integer(beatVal)) {
                 blip.beat.push_back(beatVal);  // Add beat values
             }
-        } else if (line.find("SQR") != std::string::npos) {
-            blip.squareWave = line.substr(4);
-        } else if (line.find("RPT") != std::string::npos) {
-            blip.repeat = std::stoi(line.substr(4));
+        } else if (line.contains("SQR")) {
+            blip.squareWave = line.substr(4).str();
+        } else if (line.contains("RPT")) {
+            blip.repeat = bitsyParseInt(line.substr(4));
         }
     }
 
-    gameData.blips.push_back(blip);
+    return blip;
+}
+
+void BitsyGameParser::skipBlock(BitsyLineCursor& cursor) {
+    BitsyStringView line;
+    while (cursor.nextLine(line) && !line.empty()) {
+    }
 }
@@ -0,0 +1,66 @@
+#include <BitsyGameVisitor.h>
+
+bool BitsyGameBuilder::onTitle(BitsyStringView title) {
+    game_.title = title.str();
+    return true;
+}
+
+bool BitsyGameBuilder::onSetting(BitsyStringView key, int value) {
+    if (key == "VER_MAJ") game_.settings.verMaj = value;
+    else if (key == "VER_MIN") game_.settings.verMin = value;
+    else if (key == "ROOM_FORMAT") game_.settings.roomFormat = value;
+    else if (key == "DLG_COMPAT") game_.settings.dlgCompat = value;
+    else if (key == "TXT_MODE") game_.settings.txtMode = value;
+    return true;
+}
+
+bool BitsyGameBuilder::onPalette(Palette& palette) {
+    game_.palettes.push_back(std::move(palette));
+    return true;
+}
+
+bool BitsyGameBuilder::onRoom(Room& room) {
+    game_.rooms.push_back(std::move(room));
+    return true;
+}
+
+bool BitsyGameBuilder::onTile(Tile& tile) {
+    game_.tiles.push_back(std::move(tile));
+    return true;
+}
+
+bool BitsyGameBuilder::onAvatar(Avatar& avatar) {
+    game_.avatar = std::move(avatar);
+    return true;
+}
+
+bool BitsyGameBuilder::onSprite(Sprite& sprite) {
+    game_.sprites.push_back(std::move(sprite));
+    return true;
+}
+
+bool BitsyGameBuilder::onItem(Item& item) {
+    game_.items.push_back(std::move(item));
+    return true;
+}
+
+bool BitsyGameBuilder::onDialogue(Dialogue& dialogue) {
+    game_.dialogues.push_back(std::move(dialogue));
+    return true;
+}
+
+bool BitsyGameBuilder::onVariable(Variable& variable) {
+    std::string name = variable.name;
+    game_.variables[name] = std::move(variable);
+    return true;
+}
+
+bool BitsyGameBuilder::onTune(Tune& tune) {
+    game_.tunes.push_back(std::move(tune));
+    return true;
+}
+
+bool BitsyGameBuilder::onBlip(Blip& blip) {
+    game_.blips.push_back(std::move(blip));
+    return true;
+}
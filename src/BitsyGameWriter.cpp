@@ -0,0 +1,322 @@
+#include <BitsyGameWriter.h>
+#include <BitsyFdSink.h>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+// Sinks receive the text in pieces. CountSink only adds up lengths, BufferSink copies into
+// memory sized by a CountSink pass, BitsyFdSink batches writes to a file descriptor.
+struct CountSink {
+    size_t size = 0;
+    void append(const char*, size_t length) { size += length; }
+    void put(char) { ++size; }
+};
+
+struct BufferSink {
+    char* out;
+    void append(const char* text, size_t length) {
+        std::memcpy(out, text, length);
+        out += length;
+    }
+    void put(char c) { *out++ = c; }
+};
+
+template <typename Sink>
+class TextWriter {
+public:
+    explicit TextWriter(Sink& sink) : sink_(sink) {}
+
+    void text(const char* literal) { sink_.append(literal, std::strlen(literal)); }
+    void text(const std::string& value) { sink_.append(value.data(), value.size()); }
+    void put(char c) { sink_.put(c); }
+
+    void number(int value) {
+        char digits[12];
+        char* end = digits + sizeof(digits);
+        char* p = end;
+        unsigned magnitude = value < 0 ? 0u - static_cast<unsigned>(value) : static_cast<unsigned>(value);
+        do {
+            *--p = static_cast<char>('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude);
+        if (value < 0) *--p = '-';
+        sink_.append(p, end - p);
+    }
+
+    // "KEY value\n", for the many single-value property lines
+    void line(const char* key, const std::string& value) {
+        text(key);
+        put(' ');
+        text(value);
+        put('\n');
+    }
+    void line(const char* key, int value) {
+        text(key);
+        put(' ');
+        number(value);
+        put('\n');
+    }
+    void position(std::pair<int, int> xy) {
+        number(xy.first);
+        put(',');
+        number(xy.second);
+    }
+
+    void frames(const FrameSet& frames) {
+        size_t count = frames.empty() ? 1 : frames.size();
+        for (size_t i = 0; i < count; ++i) {
+            if (i > 0) text(">\n");
+            uint64_t bits = frames.empty() ? 0 : frames[i].bits;
+            for (int y = 0; y < 8; ++y) {
+                char row[9];
+                for (int x = 0; x < 8; ++x) row[x] = (bits >> (y * 8 + x)) & 1 ? '1' : '0';
+                row[8] = '\n';
+                sink_.append(row, sizeof(row));
+            }
+        }
+    }
+
+    void game(const BitsyGameData& game) {
+        text(game.title);
+        text("\n\n# BITSY VERSION ");
+        number(game.settings.verMaj);
+        put('.');
+        number(game.settings.verMin);
+        text("\n\n");
+
+        line("! VER_MAJ", game.settings.verMaj);
+        line("! VER_MIN", game.settings.verMin);
+        line("! ROOM_FORMAT", game.settings.roomFormat);
+        line("! DLG_COMPAT", game.settings.dlgCompat);
+        line("! TXT_MODE", game.settings.txtMode);
+        put('\n');
+
+        for (const Palette& palette : game.palettes) this->palette(palette);
+        for (const Room& room : game.rooms) this->room(room);
+        for (const Tile& tile : game.tiles) this->tile(tile);
+        avatar(game.avatar);
+        for (const Sprite& sprite : game.sprites) this->sprite(sprite);
+        for (const Item& item : game.items) this->item(item);
+        for (const Dialogue& dialogue : game.dialogues) this->dialogue(dialogue);
+        for (const auto& var : game.variables) variable(var.second);
+        for (const Tune& tune : game.tunes) this->tune(tune);
+        for (const Blip& blip : game.blips) this->blip(blip);
+    }
+
+private:
+    void color(const std::tuple<int, int, int>& rgb) {
+        number(std::get<0>(rgb));
+        put(',');
+        number(std::get<1>(rgb));
+        put(',');
+        number(std::get<2>(rgb));
+        put('\n');
+    }
+
+    void palette(const Palette& palette) {
+        line("PAL", palette.id);
+        color(palette.color1);
+        color(palette.color2);
+        color(palette.color3);
+        if (!palette.name.empty()) line("NAME", palette.name);
+        put('\n');
+    }
+
+    void room(const Room& room) {
+        line("ROOM", room.id);
+        for (int y = 0; y < RoomGrid::kSize; ++y) {
+            char row[2 * RoomGrid::kSize];
+            for (int x = 0; x < RoomGrid::kSize; ++x) {
+                row[2 * x] = room.tiles.at(x, y);
+                row[2 * x + 1] = ',';
+            }
+            row[2 * RoomGrid::kSize - 1] = '\n';
+            sink_.append(row, sizeof(row));
+        }
+        if (!room.name.empty()) line("NAME", room.name);
+        for (const auto& item : room.items) {
+            text("ITM ");
+            number(item.first);
+            put(' ');
+            position(item.second);
+            put('\n');
+        }
+        for (const Exit& exit : room.exits) {
+            text("EXT ");
+            position(exit.startPosition);
+            put(' ');
+            number(exit.destinationRoomId);
+            put(' ');
+            position(exit.destinationPosition);
+            if (!exit.effect.empty()) {  // The parser only reads DLG after an effect
+                text(" FX ");
+                text(exit.effect);
+                if (exit.dialogueId != -1) {
+                    text(" DLG ");
+                    number(exit.dialogueId);
+                }
+            }
+            put('\n');
+        }
+        for (const End& end : room.endings) {
+            text("END ");
+            number(end.dialogueId);
+            put(' ');
+            position(end.position);
+            put('\n');
+        }
+        line("PAL", room.paletteId);
+        if (room.tuneId != 0) line("TUNE", room.tuneId);
+        put('\n');
+    }
+
+    void tile(const Tile& tile) {
+        text("TIL ");
+        put(tile.id);
+        put('\n');
+        frames(tile.frames);
+        if (!tile.name.empty()) line("NAME", tile.name);
+        if (tile.wall) text("WAL true\n");
+        put('\n');
+    }
+
+    void avatar(const Avatar& avatar) {
+        text("SPR A\n");
+        frames(avatar.frames);
+        text("POS ");
+        number(avatar.roomId);
+        put(' ');
+        position(avatar.position);
+        put('\n');
+        for (int itemId : avatar.inventory) line("ITM", itemId);
+        put('\n');
+    }
+
+    void sprite(const Sprite& sprite) {
+        text("SPR ");
+        put(sprite.id);
+        put('\n');
+        frames(sprite.frames);
+        if (!sprite.name.empty()) line("NAME", sprite.name);
+        if (sprite.dialogId != -1) line("DLG", sprite.dialogId);
+        text("POS ");
+        number(sprite.roomId);
+        put(' ');
+        position(sprite.position);
+        put('\n');
+        if (sprite.blipId != -1) line("BLIP", sprite.blipId);
+        put('\n');
+    }
+
+    void item(const Item& item) {
+        line("ITM", item.id);
+        frames(item.frames);
+        if (!item.name.empty()) line("NAME", item.name);
+        if (item.dialogId != -1) line("DLG", item.dialogId);
+        if (item.blipId != -1) line("BLIP", item.blipId);
+        put('\n');
+    }
+
+    void dialogue(const Dialogue& dialogue) {
+        line("DLG", dialogue.id);
+        text(dialogue.text);
+        put('\n');
+        if (!dialogue.name.empty()) line("NAME", dialogue.name);
+        put('\n');
+    }
+
+    void variable(const Variable& variable) {
+        line("VAR", variable.name);
+        text(variable.value);
+        text("\n\n");
+    }
+
+    // Patterns alternate treble, bass; ">" starts the next pair
+    void tune(const Tune& tune) {
+        line("TUNE", tune.id);
+        for (size_t i = 0; i < tune.treblePatterns.size(); ++i) {
+            if (i > 0) text(">\n");
+            text(tune.treblePatterns[i]);
+            put('\n');
+            if (i < tune.bassPatterns.size()) {
+                text(tune.bassPatterns[i]);
+                put('\n');
+            }
+        }
+        if (!tune.name.empty()) line("NAME", tune.name);
+        if (!tune.key.empty()) line("KEY", tune.key);
+        if (!tune.tempo.empty()) line("TMP", tune.tempo);
+        if (!tune.trebleInstrument.empty()) {
+            text("SQR ");
+            text(tune.trebleInstrument);
+            if (!tune.bassInstrument.empty()) {
+                put(' ');
+                text(tune.bassInstrument);
+            }
+            put('\n');
+        }
+        if (!tune.arpeggio.empty()) line("ARP", tune.arpeggio);
+        put('\n');
+    }
+
+    void numbers(const char* key, const std::vector<int>& values) {
+        text(key);
+        for (int value : values) {
+            put(' ');
+            number(value);
+        }
+        put('\n');
+    }
+
+    void blip(const Blip& blip) {
+        line("BLIP", blip.id);
+        text(blip.notes);
+        put('\n');
+        if (!blip.name.empty()) line("NAME", blip.name);
+        if (!blip.env.empty()) numbers("ENV", blip.env);
+        if (!blip.beat.empty()) numbers("BEAT", blip.beat);
+        if (!blip.squareWave.empty()) line("SQR", blip.squareWave);
+        if (blip.repeat != 0) line("RPT", blip.repeat);
+        put('\n');
+    }
+
+    Sink& sink_;
+};
+
+}  // namespace
+
+size_t BitsyGameWriter::measure(const BitsyGameData& game) {
+    CountSink sink;
+    TextWriter<CountSink>(sink).game(game);
+    return sink.size;
+}
+
+std::string BitsyGameWriter::write(const BitsyGameData& game) {
+    std::string text(measure(game), '\0');
+    if (!text.empty()) write(game, &text[0], text.size());
+    return text;
+}
+
+size_t BitsyGameWriter::write(const BitsyGameData& game, char* buffer, size_t capacity) {
+    size_t size = measure(game);
+    if (capacity < size) return 0;
+    BufferSink sink;
+    sink.out = buffer;
+    TextWriter<BufferSink>(sink).game(game);
+    return size;
+}
+
+bool BitsyGameWriter::writeFd(const BitsyGameData& game, int fd) {
+    BitsyFdSink sink(fd);
+    TextWriter<BitsyFdSink>(sink).game(game);
+    return sink.finish();
+}
+
+bool BitsyGameWriter::writeFile(const BitsyGameData& game, const std::string& filePath) {
+    int fd = ::open(filePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    bool ok = writeFd(game, fd);
+    return ::close(fd) == 0 && ok;
+}
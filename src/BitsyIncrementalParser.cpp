@@ -0,0 +1,300 @@
+#include <BitsyIncrementalParser.h>
+#include <BitsyGameParser.h>
+#include <BitsyMappedFile.h>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+
+namespace {
+
+const int kTypeCount = kBlockBlip + 1;
+
+uint64_t hashBlock(const char* data, size_t size) {
+    uint64_t hash = 1469598103934665603ull;  // FNV-1a
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Builder that also notes whether the block set settings or the avatar, which are assigned
+// rather than appended and so are re-applied separately
+class BlockCollector : public BitsyGameBuilder {
+public:
+    explicit BlockCollector(BitsyGameData& part) : BitsyGameBuilder(part) {}
+
+    bool onSetting(BitsyStringView key, int value) override {
+        hasSettings = true;
+        return BitsyGameBuilder::onSetting(key, value);
+    }
+    bool onAvatar(Avatar& avatar) override {
+        hasAvatar = true;
+        return BitsyGameBuilder::onAvatar(avatar);
+    }
+
+    bool hasSettings = false;
+    bool hasAvatar = false;
+};
+
+BitsyEntityKey makeKey(BitsyBlockType type, int id) {
+    BitsyEntityKey key;
+    key.type = type;
+    key.id = id;
+    return key;
+}
+
+template <typename T>
+void appendKeys(const std::vector<T>& entries, BitsyBlockType type, std::vector<BitsyEntityKey>& keys) {
+    for (const T& entry : entries) keys.push_back(makeKey(type, entry.id));
+}
+
+// Keys of everything a block produced
+std::vector<BitsyEntityKey> keysOf(const BitsyGameData& part, const BlockCollector& collector) {
+    std::vector<BitsyEntityKey> keys;
+    if (collector.hasSettings) keys.push_back(makeKey(kBlockSettings, 0));
+    if (collector.hasAvatar) keys.push_back(makeKey(kBlockAvatar, 0));
+    appendKeys(part.palettes, kBlockPalette, keys);
+    appendKeys(part.rooms, kBlockRoom, keys);
+    appendKeys(part.tiles, kBlockTile, keys);
+    appendKeys(part.sprites, kBlockSprite, keys);
+    appendKeys(part.items, kBlockItem, keys);
+    appendKeys(part.dialogues, kBlockDialogue, keys);
+    for (const auto& var : part.variables) {
+        BitsyEntityKey key = makeKey(kBlockVariable, 0);
+        key.name = var.first;
+        keys.push_back(key);
+    }
+    appendKeys(part.tunes, kBlockTune, keys);
+    appendKeys(part.blips, kBlockBlip, keys);
+    return keys;
+}
+
+template <typename T>
+void moveRange(std::vector<T>& from, size_t first, size_t count, std::vector<T>& to) {
+    for (size_t i = first; i < first + count; ++i) to.push_back(std::move(from[i]));
+}
+
+// Move the appended entities of one block (first[type] and count[type] per vector) from src to dst
+void moveEntities(BitsyGameData& src, const size_t* first, const size_t* count, BitsyGameData& dst) {
+    moveRange(src.palettes, first[kBlockPalette], count[kBlockPalette], dst.palettes);
+    moveRange(src.rooms, first[kBlockRoom], count[kBlockRoom], dst.rooms);
+    moveRange(src.tiles, first[kBlockTile], count[kBlockTile], dst.tiles);
+    moveRange(src.sprites, first[kBlockSprite], count[kBlockSprite], dst.sprites);
+    moveRange(src.items, first[kBlockItem], count[kBlockItem], dst.items);
+    moveRange(src.dialogues, first[kBlockDialogue], count[kBlockDialogue], dst.dialogues);
+    moveRange(src.tunes, first[kBlockTune], count[kBlockTune], dst.tunes);
+    moveRange(src.blips, first[kBlockBlip], count[kBlockBlip], dst.blips);
+}
+
+void countKeys(const std::vector<BitsyEntityKey>& keys, size_t* count) {
+    std::fill(count, count + kTypeCount, 0);
+    for (const BitsyEntityKey& key : keys) ++count[key.type];
+}
+
+typedef std::tuple<int, int, std::string> KeyTuple;
+
+KeyTuple tupleOf(const BitsyEntityKey& key) {
+    return KeyTuple(key.type, key.id, key.name);
+}
+
+}  // namespace
+
+bool operator==(const BitsyEntityKey& a, const BitsyEntityKey& b) {
+    return a.type == b.type && a.id == b.id && a.name == b.name;
+}
+
+void BitsyIncrementalParser::reset() {
+    blocks_.clear();
+    game_ = nullptr;
+}
+
+bool BitsyIncrementalParser::updateFile(const std::string& filePath, BitsyGameData& game, BitsyReloadReport& report,
+                                        std::string& error) {
+    BitsyMappedFile file;
+
+    if (!file.open(filePath)) {
+        error = "Error: Unable to open file " + filePath;
+        return false;
+    }
+
+    return update(file.data(), file.size(), game, report, error);
+}
+
+bool BitsyIncrementalParser::update(const char* data, size_t size, BitsyGameData& game, BitsyReloadReport& report,
+                                    std::string& error) {
+    report = BitsyReloadReport();
+    report.fullParse = game_ != &game;
+    const std::vector<BlockState> noBlocks;
+    const std::vector<BlockState>& oldBlocks = report.fullParse ? noBlocks : blocks_;
+
+    // Match new blocks against unused old blocks with the same type, hash and length
+    std::vector<BitsyBlock> blocks = BitsyBlockScanner::scan(data, size);
+    std::vector<BlockState> states(blocks.size());
+    std::unordered_map<uint64_t, std::vector<size_t>> oldByHash;
+    for (size_t j = oldBlocks.size(); j-- > 0;) oldByHash[oldBlocks[j].hash].push_back(j);
+
+    std::vector<long> matched(blocks.size(), -1);  // Old block index, or -1 if the block changed
+    std::vector<bool> oldUsed(oldBlocks.size(), false);
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        BlockState& state = states[i];
+        state.type = blocks[i].type;
+        state.length = blocks[i].length;
+        state.hash = hashBlock(data + blocks[i].offset, blocks[i].length);
+
+        std::unordered_map<uint64_t, std::vector<size_t>>::iterator it = oldByHash.find(state.hash);
+        if (it == oldByHash.end()) continue;
+        std::vector<size_t>& candidates = it->second;
+        for (size_t c = candidates.size(); c-- > 0;) {
+            const BlockState& old = oldBlocks[candidates[c]];
+            if (old.type == state.type && old.length == state.length) {
+                matched[i] = static_cast<long>(candidates[c]);
+                oldUsed[candidates[c]] = true;
+                state.keys = old.keys;
+                candidates.erase(candidates.begin() + c);
+                break;
+            }
+        }
+    }
+
+    // Parse the changed blocks before touching the game, so a failure leaves it intact
+    std::vector<BitsyGameData> parts(blocks.size());
+    bool assignedChanged = false;  // A block setting the settings or avatar changed
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        if (matched[i] >= 0) {
+            ++report.blocksReused;
+            continue;
+        }
+        BlockCollector collector(parts[i]);
+        if (!BitsyGameParser::parseBlocks(data + blocks[i].offset, blocks[i].length, collector, error)) {
+            return false;
+        }
+        states[i].keys = keysOf(parts[i], collector);
+        assignedChanged = assignedChanged || collector.hasSettings || collector.hasAvatar;
+        ++report.blocksParsed;
+    }
+    for (size_t j = 0; j < oldBlocks.size(); ++j) {
+        if (oldUsed[j]) continue;
+        for (const BitsyEntityKey& key : oldBlocks[j].keys) {
+            assignedChanged = assignedChanged || key.type == kBlockSettings || key.type == kBlockAvatar;
+        }
+    }
+
+    // Where each old block's entities start in the game's vectors
+    std::vector<size_t> oldFirst(oldBlocks.size() * kTypeCount);
+    size_t next[kTypeCount] = {};
+    size_t count[kTypeCount];
+    for (size_t j = 0; j < oldBlocks.size(); ++j) {
+        countKeys(oldBlocks[j].keys, count);
+        for (int t = 0; t < kTypeCount; ++t) {
+            oldFirst[j * kTypeCount + t] = next[t];
+            next[t] += count[t];
+        }
+    }
+
+    // Rebuild the entity vectors in the new block order, moving unchanged entities across
+    if (report.fullParse) game = BitsyGameData();
+    BitsyGameData rebuilt;
+    const size_t zero[kTypeCount] = {};
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        countKeys(states[i].keys, count);
+        if (matched[i] >= 0) {
+            moveEntities(game, &oldFirst[matched[i] * kTypeCount], count, rebuilt);
+        } else {
+            moveEntities(parts[i], zero, count, rebuilt);
+        }
+    }
+    game.palettes.swap(rebuilt.palettes);
+    game.rooms.swap(rebuilt.rooms);
+    game.tiles.swap(rebuilt.tiles);
+    game.sprites.swap(rebuilt.sprites);
+    game.items.swap(rebuilt.items);
+    game.dialogues.swap(rebuilt.dialogues);
+    game.tunes.swap(rebuilt.tunes);
+    game.blips.swap(rebuilt.blips);
+
+    // Variables live in a map keyed by name where the last definition in the file wins, so when
+    // any block defining them changed, rebuild the map in file order. Unchanged VAR blocks are
+    // parsed again; like the settings below they are few and short
+    bool variablesChanged = false;
+    for (size_t i = 0; i < blocks.size(); ++i) variablesChanged = variablesChanged || !parts[i].variables.empty();
+    for (size_t j = 0; j < oldBlocks.size(); ++j) {
+        if (oldUsed[j]) continue;
+        for (const BitsyEntityKey& key : oldBlocks[j].keys) {
+            variablesChanged = variablesChanged || key.type == kBlockVariable;
+        }
+    }
+    if (variablesChanged) {
+        game.variables.clear();
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            BitsyGameData reparsed;
+            const BitsyGameData* part = &parts[i];
+            if (matched[i] >= 0) {
+                bool defines = false;
+                for (const BitsyEntityKey& key : states[i].keys) defines = defines || key.type == kBlockVariable;
+                if (!defines) continue;
+                BlockCollector collector(reparsed);
+                std::string ignored;  // Parsed without errors in an earlier update
+                BitsyGameParser::parseBlocks(data + blocks[i].offset, blocks[i].length, collector, ignored);
+                part = &reparsed;
+            }
+            for (const auto& var : part->variables) game.variables[var.first] = var.second;
+        }
+    }
+
+    // Settings and the avatar are assigned in file order, so re-apply every block that sets
+    // them; there are only a handful and they are short
+    if (assignedChanged) {
+        game.settings = Settings();
+        game.avatar = Avatar();
+        BitsyGameBuilder builder(game);
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            bool assigns = false;
+            for (const BitsyEntityKey& key : states[i].keys) {
+                assigns = assigns || key.type == kBlockSettings || key.type == kBlockAvatar;
+            }
+            if (!assigns) continue;
+            std::string ignored;  // Parsed without errors above or in an earlier update
+            BitsyGameParser::parseBlocks(data + blocks[i].offset, blocks[i].length, builder, ignored);
+        }
+    }
+
+    BitsyLineCursor titleCursor(data, data + size);
+    BitsyStringView title;
+    titleCursor.nextLine(title);
+    report.titleChanged = game.title != title.str();
+    game.title = title.str();
+    game.buildIndex();
+
+    // Report: keys that were both removed and added were modified
+    std::map<KeyTuple, size_t> removedKeys;
+    for (size_t j = 0; j < oldBlocks.size(); ++j) {
+        if (oldUsed[j]) continue;
+        for (const BitsyEntityKey& key : oldBlocks[j].keys) ++removedKeys[tupleOf(key)];
+    }
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        if (matched[i] >= 0) continue;
+        for (const BitsyEntityKey& key : states[i].keys) {
+            std::map<KeyTuple, size_t>::iterator it = removedKeys.find(tupleOf(key));
+            if (it != removedKeys.end() && it->second > 0) {
+                --it->second;
+                report.modified.push_back(key);
+            } else {
+                report.added.push_back(key);
+            }
+        }
+    }
+    for (size_t j = 0; j < oldBlocks.size(); ++j) {
+        if (oldUsed[j]) continue;
+        for (const BitsyEntityKey& key : oldBlocks[j].keys) {
+            size_t& remaining = removedKeys[tupleOf(key)];
+            if (remaining == 0) continue;
+            --remaining;
+            report.removed.push_back(key);
+        }
+    }
+
+    blocks_.swap(states);
+    game_ = &game;
+    return true;
+}
@@ -0,0 +1,132 @@
+#include <BitsyInternPool.h>
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace {
+
+const uint64_t kFnvOffset = 1469598103934665603ull;
+const uint64_t kFnvPrime = 1099511628211ull;
+
+uint64_t fnv1a(const void* data, size_t size, uint64_t hash = kFnvOffset) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) hash = (hash ^ bytes[i]) * kFnvPrime;
+    return hash;
+}
+
+// FNV-1a spreads poorly into the high bits used to pick a shard; finish with a 64-bit mix
+uint64_t finish(uint64_t hash) {
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+}  // namespace
+
+template <typename T, typename Equal, typename Create>
+const T* BitsyInternPool::find(Kind kind, uint64_t hash, const Equal& equal, const Create& create) {
+    Shard& shard = shards_[hash >> (64 - kShardBits)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    ++shard.requests;
+
+    if (shard.slots.empty()) shard.slots.resize(64, Slot{0, nullptr, kKindString});
+    size_t mask = shard.slots.size() - 1;
+    size_t index = static_cast<size_t>(hash) & mask;
+    for (; shard.slots[index].value; index = (index + 1) & mask) {
+        const Slot& slot = shard.slots[index];
+        if (slot.hash == hash && slot.kind == kind && equal(*static_cast<const T*>(slot.value))) {
+            ++shard.hits;
+            return static_cast<const T*>(slot.value);
+        }
+    }
+
+    const T* value = create(shard.arena);
+    shard.slots[index] = Slot{hash, value, kind};
+    if (++shard.values * 4 > shard.slots.size() * 3) {
+        std::vector<Slot> old(shard.slots.size() * 2, Slot{0, nullptr, kKindString});
+        old.swap(shard.slots);
+        mask = shard.slots.size() - 1;
+        for (const Slot& slot : old) {
+            if (!slot.value) continue;
+            size_t at = static_cast<size_t>(slot.hash) & mask;
+            while (shard.slots[at].value) at = (at + 1) & mask;
+            shard.slots[at] = slot;
+        }
+    }
+    return value;
+}
+
+BitsyStringHandle BitsyInternPool::intern(BitsyStringView text) {
+    uint64_t hash = finish(fnv1a(text.data, text.size, kFnvOffset ^ kKindString));
+    const BitsyStringView* value = find<BitsyStringView>(
+        kKindString, hash, [text](const BitsyStringView& stored) { return stored == text; },
+        [text](BitsyArena& arena) {
+            // The view and its characters in one allocation
+            char* memory = static_cast<char*>(arena.allocate(sizeof(BitsyStringView) + text.size,
+                                                             alignof(BitsyStringView)));
+            char* chars = memory + sizeof(BitsyStringView);
+            if (text.size) std::memcpy(chars, text.data, text.size);
+            return new (memory) BitsyStringView(chars, text.size);
+        });
+    return BitsyStringHandle(value);
+}
+
+BitsyFrameHandle BitsyInternPool::intern(const FrameSet& frames) {
+    FrameSet normalized;  // Frames past count are ignored by ==, so keep them out of the hash
+    for (size_t i = 0; i < frames.size(); ++i) normalized.push_back(frames[i]);
+    uint64_t hash = fnv1a(&normalized.count, sizeof(normalized.count), kFnvOffset ^ kKindFrames);
+    hash = finish(fnv1a(normalized.frames, sizeof(normalized.frames), hash));
+    const FrameSet* value = find<FrameSet>(
+        kKindFrames, hash, [&normalized](const FrameSet& stored) { return stored == normalized; },
+        [&normalized](BitsyArena& arena) { return new (arena.allocateArray<FrameSet>(1)) FrameSet(normalized); });
+    return BitsyFrameHandle(value);
+}
+
+BitsyGridHandle BitsyInternPool::intern(const RoomGrid& grid) {
+    uint64_t hash = finish(fnv1a(grid.cells, sizeof(grid.cells), kFnvOffset ^ kKindGrid));
+    const RoomGrid* value = find<RoomGrid>(
+        kKindGrid, hash, [&grid](const RoomGrid& stored) { return stored == grid; },
+        [&grid](BitsyArena& arena) { return new (arena.allocateArray<RoomGrid>(1)) RoomGrid(grid); });
+    return BitsyGridHandle(value);
+}
+
+BitsyStringListHandle BitsyInternPool::intern(const std::vector<BitsyStringHandle>& list) {
+    // Elements are interned, so the list is identified by their addresses
+    uint64_t hash = kFnvOffset ^ kKindList;
+    for (BitsyStringHandle handle : list) {
+        const BitsyStringView* element = handle.get();
+        hash = fnv1a(&element, sizeof(element), hash);
+    }
+    hash = finish(hash);
+    const BitsySpan<BitsyStringHandle>* value = find<BitsySpan<BitsyStringHandle>>(
+        kKindList, hash,
+        [&list](const BitsySpan<BitsyStringHandle>& stored) {
+            return stored.size == list.size() && std::equal(stored.begin(), stored.end(), list.begin());
+        },
+        [&list](BitsyArena& arena) {
+            BitsySpan<BitsyStringHandle> elements = arena.copyArray(list);
+            return new (arena.allocateArray<BitsySpan<BitsyStringHandle>>(1)) BitsySpan<BitsyStringHandle>(elements);
+        });
+    return BitsyStringListHandle(value);
+}
+
+BitsyStringListHandle BitsyInternPool::intern(const std::vector<std::string>& list) {
+    std::vector<BitsyStringHandle> handles;
+    handles.reserve(list.size());
+    for (const std::string& text : list) handles.push_back(intern(text));
+    return intern(handles);
+}
+
+BitsyInternPool::Stats BitsyInternPool::stats() const {
+    Stats stats;
+    for (const Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        stats.values += shard.values;
+        stats.bytes += shard.arena.bytesUsed();
+        stats.tableBytes += shard.slots.capacity() * sizeof(Slot);
+        stats.requests += shard.requests;
+        stats.hits += shard.hits;
+    }
+    return stats;
+}
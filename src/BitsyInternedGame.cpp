@@ -0,0 +1,431 @@
+#include <BitsyInternedGame.h>
+#include <BitsyGameParser.h>
+#include <BitsyGameVisitor.h>
+#include <BitsyMappedFile.h>
+#include <algorithm>
+
+namespace {
+
+template <typename T>
+size_t vectorBytes(const std::vector<T>& values) {
+    return values.capacity() * sizeof(T);
+}
+
+std::string str(BitsyStringHandle handle) {  // Default handles read as empty strings
+    return handle.valid() ? handle->str() : std::string();
+}
+
+std::vector<std::string> strings(BitsyStringListHandle handle) {
+    std::vector<std::string> out;
+    if (!handle.valid()) return out;
+    out.reserve(handle->size);
+    for (BitsyStringHandle element : *handle) out.push_back(element->str());
+    return out;
+}
+
+bool lessByName(const InternedVariable& a, const InternedVariable& b) {
+    return std::lexicographical_compare(a.name->begin(), a.name->end(), b.name->begin(), b.name->end());
+}
+
+}  // namespace
+
+// Visitor that interns each parsed entity; assign() feeds it the entities of a BitsyGameData
+class BitsyInternBuilder : public BitsyGameVisitor {
+public:
+    explicit BitsyInternBuilder(BitsyInternedGame& game) : game_(game), pool_(*game.pool_) {}
+
+    bool onTitle(BitsyStringView title) override {
+        game_.title = pool_.intern(title);
+        return true;
+    }
+
+    bool onSetting(BitsyStringView key, int value) override {
+        if (key == "VER_MAJ") game_.settings.verMaj = value;
+        else if (key == "VER_MIN") game_.settings.verMin = value;
+        else if (key == "ROOM_FORMAT") game_.settings.roomFormat = value;
+        else if (key == "DLG_COMPAT") game_.settings.dlgCompat = value;
+        else if (key == "TXT_MODE") game_.settings.txtMode = value;
+        return true;
+    }
+
+    bool onPalette(Palette& palette) override {
+        InternedPalette out;
+        out.id = palette.id;
+        out.color1 = palette.color1;
+        out.color2 = palette.color2;
+        out.color3 = palette.color3;
+        out.name = pool_.intern(palette.name);
+        game_.palettes.push_back(out);
+        return true;
+    }
+
+    bool onRoom(Room& room) override {
+        InternedRoom out;
+        out.id = room.id;
+        out.tiles = pool_.intern(room.tiles);
+        out.items.swap(room.items);
+        out.exits.reserve(room.exits.size());
+        for (const Exit& ext : room.exits) {
+            InternedExit exitOut;
+            exitOut.startPosition = ext.startPosition;
+            exitOut.destinationRoomId = ext.destinationRoomId;
+            exitOut.destinationPosition = ext.destinationPosition;
+            exitOut.effect = pool_.intern(ext.effect);
+            exitOut.dialogueId = ext.dialogueId;
+            out.exits.push_back(exitOut);
+        }
+        out.endings.swap(room.endings);
+        out.paletteId = room.paletteId;
+        out.tuneId = room.tuneId;
+        out.name = pool_.intern(room.name);
+        game_.rooms.push_back(std::move(out));
+        return true;
+    }
+
+    bool onTile(Tile& tile) override {
+        InternedTile out;
+        out.id = tile.id;
+        out.frames = pool_.intern(tile.frames);
+        out.name = pool_.intern(tile.name);
+        out.wall = tile.wall;
+        game_.tiles.push_back(out);
+        return true;
+    }
+
+    bool onAvatar(Avatar& avatar) override {
+        game_.avatar.frames = pool_.intern(avatar.frames);
+        game_.avatar.roomId = avatar.roomId;
+        game_.avatar.position = avatar.position;
+        game_.avatar.inventory.swap(avatar.inventory);
+        return true;
+    }
+
+    bool onSprite(Sprite& sprite) override {
+        InternedSprite out;
+        out.id = sprite.id;
+        out.frames = pool_.intern(sprite.frames);
+        out.name = pool_.intern(sprite.name);
+        out.dialogId = sprite.dialogId;
+        out.blipId = sprite.blipId;
+        out.roomId = sprite.roomId;
+        out.position = sprite.position;
+        game_.sprites.push_back(out);
+        return true;
+    }
+
+    bool onItem(Item& item) override {
+        InternedItem out;
+        out.id = item.id;
+        out.frames = pool_.intern(item.frames);
+        out.name = pool_.intern(item.name);
+        out.dialogId = item.dialogId;
+        out.blipId = item.blipId;
+        game_.items.push_back(out);
+        return true;
+    }
+
+    bool onDialogue(Dialogue& dialogue) override {
+        InternedDialogue out;
+        out.id = dialogue.id;
+        out.text = pool_.intern(dialogue.text);
+        out.name = pool_.intern(dialogue.name);
+        game_.dialogues.push_back(out);
+        return true;
+    }
+
+    bool onVariable(Variable& variable) override {
+        InternedVariable out;
+        out.name = pool_.intern(variable.name);
+        out.value = pool_.intern(variable.value);
+        game_.variables.push_back(out);
+        return true;
+    }
+
+    bool onTune(Tune& tune) override {
+        InternedTune out;
+        out.id = tune.id;
+        out.treblePatterns = pool_.intern(tune.treblePatterns);
+        out.bassPatterns = pool_.intern(tune.bassPatterns);
+        out.key = pool_.intern(tune.key);
+        out.tempo = pool_.intern(tune.tempo);
+        out.trebleInstrument = pool_.intern(tune.trebleInstrument);
+        out.bassInstrument = pool_.intern(tune.bassInstrument);
+        out.arpeggio = pool_.intern(tune.arpeggio);
+        out.name = pool_.intern(tune.name);
+        game_.tunes.push_back(out);
+        return true;
+    }
+
+    bool onBlip(Blip& blip) override {
+        InternedBlip out;
+        out.id = blip.id;
+        out.notes = pool_.intern(blip.notes);
+        out.env.swap(blip.env);
+        out.beat.swap(blip.beat);
+        out.squareWave = pool_.intern(blip.squareWave);
+        out.repeat = blip.repeat;
+        out.name = pool_.intern(blip.name);
+        game_.blips.push_back(std::move(out));
+        return true;
+    }
+
+    void finish() {
+        // Variables behave like the std::map in BitsyGameData: sorted, and the last definition wins
+        std::vector<InternedVariable>& vars = game_.variables;
+        std::stable_sort(vars.begin(), vars.end(), lessByName);
+        size_t kept = 0;
+        for (size_t i = 0; i < vars.size(); ++i) {
+            if (kept > 0 && vars[kept - 1].name == vars[i].name) vars[kept - 1] = vars[i];
+            else vars[kept++] = vars[i];
+        }
+        vars.resize(kept);
+    }
+
+private:
+    BitsyInternedGame& game_;
+    BitsyInternPool& pool_;
+};
+
+bool BitsyInternedGame::loadFile(const std::string& filePath, std::string& error) {
+    BitsyMappedFile file;
+
+    if (!file.open(filePath)) {
+        clear();
+        error = "Error: Unable to open file " + filePath;
+        return false;
+    }
+
+    return loadBuffer(file.data(), file.size(), error);
+}
+
+bool BitsyInternedGame::loadBuffer(const char* data, size_t size, std::string& error) {
+    clear();
+    BitsyInternBuilder builder(*this);
+    bool ok = BitsyGameParser::parse(data, size, builder, error);
+    builder.finish();
+    return ok;
+}
+
+void BitsyInternedGame::assign(const BitsyGameData& game) {
+    clear();
+    BitsyInternBuilder builder(*this);
+    builder.onTitle(game.title);
+    settings = game.settings;
+
+    // The builder takes entities by non-const reference to move from them, so hand it copies
+    for (Palette palette : game.palettes) builder.onPalette(palette);
+    for (Room room : game.rooms) builder.onRoom(room);
+    for (Tile tile : game.tiles) builder.onTile(tile);
+    Avatar avatarCopy = game.avatar;
+    builder.onAvatar(avatarCopy);
+    for (Sprite sprite : game.sprites) builder.onSprite(sprite);
+    for (Item item : game.items) builder.onItem(item);
+    for (Dialogue dialogue : game.dialogues) builder.onDialogue(dialogue);
+    for (const auto& entry : game.variables) {
+        Variable variable = entry.second;
+        builder.onVariable(variable);
+    }
+    for (Tune tune : game.tunes) builder.onTune(tune);
+    for (Blip blip : game.blips) builder.onBlip(blip);
+    builder.finish();
+}
+
+void BitsyInternedGame::clear() {
+    title = BitsyStringHandle();
+    settings = Settings();
+    avatar = InternedAvatar();
+    palettes.clear();
+    rooms.clear();
+    tiles.clear();
+    sprites.clear();
+    items.clear();
+    dialogues.clear();
+    variables.clear();
+    tunes.clear();
+    blips.clear();
+}
+
+const InternedVariable* BitsyInternedGame::findVariable(BitsyStringView name) const {
+    auto it = std::lower_bound(variables.begin(), variables.end(), name,
+        [](const InternedVariable& var, BitsyStringView key) {
+            return std::lexicographical_compare(var.name->begin(), var.name->end(), key.begin(), key.end());
+        });
+    return it != variables.end() && *it->name == name ? &*it : nullptr;
+}
+
+BitsyGameData BitsyInternedGame::toGameData() const {
+    BitsyGameData game;
+    game.title = str(title);
+    game.settings = settings;
+    if (avatar.frames.valid()) game.avatar.frames = *avatar.frames;
+    game.avatar.roomId = avatar.roomId;
+    game.avatar.position = avatar.position;
+    game.avatar.inventory = avatar.inventory;
+
+    for (const InternedPalette& in : palettes) {
+        Palette out;
+        out.id = in.id;
+        out.color1 = in.color1;
+        out.color2 = in.color2;
+        out.color3 = in.color3;
+        out.name = str(in.name);
+        game.palettes.push_back(out);
+    }
+    for (const InternedRoom& in : rooms) {
+        Room out;
+        out.id = in.id;
+        out.tiles = *in.tiles;
+        out.items = in.items;
+        for (const InternedExit& ext : in.exits) {
+            Exit exitOut;
+            exitOut.startPosition = ext.startPosition;
+            exitOut.destinationRoomId = ext.destinationRoomId;
+            exitOut.destinationPosition = ext.destinationPosition;
+            exitOut.effect = str(ext.effect);
+            exitOut.dialogueId = ext.dialogueId;
+            out.exits.push_back(exitOut);
+        }
+        out.endings = in.endings;
+        out.paletteId = in.paletteId;
+        out.tuneId = in.tuneId;
+        out.name = str(in.name);
+        game.rooms.push_back(out);
+    }
+    for (const InternedTile& in : tiles) {
+        Tile out;
+        out.id = in.id;
+        out.frames = *in.frames;
+        out.name = str(in.name);
+        out.wall = in.wall;
+        game.tiles.push_back(out);
+    }
+    for (const InternedSprite& in : sprites) {
+        Sprite out;
+        out.id = in.id;
+        out.frames = *in.frames;
+        out.name = str(in.name);
+        out.dialogId = in.dialogId;
+        out.blipId = in.blipId;
+        out.roomId = in.roomId;
+        out.position = in.position;
+        game.sprites.push_back(out);
+    }
+    for (const InternedItem& in : items) {
+        Item out;
+        out.id = in.id;
+        out.frames = *in.frames;
+        out.name = str(in.name);
+        out.dialogId = in.dialogId;
+        out.blipId = in.blipId;
+        game.items.push_back(out);
+    }
+    for (const InternedDialogue& in : dialogues) {
+        Dialogue out;
+        out.id = in.id;
+        out.text = str(in.text);
+        out.name = str(in.name);
+        game.dialogues.push_back(out);
+    }
+    for (const InternedVariable& in : variables) {
+        Variable out;
+        out.name = str(in.name);
+        out.value = str(in.value);
+        game.variables[out.name] = out;
+    }
+    for (const InternedTune& in : tunes) {
+        Tune out;
+        out.id = in.id;
+        out.treblePatterns = strings(in.treblePatterns);
+        out.bassPatterns = strings(in.bassPatterns);
+        out.key = str(in.key);
+        out.tempo = str(in.tempo);
+        out.trebleInstrument = str(in.trebleInstrument);
+        out.bassInstrument = str(in.bassInstrument);
+        out.arpeggio = str(in.arpeggio);
+        out.name = str(in.name);
+        game.tunes.push_back(out);
+    }
+    for (const InternedBlip& in : blips) {
+        Blip out;
+        out.id = in.id;
+        out.notes = str(in.notes);
+        out.env = in.env;
+        out.beat = in.beat;
+        out.squareWave = str(in.squareWave);
+        out.repeat = in.repeat;
+        out.name = str(in.name);
+        game.blips.push_back(out);
+    }
+
+    game.buildIndex();
+    return game;
+}
+
+size_t BitsyInternedGame::memoryUsage() const {
+    size_t bytes = sizeof(BitsyInternedGame) + vectorBytes(avatar.inventory);
+    bytes += vectorBytes(palettes) + vectorBytes(rooms) + vectorBytes(tiles) + vectorBytes(sprites);
+    bytes += vectorBytes(items) + vectorBytes(dialogues) + vectorBytes(variables) + vectorBytes(tunes);
+    bytes += vectorBytes(blips);
+    for (const InternedRoom& room : rooms) {
+        bytes += vectorBytes(room.items) + vectorBytes(room.exits) + vectorBytes(room.endings);
+    }
+    for (const InternedBlip& blip : blips) bytes += vectorBytes(blip.env) + vectorBytes(blip.beat);
+    return bytes;
+}
+
+namespace {
+
+bool sameExit(const InternedExit& a, const InternedExit& b) {
+    return a.startPosition == b.startPosition && a.destinationRoomId == b.destinationRoomId &&
+           a.destinationPosition == b.destinationPosition && a.effect == b.effect && a.dialogueId == b.dialogueId;
+}
+
+bool sameRoom(const InternedRoom& a, const InternedRoom& b) {
+    return a.id == b.id && a.tiles == b.tiles && a.items == b.items && a.exits.size() == b.exits.size() &&
+           std::equal(a.exits.begin(), a.exits.end(), b.exits.begin(), sameExit) && a.endings == b.endings &&
+           a.paletteId == b.paletteId && a.tuneId == b.tuneId && a.name == b.name;
+}
+
+template <typename T, typename Same>
+bool sameAll(const std::vector<T>& a, const std::vector<T>& b, Same same) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), same);
+}
+
+}  // namespace
+
+bool operator==(const BitsyInternedGame& a, const BitsyInternedGame& b) {
+    return a.title == b.title && a.settings == b.settings && a.avatar.frames == b.avatar.frames &&
+           a.avatar.roomId == b.avatar.roomId && a.avatar.position == b.avatar.position &&
+           a.avatar.inventory == b.avatar.inventory &&
+           sameAll(a.palettes, b.palettes, [](const InternedPalette& x, const InternedPalette& y) {
+               return x.id == y.id && x.color1 == y.color1 && x.color2 == y.color2 && x.color3 == y.color3 &&
+                      x.name == y.name;
+           }) &&
+           sameAll(a.rooms, b.rooms, sameRoom) &&
+           sameAll(a.tiles, b.tiles, [](const InternedTile& x, const InternedTile& y) {
+               return x.id == y.id && x.frames == y.frames && x.name == y.name && x.wall == y.wall;
+           }) &&
+           sameAll(a.sprites, b.sprites, [](const InternedSprite& x, const InternedSprite& y) {
+               return x.id == y.id && x.frames == y.frames && x.name == y.name && x.dialogId == y.dialogId &&
+                      x.blipId == y.blipId && x.roomId == y.roomId && x.position == y.position;
+           }) &&
+           sameAll(a.items, b.items, [](const InternedItem& x, const InternedItem& y) {
+               return x.id == y.id && x.frames == y.frames && x.name == y.name && x.dialogId == y.dialogId &&
+                      x.blipId == y.blipId;
+           }) &&
+           sameAll(a.dialogues, b.dialogues, [](const InternedDialogue& x, const InternedDialogue& y) {
+               return x.id == y.id && x.text == y.text && x.name == y.name;
+           }) &&
+           sameAll(a.variables, b.variables, [](const InternedVariable& x, const InternedVariable& y) {
+               return x.name == y.name && x.value == y.value;
+           }) &&
+           sameAll(a.tunes, b.tunes, [](const InternedTune& x, const InternedTune& y) {
+               return x.id == y.id && x.treblePatterns == y.treblePatterns && x.bassPatterns == y.bassPatterns &&
+                      x.key == y.key && x.tempo == y.tempo && x.trebleInstrument == y.trebleInstrument &&
+                      x.bassInstrument == y.bassInstrument && x.arpeggio == y.arpeggio && x.name == y.name;
+           }) &&
+           sameAll(a.blips, b.blips, [](const InternedBlip& x, const InternedBlip& y) {
+               return x.id == y.id && x.notes == y.notes && x.env == y.env && x.beat == y.beat &&
+                      x.squareWave == y.squareWave && x.repeat == y.repeat && x.name == y.name;
+           });
+}
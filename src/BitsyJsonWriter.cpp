@@ -0,0 +1,369 @@
+#include <BitsyJsonWriter.h>
+#include <BitsyFdSink.h>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+struct StringSink {
+    std::string& out;
+    void append(const char* text, size_t length) { out.append(text, length); }
+    void put(char c) { out.push_back(c); }
+};
+
+// Emits JSON tokens into a sink, tracking where commas go. Each container pushes a "first
+// element" flag; field() and item() write the separating comma when it is not the first.
+template <typename Sink>
+class JsonWriter {
+public:
+    JsonWriter(Sink& sink, const BitsyJsonOptions& options) : sink_(sink), options_(options) {}
+
+    void game(const BitsyGameData& game) {
+        begin('{');
+        if (options_.lines) stringField("type", "game");
+        stringField("title", game.title);
+        field("settings");
+        begin('{');
+        numberField("ver_maj", game.settings.verMaj);
+        numberField("ver_min", game.settings.verMin);
+        numberField("room_format", game.settings.roomFormat);
+        numberField("dlg_compat", game.settings.dlgCompat);
+        numberField("txt_mode", game.settings.txtMode);
+        end('}');
+        if (options_.lines) endRecord();
+
+        section(kJsonPalettes, "palettes", "palette", game.palettes, [this](const Palette& palette) {
+            numberField("id", palette.id);
+            stringField("name", palette.name);
+            field("colors");
+            begin('[');
+            color(palette.color1);
+            color(palette.color2);
+            color(palette.color3);
+            end(']');
+        });
+        section(kJsonRooms, "rooms", "room", game.rooms, [this](const Room& room) { this->room(room); });
+        section(kJsonTiles, "tiles", "tile", game.tiles, [this](const Tile& tile) {
+            charField("id", tile.id);
+            stringField("name", tile.name);
+            boolField("wall", tile.wall);
+            frameField(tile.frames);
+        });
+        section(kJsonSprites, "sprites", "sprite", game.sprites, [this](const Sprite& sprite) {
+            charField("id", sprite.id);
+            stringField("name", sprite.name);
+            numberField("dialogue_id", sprite.dialogId);
+            numberField("blip_id", sprite.blipId);
+            numberField("room_id", sprite.roomId);
+            numberField("x", sprite.position.first);
+            numberField("y", sprite.position.second);
+            frameField(sprite.frames);
+        });
+        if (options_.sections & kJsonAvatar) avatar(game.avatar);
+        section(kJsonItems, "items", "item", game.items, [this](const Item& item) {
+            numberField("id", item.id);
+            stringField("name", item.name);
+            numberField("dialogue_id", item.dialogId);
+            numberField("blip_id", item.blipId);
+            frameField(item.frames);
+        });
+        section(kJsonDialogues, "dialogues", "dialogue", game.dialogues, [this](const Dialogue& dialogue) {
+            numberField("id", dialogue.id);
+            stringField("name", dialogue.name);
+            stringField("text", dialogue.text);
+        });
+        section(kJsonVariables, "variables", "variable", game.variables,
+                [this](const std::pair<const std::string, Variable>& entry) {
+                    stringField("name", entry.second.name);
+                    stringField("value", entry.second.value);
+                });
+        section(kJsonTunes, "tunes", "tune", game.tunes, [this](const Tune& tune) {
+            numberField("id", tune.id);
+            stringField("name", tune.name);
+            stringField("key", tune.key);
+            stringField("tempo", tune.tempo);
+            stringField("treble_instrument", tune.trebleInstrument);
+            stringField("bass_instrument", tune.bassInstrument);
+            stringField("arpeggio", tune.arpeggio);
+            stringArrayField("treble_patterns", tune.treblePatterns);
+            stringArrayField("bass_patterns", tune.bassPatterns);
+        });
+        section(kJsonBlips, "blips", "blip", game.blips, [this](const Blip& blip) {
+            numberField("id", blip.id);
+            stringField("name", blip.name);
+            stringField("notes", blip.notes);
+            numberArrayField("env", blip.env);
+            numberArrayField("beat", blip.beat);
+            stringField("square_wave", blip.squareWave);
+            numberField("repeat", blip.repeat);
+        });
+
+        if (!options_.lines) {
+            end('}');
+            sink_.put('\n');
+        }
+    }
+
+private:
+    static const int kMaxDepth = 8;
+
+    // Each entity is an element of its section's array, or a record of its own with NDJSON
+    template <typename Entries, typename Fields>
+    void section(unsigned bit, const char* key, const char* type, const Entries& entries, const Fields& fields) {
+        if (!(options_.sections & bit)) return;
+        if (!options_.lines) {
+            field(key);
+            begin('[');
+        }
+        for (const auto& entry : entries) {
+            if (!options_.lines) item();
+            begin('{');
+            if (options_.lines) stringField("type", type);
+            fields(entry);
+            end('}');
+            if (options_.lines) sink_.put('\n');
+        }
+        if (!options_.lines) end(']');
+    }
+
+    void room(const Room& room) {
+        numberField("id", room.id);
+        stringField("name", room.name);
+        numberField("palette_id", room.paletteId);
+        numberField("tune_id", room.tuneId);
+        field("tiles");
+        begin('[');
+        for (int y = 0; y < RoomGrid::kSize; ++y) {
+            item();
+            string(room.tiles.row(y));
+        }
+        end(']');
+        field("items");
+        begin('[');
+        for (const auto& placed : room.items) {
+            item();
+            begin('{');
+            numberField("id", placed.first);
+            numberField("x", placed.second.first);
+            numberField("y", placed.second.second);
+            end('}');
+        }
+        end(']');
+        field("exits");
+        begin('[');
+        for (const Exit& ext : room.exits) {
+            item();
+            begin('{');
+            numberField("x", ext.startPosition.first);
+            numberField("y", ext.startPosition.second);
+            numberField("destination_room_id", ext.destinationRoomId);
+            numberField("destination_x", ext.destinationPosition.first);
+            numberField("destination_y", ext.destinationPosition.second);
+            stringField("effect", ext.effect);
+            numberField("dialogue_id", ext.dialogueId);
+            end('}');
+        }
+        end(']');
+        field("endings");
+        begin('[');
+        for (const End& ending : room.endings) {
+            item();
+            begin('{');
+            numberField("dialogue_id", ending.dialogueId);
+            numberField("x", ending.position.first);
+            numberField("y", ending.position.second);
+            end('}');
+        }
+        end(']');
+    }
+
+    void avatar(const Avatar& avatar) {
+        if (options_.lines) {
+            begin('{');
+            stringField("type", "avatar");
+        } else {
+            field("avatar");
+            begin('{');
+        }
+        numberField("room_id", avatar.roomId);
+        numberField("x", avatar.position.first);
+        numberField("y", avatar.position.second);
+        numberArrayField("inventory", avatar.inventory);
+        frameField(avatar.frames);
+        end('}');
+        if (options_.lines) sink_.put('\n');
+    }
+
+    void frameField(const FrameSet& frames) {
+        field("frames");
+        begin('[');
+        for (size_t i = 0; i < frames.size(); ++i) {
+            item();
+            uint64_t bits = frames[i].bits;
+            if (options_.packedFrames) {
+                number(bits);
+                continue;
+            }
+            begin('[');
+            for (int y = 0; y < 8; ++y) {
+                char row[10];
+                row[0] = row[9] = '"';
+                for (int x = 0; x < 8; ++x) row[1 + x] = (bits >> (y * 8 + x)) & 1 ? '1' : '0';
+                item();
+                sink_.append(row, sizeof(row));
+            }
+            end(']');
+        }
+        end(']');
+    }
+
+    void color(const std::tuple<int, int, int>& rgb) {
+        item();
+        begin('[');
+        item();
+        number(std::get<0>(rgb));
+        item();
+        number(std::get<1>(rgb));
+        item();
+        number(std::get<2>(rgb));
+        end(']');
+    }
+
+    void stringArrayField(const char* key, const std::vector<std::string>& values) {
+        field(key);
+        begin('[');
+        for (const std::string& value : values) {
+            item();
+            string(value);
+        }
+        end(']');
+    }
+
+    void numberArrayField(const char* key, const std::vector<int>& values) {
+        field(key);
+        begin('[');
+        for (int value : values) {
+            item();
+            number(value);
+        }
+        end(']');
+    }
+
+    void stringField(const char* key, BitsyStringView value) {
+        field(key);
+        string(value);
+    }
+    void numberField(const char* key, int value) {
+        field(key);
+        number(value);
+    }
+    void boolField(const char* key, bool value) {
+        field(key);
+        if (value) sink_.append("true", 4);
+        else sink_.append("false", 5);
+    }
+    void charField(const char* key, char id) {
+        field(key);
+        string(BitsyStringView(&id, 1));
+    }
+
+    // Containers and separators
+    void begin(char bracket) {
+        sink_.put(bracket);
+        first_[++depth_] = true;
+    }
+    void end(char bracket) {
+        sink_.put(bracket);
+        --depth_;
+    }
+    void item() {
+        if (!first_[depth_]) sink_.put(',');
+        first_[depth_] = false;
+    }
+    void field(const char* key) {  // Keys are plain ASCII literals and need no escaping
+        item();
+        sink_.put('"');
+        sink_.append(key, std::strlen(key));
+        sink_.append("\":", 2);
+    }
+    void endRecord() {
+        end('}');
+        sink_.put('\n');
+    }
+
+    // Copy runs of characters that need no escaping in one append each
+    void string(BitsyStringView text) {
+        static const char* kHex = "0123456789abcdef";
+        sink_.put('"');
+        const char* run = text.begin();
+        for (const char* p = text.begin(); p != text.end(); ++p) {
+            unsigned char c = static_cast<unsigned char>(*p);
+            if (c >= 0x20 && c != '"' && c != '\\') continue;
+            sink_.append(run, p - run);
+            run = p + 1;
+            char escaped[6] = {'\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 15]};
+            switch (c) {
+                case '"': sink_.append("\\\"", 2); break;
+                case '\\': sink_.append("\\\\", 2); break;
+                case '\n': sink_.append("\\n", 2); break;
+                case '\r': sink_.append("\\r", 2); break;
+                case '\t': sink_.append("\\t", 2); break;
+                default: sink_.append(escaped, sizeof(escaped)); break;
+            }
+        }
+        sink_.append(run, text.end() - run);
+        sink_.put('"');
+    }
+
+    void number(int value) {
+        if (value < 0) {
+            sink_.put('-');
+            number(static_cast<uint64_t>(0u - static_cast<unsigned>(value)));
+        } else {
+            number(static_cast<uint64_t>(value));
+        }
+    }
+    void number(uint64_t value) {
+        char digits[20];
+        char* end = digits + sizeof(digits);
+        char* p = end;
+        do {
+            *--p = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value);
+        sink_.append(p, end - p);
+    }
+
+    Sink& sink_;
+    const BitsyJsonOptions& options_;
+    bool first_[kMaxDepth] = {true};
+    int depth_ = 0;
+};
+
+}  // namespace
+
+std::string BitsyJsonWriter::write(const BitsyGameData& game, const BitsyJsonOptions& options) {
+    std::string out;
+    append(game, options, out);
+    return out;
+}
+
+void BitsyJsonWriter::append(const BitsyGameData& game, const BitsyJsonOptions& options, std::string& out) {
+    StringSink sink{out};
+    JsonWriter<StringSink>(sink, options).game(game);
+}
+
+bool BitsyJsonWriter::writeFd(const BitsyGameData& game, int fd, const BitsyJsonOptions& options) {
+    BitsyFdSink sink(fd);
+    JsonWriter<BitsyFdSink>(sink, options).game(game);
+    return sink.finish();
+}
+
+bool BitsyJsonWriter::writeFile(const BitsyGameData& game, const std::string& filePath,
+                                const BitsyJsonOptions& options) {
+    int fd = ::open(filePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    bool ok = writeFd(game, fd, options);
+    return ::close(fd) == 0 && ok;
+}
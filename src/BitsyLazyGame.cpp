@@ -0,0 +1,193 @@
+#include <BitsyLazyGame.h>
+#include <BitsyGameParser.h>
+#include <BitsyLineCursor.h>
+
+namespace {
+
+// Move the single entity a block produced out of its part
+void takeEntity(BitsyGameData& part, std::unique_ptr<Palette>& out) {
+    if (!part.palettes.empty()) out.reset(new Palette(std::move(part.palettes.front())));
+}
+void takeEntity(BitsyGameData& part, std::unique_ptr<Room>& out) {
+    if (!part.rooms.empty()) out.reset(new Room(std::move(part.rooms.front())));
+}
+void takeEntity(BitsyGameData& part, std::unique_ptr<Tile>& out) {
+    if (!part.tiles.empty()) out.reset(new Tile(std::move(part.tiles.front())));
+}
+void takeEntity(BitsyGameData& part, std::unique_ptr<Sprite>& out) {
+    if (!part.sprites.empty()) out.reset(new Sprite(std::move(part.sprites.front())));
+}
+void takeEntity(BitsyGameData& part, std::unique_ptr<Item>& out) {
+    if (!part.items.empty()) out.reset(new Item(std::move(part.items.front())));
+}
+void takeEntity(BitsyGameData& part, std::unique_ptr<Dialogue>& out) {
+    if (!part.dialogues.empty()) out.reset(new Dialogue(std::move(part.dialogues.front())));
+}
+void takeEntity(BitsyGameData& part, std::unique_ptr<Tune>& out) {
+    if (!part.tunes.empty()) out.reset(new Tune(std::move(part.tunes.front())));
+}
+void takeEntity(BitsyGameData& part, std::unique_ptr<Blip>& out) {
+    if (!part.blips.empty()) out.reset(new Blip(std::move(part.blips.front())));
+}
+
+// ID on a block's first line, read the same way as the block parsers do
+int blockId(BitsyBlockType type, BitsyStringView firstLine) {
+    switch (type) {
+        case kBlockPalette:
+        case kBlockItem:
+        case kBlockDialogue: return bitsyParseInt(firstLine.substr(4));
+        case kBlockRoom:
+        case kBlockTune:
+        case kBlockBlip: return bitsyParseInt(firstLine.substr(5));
+        case kBlockTile:
+        case kBlockSprite: return static_cast<unsigned char>(firstLine[4]);
+        default: return 0;
+    }
+}
+
+}  // namespace
+
+bool BitsyLazyGame::openFile(const std::string& filePath, std::string& error) {
+    close();
+    if (!file_.open(filePath)) {
+        error = "Error: Unable to open file " + filePath;
+        return false;
+    }
+    return openBuffer(file_.data(), file_.size(), error);
+}
+
+bool BitsyLazyGame::openBuffer(const char* data, size_t size, std::string& error) {
+    if (data != file_.data()) file_.close();
+    clearIndex();
+    data_ = data;
+    size_ = size;
+
+    BitsyLineCursor cursor(data, data + size);
+    BitsyStringView line;
+    cursor.nextLine(line);
+    title = line.str();
+
+    // Index every block by the ID on its first line; settings and the avatar are parsed now
+    BitsyGameData eager;
+    BitsyGameBuilder builder(eager);
+    for (const BitsyBlock& block : BitsyBlockScanner::scan(data, size)) {
+        BitsyIndexedBlock entry;
+        entry.type = block.type;
+        entry.offset = block.offset;
+        entry.length = block.length;
+
+        BitsyLineCursor blockCursor(data + block.offset, data + block.offset + block.length);
+        blockCursor.nextLine(line);
+        try {
+            entry.id = blockId(block.type, line);
+        } catch (const std::exception& e) {
+            error = std::string("Error while parsing file: ") + e.what();
+            close();
+            return false;
+        }
+        blocks_.push_back(entry);
+
+        switch (block.type) {
+            case kBlockSettings:
+            case kBlockAvatar:
+                if (!BitsyGameParser::parseBlocks(data + block.offset, block.length, builder, error)) {
+                    close();
+                    return false;
+                }
+                ++parsedBlocks_;
+                break;
+            case kBlockPalette: palettes_.entries.push_back(entry); break;
+            case kBlockRoom: rooms_.entries.push_back(entry); break;
+            case kBlockTile: tiles_.entries.push_back(entry); break;
+            case kBlockSprite: sprites_.entries.push_back(entry); break;
+            case kBlockItem: items_.entries.push_back(entry); break;
+            case kBlockDialogue: dialogues_.entries.push_back(entry); break;
+            case kBlockVariable: variableBlocks_[line.substr(4).str()] = blocks_.size() - 1; break;
+            case kBlockTune: tunes_.entries.push_back(entry); break;
+            case kBlockBlip: blips_.entries.push_back(entry); break;
+            case kBlockOther: break;
+        }
+    }
+
+    settings = eager.settings;
+    avatar = std::move(eager.avatar);
+    palettes_.finish();
+    rooms_.finish();
+    tiles_.finish();
+    sprites_.finish();
+    items_.finish();
+    dialogues_.finish();
+    tunes_.finish();
+    blips_.finish();
+    return true;
+}
+
+void BitsyLazyGame::close() {
+    file_.close();
+    clearIndex();
+}
+
+void BitsyLazyGame::clearIndex() {
+    data_ = nullptr;
+    size_ = 0;
+    title.clear();
+    settings = Settings();
+    avatar = Avatar();
+    blocks_.clear();
+    palettes_.clear();
+    rooms_.clear();
+    tiles_.clear();
+    sprites_.clear();
+    items_.clear();
+    dialogues_.clear();
+    tunes_.clear();
+    blips_.clear();
+    variableBlocks_.clear();
+    variables_.clear();
+    parsedBlocks_ = 0;
+    error_.clear();
+}
+
+bool BitsyLazyGame::parseBlock(const BitsyIndexedBlock& block, BitsyGameData& part) const {
+    BitsyGameBuilder builder(part);
+    if (!BitsyGameParser::parseBlocks(data_ + block.offset, block.length, builder, error_)) return false;
+    ++parsedBlocks_;
+    return true;
+}
+
+template <typename T>
+const T* BitsyLazyGame::load(Section<T>& section, int id) const {
+    int slot = section.index.slot(id);
+    if (slot < 0) return nullptr;
+    std::unique_ptr<T>& cached = section.cache[slot];
+    if (!cached) {
+        BitsyGameData part;
+        if (!parseBlock(section.entries[slot], part)) return nullptr;
+        takeEntity(part, cached);
+    }
+    return cached.get();
+}
+
+const Palette* BitsyLazyGame::findPalette(int id) const { return load(palettes_, id); }
+const Room* BitsyLazyGame::findRoom(int id) const { return load(rooms_, id); }
+const Tile* BitsyLazyGame::findTile(char id) const { return load(tiles_, static_cast<unsigned char>(id)); }
+const Sprite* BitsyLazyGame::findSprite(char id) const { return load(sprites_, static_cast<unsigned char>(id)); }
+const Item* BitsyLazyGame::findItem(int id) const { return load(items_, id); }
+const Dialogue* BitsyLazyGame::findDialogue(int id) const { return load(dialogues_, id); }
+const Tune* BitsyLazyGame::findTune(int id) const { return load(tunes_, id); }
+const Blip* BitsyLazyGame::findBlip(int id) const { return load(blips_, id); }
+
+const Variable* BitsyLazyGame::findVariable(const std::string& name) const {
+    std::map<std::string, Variable>::const_iterator cached = variables_.find(name);
+    if (cached != variables_.end()) return &cached->second;
+
+    std::map<std::string, size_t>::const_iterator it = variableBlocks_.find(name);
+    if (it == variableBlocks_.end()) return nullptr;
+    BitsyGameData part;
+    if (!parseBlock(blocks_[it->second], part) || part.variables.empty()) return nullptr;
+    return &(variables_[name] = std::move(part.variables.begin()->second));
+}
+
+BitsyGameData BitsyLazyGame::toGameData() const {
+    return BitsyGameParser::parseGameBuffer(data_, size_);
+}
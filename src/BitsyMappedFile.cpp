@@ -0,0 +1,60 @@
+#include <BitsyMappedFile.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+BitsyMappedFile::~BitsyMappedFile() {
+    close();
+}
+
+bool BitsyMappedFile::open(const std::string& filePath) {
+    close();
+
+    int fd = ::open(filePath.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ > 0) {
+            void* mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED) {
+                madvise(mapping, size_, MADV_SEQUENTIAL);
+                data_ = static_cast<const char*>(mapping);
+                mapped_ = true;
+            }
+        }
+        if (size_ == 0 || mapped_) {
+            ::close(fd);  // The mapping stays valid after the descriptor is closed
+            open_ = true;
+            return true;
+        }
+    }
+
+    // Not mappable: read the whole stream
+    char chunk[65536];
+    ssize_t count;
+    while ((count = ::read(fd, chunk, sizeof(chunk))) > 0) {
+        buffer_.append(chunk, static_cast<size_t>(count));
+    }
+    ::close(fd);
+    if (count < 0) {
+        close();
+        return false;
+    }
+
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+    open_ = true;
+    return true;
+}
+
+void BitsyMappedFile::close() {
+    if (mapped_) munmap(const_cast<char*>(data_), size_);
+    std::string().swap(buffer_);
+    mapped_ = false;
+    data_ = nullptr;
+    size_ = 0;
+    open_ = false;
+}
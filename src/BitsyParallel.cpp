@@ -0,0 +1,104 @@
+#include <BitsyParallel.h>
+
+BitsyWorkStealingQueue::BitsyWorkStealingQueue(unsigned workerCount) {
+    if (workerCount == 0) workerCount = 1;
+    for (unsigned i = 0; i < workerCount; ++i) {
+        queues_.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+    }
+}
+
+void BitsyWorkStealingQueue::push(unsigned worker, size_t task) {
+    WorkerQueue& queue = *queues_[worker % queues_.size()];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back(task);
+}
+
+bool BitsyWorkStealingQueue::pop(unsigned worker, size_t& task) {
+    size_t count = queues_.size();
+    for (size_t i = 0; i < count; ++i) {
+        WorkerQueue& queue = *queues_[(worker + i) % count];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) continue;
+        if (i == 0) {
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+        } else {
+            task = queue.tasks.back();
+            queue.tasks.pop_back();
+        }
+        return true;
+    }
+    return false;
+}
+
+BitsyExecutor::BitsyExecutor(unsigned threadCount) {
+    if (threadCount == 0) threadCount = bitsyDefaultThreadCount();
+    for (unsigned i = 0; i < threadCount; ++i) workers_.push_back(std::thread([this]() { work(); }));
+}
+
+BitsyExecutor::~BitsyExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (size_t i = 0; i < workers_.size(); ++i) workers_[i].join();
+}
+
+void BitsyExecutor::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    wake_.notify_one();
+}
+
+size_t BitsyExecutor::pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tasks_.size();
+}
+
+BitsyExecutor& BitsyExecutor::shared() {
+    static BitsyExecutor executor;
+    return executor;
+}
+
+void BitsyExecutor::work() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty()) return;  // Stopping, and nothing left to run
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+unsigned bitsyDefaultThreadCount() {
+    unsigned count = std::thread::hardware_concurrency();
+    return count > 0 ? count : 1;
+}
+
+void bitsyParallelFor(size_t count, unsigned threadCount, const std::function<void(unsigned, size_t)>& task) {
+    if (threadCount == 0) threadCount = bitsyDefaultThreadCount();
+    if (threadCount > count) threadCount = static_cast<unsigned>(count);
+    if (threadCount <= 1) {
+        for (size_t i = 0; i < count; ++i) task(0, i);
+        return;
+    }
+
+    BitsyWorkStealingQueue queue(threadCount);
+    for (size_t i = 0; i < count; ++i) queue.push(static_cast<unsigned>(i % threadCount), i);
+
+    std::vector<std::thread> workers;
+    for (unsigned w = 0; w < threadCount; ++w) {
+        workers.push_back(std::thread([&queue, &task, w]() {
+            size_t index;
+            while (queue.pop(w, index)) task(w, index);
+        }));
+    }
+    for (size_t i = 0; i < workers.size(); ++i) workers[i].join();
+}
@@ -0,0 +1,45 @@
+#include <BitsyParseStats.h>
+#include <BitsyJsonString.h>
+#include <sstream>
+
+void BitsyParseStats::reset() {
+    uint64_t (*counter)() = allocationCounter;
+    *this = BitsyParseStats();
+    allocationCounter = counter;
+}
+
+std::string BitsyParseStats::toJson() const {
+    std::ostringstream out;
+    out << "{\"ok\": " << (ok ? "true" : "false");
+    if (!ok) {
+        out << ", \"error\": ";
+        bitsyAppendJsonString(out, error);
+        out << ", \"error_line\": " << errorLine;
+    }
+    out << ", \"bytes\": " << bytes << ", \"lines\": " << lines << ", \"blank_lines\": " << blankLines
+        << ", \"comment_lines\": " << commentLines << ", \"unrecognized_lines\": " << unrecognizedLines
+        << ", \"total_seconds\": " << totalSeconds << ", \"index_seconds\": " << indexSeconds;
+    if (allocationCounter) out << ", \"allocations\": " << allocations;
+
+    out << ", \"sections\": {";
+    bool first = true;
+    for (int type = kBlockOther + 1; type < kSectionCount; ++type) {
+        const Section& section = sections[type];
+        if (!first) out << ", ";
+        first = false;
+        out << '"' << BitsyBlockScanner::typeName(static_cast<BitsyBlockType>(type)) << "\": {\"blocks\": "
+            << section.blocks << ", \"skipped_blocks\": " << section.skippedBlocks << ", \"bytes\": " << section.bytes
+            << ", \"lines\": " << section.lines << ", \"seconds\": " << section.seconds;
+        if (allocationCounter) out << ", \"allocations\": " << section.allocations;
+        out << '}';
+    }
+    out << "}, \"unrecognized_samples\": [";
+    for (size_t i = 0; i < unrecognizedSamples.size(); ++i) {
+        if (i) out << ", ";
+        out << "{\"line\": " << unrecognizedSamples[i].line << ", \"text\": ";
+        bitsyAppendJsonString(out, unrecognizedSamples[i].text);
+        out << '}';
+    }
+    out << "]}";
+    return out.str();
+}
@@ -0,0 +1,245 @@
+#include <BitsyRenderer.h>
+#include <BitsyParallel.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+const int kRowBytes = BitsyRenderer::kTileSize * 3;  // One frame row of RGB pixels
+
+// kRowMasks[bits] holds 0xFF for each byte of the pixels set in an 8-pixel row
+struct RowMasks {
+    uint8_t masks[256][kRowBytes];
+
+    RowMasks() {
+        for (int bits = 0; bits < 256; ++bits) {
+            for (int x = 0; x < BitsyRenderer::kTileSize; ++x) {
+                uint8_t value = (bits >> x) & 1 ? 0xFF : 0x00;
+                masks[bits][3 * x] = masks[bits][3 * x + 1] = masks[bits][3 * x + 2] = value;
+            }
+        }
+    }
+};
+
+const RowMasks& rowMasks() {
+    static const RowMasks table;
+    return table;
+}
+
+// A color repeated across one frame row
+struct RowColor {
+    uint8_t bytes[kRowBytes];
+
+    explicit RowColor(const std::tuple<int, int, int>& rgb) {
+        for (int x = 0; x < BitsyRenderer::kTileSize; ++x) {
+            bytes[3 * x] = static_cast<uint8_t>(std::get<0>(rgb));
+            bytes[3 * x + 1] = static_cast<uint8_t>(std::get<1>(rgb));
+            bytes[3 * x + 2] = static_cast<uint8_t>(std::get<2>(rgb));
+        }
+    }
+};
+
+// Draw the set pixels of frame at tile cell (cellX, cellY) in color
+void drawFrame(BitsyImage& image, int cellX, int cellY, PackedFrame frame, const RowColor& color) {
+    const RowMasks& table = rowMasks();
+    const int stride = image.width * 3;
+    const int left = cellX * BitsyRenderer::kTileSize;
+    const int top = cellY * BitsyRenderer::kTileSize;
+    uint8_t* origin = &image.pixels[(top * image.width + left) * 3];
+    for (int y = 0; y < BitsyRenderer::kTileSize; ++y) {
+        uint8_t bits = frame.row(y);
+        if (!bits) continue;
+        const uint8_t* mask = table.masks[bits];
+        uint8_t* out = origin + y * stride;
+        for (int i = 0; i < kRowBytes; ++i) {
+            out[i] = static_cast<uint8_t>((out[i] & ~mask[i]) | (color.bytes[i] & mask[i]));
+        }
+    }
+}
+
+PackedFrame pickFrame(const FrameSet& frames, int frame) {
+    if (frames.empty()) return PackedFrame();
+    return frames[static_cast<size_t>(frame) % frames.size()];
+}
+
+bool inRoom(std::pair<int, int> position) {
+    return position.first >= 0 && position.first < RoomGrid::kSize && position.second >= 0 &&
+           position.second < RoomGrid::kSize;
+}
+
+struct CrcTable {
+    uint32_t entries[256];
+
+    CrcTable() {
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            entries[n] = c;
+        }
+    }
+};
+
+uint32_t crc32(const uint8_t* data, size_t size) {
+    static const CrcTable table;
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) crc = table.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+void appendBigEndian(std::string& out, uint32_t value) {
+    out += static_cast<char>(value >> 24);
+    out += static_cast<char>(value >> 16);
+    out += static_cast<char>(value >> 8);
+    out += static_cast<char>(value);
+}
+
+// Length, type, data and CRC of one PNG chunk
+void appendChunk(std::string& out, const char* type, const std::string& data) {
+    appendBigEndian(out, static_cast<uint32_t>(data.size()));
+    size_t start = out.size();
+    out.append(type, 4);
+    out += data;
+    appendBigEndian(out, crc32(reinterpret_cast<const uint8_t*>(out.data() + start), out.size() - start));
+}
+
+}  // namespace
+
+void BitsyRenderer::renderRoom(const BitsyGameData& game, const Room& room, int frame, BitsyImage& image) {
+    image.width = kImageSize;
+    image.height = kImageSize;
+    image.pixels.resize(kImageSize * kImageSize * 3);
+
+    const Palette* palette = game.findPalette(room.paletteId);
+    if (!palette && !game.palettes.empty()) palette = &game.palettes.front();
+    std::tuple<int, int, int> black(0, 0, 0), white(255, 255, 255);
+    RowColor background(palette ? palette->color1 : black);
+    RowColor tileColor(palette ? palette->color2 : white);
+    RowColor spriteColor(palette ? palette->color3 : white);
+
+    for (int y = 0; y < kImageSize; ++y) {
+        uint8_t* row = &image.pixels[y * kImageSize * 3];
+        for (int x = 0; x < RoomGrid::kSize; ++x) std::memcpy(row + x * kRowBytes, background.bytes, kRowBytes);
+    }
+
+    for (int y = 0; y < RoomGrid::kSize; ++y) {
+        for (int x = 0; x < RoomGrid::kSize; ++x) {
+            char id = room.tiles.at(x, y);
+            if (id == '0') continue;  // Empty cell
+            const Tile* tile = game.findTile(id);
+            if (tile) drawFrame(image, x, y, pickFrame(tile->frames, frame), tileColor);
+        }
+    }
+
+    for (const auto& placed : room.items) {
+        const Item* item = game.findItem(placed.first);
+        if (item && inRoom(placed.second)) {
+            drawFrame(image, placed.second.first, placed.second.second, pickFrame(item->frames, frame), spriteColor);
+        }
+    }
+    for (const Sprite& sprite : game.sprites) {
+        if (sprite.roomId == room.id && inRoom(sprite.position)) {
+            drawFrame(image, sprite.position.first, sprite.position.second, pickFrame(sprite.frames, frame),
+                      spriteColor);
+        }
+    }
+    const Avatar& avatar = game.avatar;
+    if (avatar.roomId == room.id && inRoom(avatar.position)) {
+        drawFrame(image, avatar.position.first, avatar.position.second, pickFrame(avatar.frames, frame), spriteColor);
+    }
+}
+
+BitsyImage BitsyRenderer::renderRoom(const BitsyGameData& game, const Room& room, int frame) {
+    BitsyImage image;
+    renderRoom(game, room, frame, image);
+    return image;
+}
+
+std::string BitsyRenderer::encodePpm(const BitsyImage& image) {
+    char header[32];
+    int length = std::snprintf(header, sizeof(header), "P6\n%d %d\n255\n", image.width, image.height);
+    std::string out(header, length);
+    out.append(reinterpret_cast<const char*>(image.pixels.data()), image.pixels.size());
+    return out;
+}
+
+std::string BitsyRenderer::encodePng(const BitsyImage& image) {
+    std::string out("\x89PNG\r\n\x1a\n", 8);
+
+    std::string header;
+    appendBigEndian(header, image.width);
+    appendBigEndian(header, image.height);
+    header += '\x08';  // 8 bits per channel
+    header += '\x02';  // Truecolor
+    header.append(3, '\0');  // Deflate, adaptive filtering, no interlace
+    appendChunk(out, "IHDR", header);
+
+    // Scanlines with filter type 0, wrapped in a zlib stream of stored (uncompressed) blocks
+    const size_t rowBytes = image.width * 3;
+    std::string raw;
+    raw.reserve(image.height * (rowBytes + 1));
+    for (int y = 0; y < image.height; ++y) {
+        raw += '\0';
+        raw.append(reinterpret_cast<const char*>(&image.pixels[y * rowBytes]), rowBytes);
+    }
+
+    std::string zlib("\x78\x01", 2);
+    const size_t kMaxStored = 65535;
+    size_t pos = 0;
+    do {
+        size_t length = std::min(kMaxStored, raw.size() - pos);
+        bool last = pos + length == raw.size();
+        zlib += static_cast<char>(last ? 1 : 0);
+        zlib += static_cast<char>(length & 0xFF);
+        zlib += static_cast<char>(length >> 8);
+        zlib += static_cast<char>(~length & 0xFF);
+        zlib += static_cast<char>((~length >> 8) & 0xFF);
+        zlib.append(raw, pos, length);
+        pos += length;
+    } while (pos < raw.size());
+
+    uint32_t a = 1, b = 0;  // Adler-32 of the uncompressed data
+    for (unsigned char c : raw) {
+        a = (a + c) % 65521;
+        b = (b + a) % 65521;
+    }
+    appendBigEndian(zlib, (b << 16) | a);
+    appendChunk(out, "IDAT", zlib);
+    appendChunk(out, "IEND", std::string());
+    return out;
+}
+
+bool BitsyRenderer::writeImage(const BitsyImage& image, const std::string& filePath, BitsyImageFormat format) {
+    std::string data = format == kImagePng ? encodePng(image) : encodePpm(image);
+    FILE* file = std::fopen(filePath.c_str(), "wb");
+    if (!file) return false;
+    bool ok = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    return std::fclose(file) == 0 && ok;
+}
+
+std::vector<BitsyRenderJob> BitsyRenderer::roomJobs(const BitsyGameData& game, const std::string& pathPrefix,
+                                                    BitsyImageFormat format) {
+    std::vector<BitsyRenderJob> jobs;
+    for (const Room& room : game.rooms) {
+        BitsyRenderJob job;
+        job.game = &game;
+        job.room = &room;
+        job.outputPath = pathPrefix + "room" + std::to_string(room.id) + (format == kImagePng ? ".png" : ".ppm");
+        jobs.push_back(job);
+    }
+    return jobs;
+}
+
+size_t BitsyRenderer::renderBatch(const std::vector<BitsyRenderJob>& jobs, BitsyImageFormat format, int frame,
+                                  unsigned threadCount) {
+    if (threadCount == 0) threadCount = bitsyDefaultThreadCount();
+    std::vector<BitsyImage> images(threadCount);
+    std::atomic<size_t> failures(0);
+    bitsyParallelFor(jobs.size(), threadCount, [&](unsigned worker, size_t index) {
+        const BitsyRenderJob& job = jobs[index];
+        renderRoom(*job.game, *job.room, frame, images[worker]);
+        if (!writeImage(images[worker], job.outputPath, format)) ++failures;
+    });
+    return failures;
+}
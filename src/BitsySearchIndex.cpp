@@ -0,0 +1,405 @@
+#include <BitsySearchIndex.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+bool postingLess(const BitsyIdxPosting& a, const BitsyIdxPosting& b) {
+    if (a.game != b.game) return a.game < b.game;
+    if (a.field != b.field) return a.field < b.field;
+    if (a.entityId != b.entityId) return a.entityId < b.entityId;
+    return a.position < b.position;
+}
+
+bool sameEntity(const BitsyIdxPosting& a, const BitsyIdxPosting& b) {
+    return a.game == b.game && a.field == b.field && a.entityId == b.entityId;
+}
+
+// One hit per run of postings for the same entity; the postings must be sorted
+void appendHits(const BitsyIdxPosting* begin, const BitsyIdxPosting* end, std::vector<BitsySearchHit>& hits) {
+    for (const BitsyIdxPosting* p = begin; p != end; ++p) {
+        if (p == begin || !sameEntity(p[-1], *p)) {
+            BitsySearchHit hit;
+            hit.game = p->game;
+            hit.field = static_cast<BitsySearchField>(p->field);
+            hit.entityId = p->entityId;
+            hits.push_back(hit);
+        }
+        ++hits.back().matches;
+    }
+}
+
+// Byte order, as std::string sorts the terms when the index is written
+bool textLess(BitsyStringView a, BitsyStringView b) {
+    size_t common = std::min(a.size, b.size);
+    int order = common ? std::memcmp(a.data, b.data, common) : 0;
+    return order < 0 || (order == 0 && a.size < b.size);
+}
+
+bool startsWith(BitsyStringView text, BitsyStringView start) {
+    return text.size >= start.size && std::memcmp(text.data, start.data, start.size) == 0;
+}
+
+bool isWordByte(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c >= 0x80;
+}
+
+template <typename T>
+void appendSection(std::string& out, BitsyIdxHeader& header, BitsyIdxSection section, const std::vector<T>& records) {
+    out.append((8 - out.size() % 8) % 8, '\0');
+    header.sections[section].offset = static_cast<uint32_t>(out.size());
+    header.sections[section].count = static_cast<uint32_t>(records.size());
+    header.sections[section].recordSize = sizeof(T);
+    if (!records.empty()) out.append(reinterpret_cast<const char*>(&records[0]), records.size() * sizeof(T));
+}
+
+}  // namespace
+
+void BitsySearchIndex::tokenize(BitsyStringView text, std::vector<std::string>& words) {
+    words.clear();
+    std::string word;
+    for (size_t i = 0; i < text.size; ++i) {
+        unsigned char c = static_cast<unsigned char>(text.data[i]);
+        if (c == '{') {
+            // A tag is a brace group without spaces; script blocks with spaces keep their words.
+            // Either way the brace ends the current word.
+            size_t close = i + 1;
+            while (close < text.size && text.data[close] != '}' &&
+                   !std::isspace(static_cast<unsigned char>(text.data[close]))) {
+                ++close;
+            }
+            if (close < text.size && text.data[close] == '}') i = close;
+        }
+        if (isWordByte(c)) {
+            word.push_back(c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : static_cast<char>(c));
+        } else if (!word.empty()) {
+            words.push_back(word);
+            word.clear();
+        }
+    }
+    if (!word.empty()) words.push_back(word);
+}
+
+bool BitsySearchIndex::open(const std::string& filePath) {
+    header_ = nullptr;
+    if (!file_.open(filePath)) return false;
+    data_ = file_.data();
+    size_ = file_.size();
+    return validate();
+}
+
+bool BitsySearchIndex::openBuffer(const char* data, size_t size) {
+    file_.close();
+    header_ = nullptr;
+    data_ = data;
+    size_ = size;
+    return validate();
+}
+
+bool BitsySearchIndex::validate() {
+    static const uint32_t kRecordSizes[kIdxSectionCount] = {1, sizeof(BitsyIdxGame), sizeof(BitsyIdxTerm),
+                                                             sizeof(BitsyIdxPosting)};
+
+    if (!data_ || size_ < sizeof(BitsyIdxHeader) || reinterpret_cast<uintptr_t>(data_) % 8 != 0) return false;
+    const BitsyIdxHeader* header = reinterpret_cast<const BitsyIdxHeader*>(data_);
+    if (std::memcmp(header->magic, "BITSYIDX", 8) != 0 || header->version != BitsyIdxHeader::kVersion ||
+        header->byteOrder != BitsyBinHeader::kByteOrder || header->sectionCount != kIdxSectionCount) {
+        return false;
+    }
+
+    for (int i = 0; i < kIdxSectionCount; ++i) {
+        const BitsyBinSectionEntry& section = header->sections[i];
+        if (section.recordSize != kRecordSizes[i] || section.offset % 8 != 0) return false;
+        if (section.offset > size_ || uint64_t(section.count) * section.recordSize > size_ - section.offset) {
+            return false;
+        }
+    }
+
+    // Queries index postings through the terms without further checks
+    header_ = header;
+    uint32_t postingTotal = header->sections[kIdxPostings].count;
+    for (size_t i = 0; i < termCount(); ++i) {
+        const BitsyIdxTerm& term = terms()[i];
+        if (term.firstPosting > postingTotal || term.postingCount > postingTotal - term.firstPosting) {
+            header_ = nullptr;
+            return false;
+        }
+    }
+    return true;
+}
+
+const BitsyIdxTerm* BitsySearchIndex::terms() const {
+    return reinterpret_cast<const BitsyIdxTerm*>(data_ + header_->sections[kIdxTerms].offset);
+}
+
+const BitsyIdxPosting* BitsySearchIndex::postings() const {
+    return reinterpret_cast<const BitsyIdxPosting*>(data_ + header_->sections[kIdxPostings].offset);
+}
+
+BitsyStringView BitsySearchIndex::string(BitsyBinString ref) const {
+    const BitsyBinSectionEntry& strings = header_->sections[kIdxStrings];
+    if (ref.offset > strings.count || ref.length > strings.count - ref.offset) return BitsyStringView();
+    return BitsyStringView(data_ + strings.offset + ref.offset, ref.length);
+}
+
+BitsyStringView BitsySearchIndex::gameKey(uint32_t game) const {
+    if (game >= gameCount()) return BitsyStringView();
+    const BitsyIdxGame* games = reinterpret_cast<const BitsyIdxGame*>(data_ + header_->sections[kIdxGames].offset);
+    return string(games[game].key);
+}
+
+BitsyStringView BitsySearchIndex::termText(size_t term) const {
+    return term < termCount() ? string(terms()[term].text) : BitsyStringView();
+}
+
+const BitsyIdxTerm* BitsySearchIndex::findTerm(BitsyStringView word) const {
+    const BitsyIdxTerm* begin = terms();
+    const BitsyIdxTerm* end = begin + termCount();
+    const BitsyIdxTerm* it = std::lower_bound(begin, end, word, [this](const BitsyIdxTerm& term, BitsyStringView key) {
+        return textLess(string(term.text), key);
+    });
+    return it != end && string(it->text) == word ? it : nullptr;
+}
+
+std::vector<BitsySearchHit> BitsySearchIndex::term(BitsyStringView word) const {
+    std::vector<BitsySearchHit> hits;
+    std::vector<std::string> words;
+    tokenize(word, words);
+    if (!header_ || words.size() != 1) return hits;
+    const BitsyIdxTerm* found = findTerm(words[0]);
+    if (found) {
+        const BitsyIdxPosting* first = postings() + found->firstPosting;
+        appendHits(first, first + found->postingCount, hits);
+    }
+    return hits;
+}
+
+std::vector<BitsySearchHit> BitsySearchIndex::prefix(BitsyStringView start) const {
+    std::vector<BitsySearchHit> hits;
+    std::vector<std::string> words;
+    tokenize(start, words);
+    if (!header_ || words.size() != 1) return hits;
+    BitsyStringView key(words[0]);
+
+    // Matching terms are one run in sorted order; gather their postings and re-sort them together
+    const BitsyIdxTerm* begin = terms();
+    const BitsyIdxTerm* end = begin + termCount();
+    const BitsyIdxTerm* it = std::lower_bound(begin, end, key, [this](const BitsyIdxTerm& term, BitsyStringView k) {
+        return textLess(string(term.text), k);
+    });
+    std::vector<BitsyIdxPosting> matched;
+    for (; it != end && startsWith(string(it->text), key); ++it) {
+        const BitsyIdxPosting* first = postings() + it->firstPosting;
+        matched.insert(matched.end(), first, first + it->postingCount);
+    }
+    std::sort(matched.begin(), matched.end(), postingLess);
+    if (!matched.empty()) appendHits(&matched[0], &matched[0] + matched.size(), hits);
+    return hits;
+}
+
+std::vector<BitsySearchHit> BitsySearchIndex::phrase(BitsyStringView text) const {
+    std::vector<BitsySearchHit> hits;
+    std::vector<std::string> words;
+    tokenize(text, words);
+    if (!header_ || words.empty()) return hits;
+
+    // Occurrences of the first word, kept while word i follows i positions later
+    std::vector<BitsyIdxPosting> starts;
+    for (size_t i = 0; i < words.size(); ++i) {
+        const BitsyIdxTerm* found = findTerm(words[i]);
+        if (!found) return hits;
+        const BitsyIdxPosting* first = postings() + found->firstPosting;
+        const BitsyIdxPosting* last = first + found->postingCount;
+        if (i == 0) {
+            starts.assign(first, last);
+            continue;
+        }
+        size_t kept = 0;
+        for (const BitsyIdxPosting& start : starts) {
+            BitsyIdxPosting next = start;
+            next.position += static_cast<uint32_t>(i);
+            if (std::binary_search(first, last, next, postingLess)) starts[kept++] = start;
+        }
+        starts.resize(kept);
+    }
+    if (!starts.empty()) appendHits(&starts[0], &starts[0] + starts.size(), hits);
+    return hits;
+}
+
+std::vector<BitsySearchHit> BitsySearchIndex::search(BitsyStringView query) const {
+    std::vector<std::string> words;
+    tokenize(query, words);
+    if (words.size() > 1) return phrase(query);
+    size_t end = query.size;
+    while (end > 0 && std::isspace(static_cast<unsigned char>(query.data[end - 1]))) --end;
+    if (end > 0 && query.data[end - 1] == '*') return prefix(query);
+    return term(query);
+}
+
+bool BitsySearchIndexBuilder::load(const BitsySearchIndex& index) {
+    games_.clear();
+    keySlots_.clear();
+    terms_.clear();
+    termIds_.clear();
+    if (!index.header_) return false;
+    for (uint32_t game = 0; game < index.gameCount(); ++game) slot(index.gameKey(game).str());
+
+    const BitsyIdxTerm* terms = index.terms();
+    const BitsyIdxPosting* postings = index.postings();
+    for (size_t t = 0; t < index.termCount(); ++t) {
+        uint32_t id = termId(index.string(terms[t].text).str());
+        const BitsyIdxPosting* first = postings + terms[t].firstPosting;
+        for (const BitsyIdxPosting* p = first; p != first + terms[t].postingCount; ++p) {
+            if (p->game >= games_.size()) continue;
+            Posting posting = {id, p->entityId, p->position, p->field};
+            games_[p->game].postings.push_back(posting);
+        }
+    }
+    return true;
+}
+
+void BitsySearchIndexBuilder::addGame(const std::string& key, const BitsyGameData& game) {
+    Game& out = slot(key);
+    for (const Dialogue& dialogue : game.dialogues) {
+        addField(out, kSearchDialogueText, dialogue.id, dialogue.text);
+        addField(out, kSearchDialogueName, dialogue.id, dialogue.name);
+    }
+    for (const Room& room : game.rooms) addField(out, kSearchRoomName, room.id, room.name);
+    for (const Sprite& sprite : game.sprites) {
+        addField(out, kSearchSpriteName, static_cast<unsigned char>(sprite.id), sprite.name);
+    }
+    for (const Item& item : game.items) addField(out, kSearchItemName, item.id, item.name);
+    for (const Tune& tune : game.tunes) addField(out, kSearchTuneName, tune.id, tune.name);
+    for (const Blip& blip : game.blips) addField(out, kSearchBlipName, blip.id, blip.name);
+}
+
+bool BitsySearchIndexBuilder::removeGame(const std::string& key) {
+    std::unordered_map<std::string, size_t>::iterator it = keySlots_.find(key);
+    if (it == keySlots_.end()) return false;
+    Game& game = games_[it->second];
+    game.live = false;
+    game.key.clear();
+    std::vector<Posting>().swap(game.postings);
+    keySlots_.erase(it);
+    return true;
+}
+
+void BitsySearchIndexBuilder::addField(Game& game, BitsySearchField field, int entityId, BitsyStringView text) {
+    BitsySearchIndex::tokenize(text, words_);
+    for (size_t i = 0; i < words_.size(); ++i) {
+        Posting posting = {termId(words_[i]), entityId, static_cast<uint32_t>(i), static_cast<uint8_t>(field)};
+        game.postings.push_back(posting);
+    }
+}
+
+uint32_t BitsySearchIndexBuilder::termId(const std::string& text) {
+    std::unordered_map<std::string, uint32_t>::const_iterator it = termIds_.find(text);
+    if (it != termIds_.end()) return it->second;
+    uint32_t id = static_cast<uint32_t>(terms_.size());
+    terms_.push_back(text);
+    termIds_[text] = id;
+    return id;
+}
+
+BitsySearchIndexBuilder::Game& BitsySearchIndexBuilder::slot(const std::string& key) {
+    std::unordered_map<std::string, size_t>::const_iterator it = keySlots_.find(key);
+    if (it != keySlots_.end()) {
+        games_[it->second].postings.clear();
+        return games_[it->second];
+    }
+    keySlots_[key] = games_.size();
+    Game game;
+    game.key = key;
+    game.live = true;
+    games_.push_back(game);
+    return games_.back();
+}
+
+std::string BitsySearchIndexBuilder::serialize() const {
+    // Live games are numbered in the order they were first added
+    std::vector<uint32_t> gameNumbers(games_.size(), 0);
+    std::vector<BitsyIdxGame> games;
+    std::string strings;
+    for (size_t g = 0; g < games_.size(); ++g) {
+        if (!games_[g].live) continue;
+        gameNumbers[g] = static_cast<uint32_t>(games.size());
+        BitsyIdxGame record;
+        record.key.offset = static_cast<uint32_t>(strings.size());
+        record.key.length = static_cast<uint32_t>(games_[g].key.size());
+        strings += games_[g].key;
+        games.push_back(record);
+    }
+
+    // Terms still in use, sorted, each owning a run of postings
+    std::vector<uint32_t> counts(terms_.size(), 0);
+    for (const Game& game : games_) {
+        for (const Posting& posting : game.postings) ++counts[posting.term];
+    }
+    std::vector<uint32_t> order;
+    for (uint32_t t = 0; t < terms_.size(); ++t) {
+        if (counts[t] > 0) order.push_back(t);
+    }
+    std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) { return terms_[a] < terms_[b]; });
+
+    std::vector<BitsyIdxTerm> terms(order.size());
+    std::vector<uint32_t> next(terms_.size(), 0);  // Next free posting slot per term
+    uint32_t total = 0;
+    for (size_t i = 0; i < order.size(); ++i) {
+        const std::string& text = terms_[order[i]];
+        terms[i].text.offset = static_cast<uint32_t>(strings.size());
+        terms[i].text.length = static_cast<uint32_t>(text.size());
+        strings += text;
+        terms[i].firstPosting = total;
+        terms[i].postingCount = counts[order[i]];
+        next[order[i]] = total;
+        total += counts[order[i]];
+    }
+
+    std::vector<BitsyIdxPosting> postings(total);
+    for (size_t g = 0; g < games_.size(); ++g) {
+        for (const Posting& posting : games_[g].postings) {
+            BitsyIdxPosting& out = postings[next[posting.term]++];
+            out.game = gameNumbers[g];
+            out.entityId = posting.entityId;
+            out.position = posting.position;
+            out.field = posting.field;
+        }
+    }
+    for (const BitsyIdxTerm& term : terms) {
+        std::sort(postings.begin() + term.firstPosting, postings.begin() + term.firstPosting + term.postingCount,
+                  postingLess);
+    }
+
+    BitsyIdxHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "BITSYIDX", 8);
+    header.version = BitsyIdxHeader::kVersion;
+    header.byteOrder = BitsyBinHeader::kByteOrder;
+    header.sectionCount = kIdxSectionCount;
+
+    std::string out(sizeof(header), '\0');
+    appendSection(out, header, kIdxStrings, std::vector<char>(strings.begin(), strings.end()));
+    appendSection(out, header, kIdxGames, games);
+    appendSection(out, header, kIdxTerms, terms);
+    appendSection(out, header, kIdxPostings, postings);
+    std::memcpy(&out[0], &header, sizeof(header));
+    return out;
+}
+
+bool BitsySearchIndexBuilder::writeFile(const std::string& filePath) const {
+    std::string image = serialize();
+    std::string tempPath = filePath + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) return false;
+        file.write(image.data(), image.size());
+        if (!file) {
+            std::remove(tempPath.c_str());
+            return false;
+        }
+    }
+    return std::rename(tempPath.c_str(), filePath.c_str()) == 0;
+}
@@ -0,0 +1,240 @@
+#include <BitsySimulation.h>
+#include <cstdlib>
+
+namespace {
+
+bool inRoom(int x, int y) {
+    return x >= 0 && x < RoomGrid::kSize && y >= 0 && y < RoomGrid::kSize;
+}
+
+}  // namespace
+
+int BitsyCellBitmap::first() const {
+    for (int w = 0; w < 4; ++w) {
+        if (words[w]) return w * 64 + __builtin_ctzll(words[w]);
+    }
+    return -1;
+}
+
+size_t BitsyCellBitmap::count() const {
+    size_t total = 0;
+    for (int w = 0; w < 4; ++w) total += __builtin_popcountll(words[w]);
+    return total;
+}
+
+BitsyCellBitmap BitsyCellBitmap::grown() const {
+    // Rows are 16 bits, so moving along x is a shift by one with the wrapped column masked
+    // off, and moving along y is a shift by 16 carried across words
+    const uint64_t kColumn0 = 0x0001000100010001ull;
+    const uint64_t kColumn15 = 0x8000800080008000ull;
+    BitsyCellBitmap out;
+    for (int w = 0; w < 4; ++w) {
+        uint64_t up = (words[w] >> 16) | (w < 3 ? words[w + 1] << 48 : 0);
+        uint64_t down = (words[w] << 16) | (w > 0 ? words[w - 1] >> 48 : 0);
+        out.words[w] = words[w] | ((words[w] << 1) & ~kColumn0) | ((words[w] >> 1) & ~kColumn15) | up | down;
+    }
+    return out;
+}
+
+BitsyCellBitmap BitsyCellBitmap::operator&(const BitsyCellBitmap& other) const {
+    BitsyCellBitmap out;
+    for (int w = 0; w < 4; ++w) out.words[w] = words[w] & other.words[w];
+    return out;
+}
+
+BitsyCellBitmap BitsyCellBitmap::operator|(const BitsyCellBitmap& other) const {
+    BitsyCellBitmap out;
+    for (int w = 0; w < 4; ++w) out.words[w] = words[w] | other.words[w];
+    return out;
+}
+
+BitsyCellBitmap BitsyCellBitmap::operator~() const {
+    BitsyCellBitmap out;
+    for (int w = 0; w < 4; ++w) out.words[w] = ~words[w];
+    return out;
+}
+
+bool BitsyCellBitmap::operator==(const BitsyCellBitmap& other) const {
+    return words[0] == other.words[0] && words[1] == other.words[1] && words[2] == other.words[2] &&
+           words[3] == other.words[3];
+}
+
+BitsyWorld::BitsyWorld(const BitsyGameData& game) : itemCount_(game.items.size()) {
+    bool wallTile[256] = {};
+    for (const Tile& tile : game.tiles) {
+        if (game.findTile(tile.id) == &tile) wallTile[static_cast<unsigned char>(tile.id)] = tile.wall;
+    }
+
+    rooms_.resize(game.rooms.size());
+    for (size_t slot = 0; slot < game.rooms.size(); ++slot) rooms_[slot].id = game.rooms[slot].id;
+    roomIndex_.build(rooms_);
+
+    for (size_t slot = 0; slot < game.rooms.size(); ++slot) {
+        const Room& room = game.rooms[slot];
+        RoomInfo& info = rooms_[slot];
+
+        for (int y = 0; y < RoomGrid::kSize; ++y) {
+            for (int x = 0; x < RoomGrid::kSize; ++x) {
+                if (wallTile[static_cast<unsigned char>(room.tiles.at(x, y))]) info.walls.set(x, y);
+            }
+        }
+        info.blocked = info.walls;
+
+        for (const auto& placed : room.items) {
+            const Item* item = game.findItem(placed.first);
+            if (!item || !inRoom(placed.second.first, placed.second.second)) continue;
+            PlacedItem entry;
+            entry.x = placed.second.first;
+            entry.y = placed.second.second;
+            entry.itemSlot = static_cast<int>(item - game.items.data());
+            entry.itemId = item->id;
+            entry.dialogueId = item->dialogId;
+            entry.index = static_cast<int>(placedItemCount_++);
+            info.items.push_back(entry);
+            info.triggers.set(entry.x, entry.y);
+        }
+        for (const Exit& exit : room.exits) {
+            int destination = roomIndex_.slot(exit.destinationRoomId);
+            if (destination < 0 || !inRoom(exit.startPosition.first, exit.startPosition.second) ||
+                !inRoom(exit.destinationPosition.first, exit.destinationPosition.second)) {
+                continue;
+            }
+            PlacedExit entry;
+            entry.x = exit.startPosition.first;
+            entry.y = exit.startPosition.second;
+            entry.destinationRoom = destination;
+            entry.destinationX = exit.destinationPosition.first;
+            entry.destinationY = exit.destinationPosition.second;
+            entry.dialogueId = exit.dialogueId;
+            info.exits.push_back(entry);
+            info.triggers.set(entry.x, entry.y);
+        }
+        for (const End& end : room.endings) {
+            if (!inRoom(end.position.first, end.position.second)) continue;
+            PlacedEnd entry;
+            entry.x = end.position.first;
+            entry.y = end.position.second;
+            entry.dialogueId = end.dialogueId;
+            info.endings.push_back(entry);
+            info.triggers.set(entry.x, entry.y);
+        }
+    }
+
+    for (const Sprite& sprite : game.sprites) {
+        int slot = roomIndex_.slot(sprite.roomId);
+        if (slot < 0 || !inRoom(sprite.position.first, sprite.position.second)) continue;
+        PlacedSprite entry;
+        entry.x = sprite.position.first;
+        entry.y = sprite.position.second;
+        entry.dialogueId = sprite.dialogId;
+        rooms_[slot].sprites.push_back(entry);
+        rooms_[slot].blocked.set(entry.x, entry.y);
+    }
+
+    startRoom_ = roomIndex_.slot(game.avatar.roomId);
+    startX_ = game.avatar.position.first;
+    startY_ = game.avatar.position.second;
+    startInventory_.assign(itemCount_, 0);
+    for (int itemId : game.avatar.inventory) {
+        const Item* item = game.findItem(itemId);
+        if (item) ++startInventory_[item - game.items.data()];
+    }
+
+    for (const auto& var : game.variables) {
+        const std::string& value = var.second.value;
+        variableNames_.push_back(var.first);
+        initialVariables_.push_back(value == "true" ? 1 : static_cast<int>(std::strtol(value.c_str(), nullptr, 10)));
+    }
+}
+
+BitsyPlayState BitsyWorld::initialState() const {
+    BitsyPlayState state;
+    state.room = startRoom_;
+    state.x = startX_;
+    state.y = startY_;
+    state.inventory = startInventory_;
+    state.takenItems.assign((placedItemCount_ + 63) / 64, 0);
+    state.variables = initialVariables_;
+    return state;
+}
+
+BitsyStepResult BitsyWorld::step(BitsyPlayState& state, BitsyInput input) const {
+    ++state.steps;
+    BitsyStateRef ref = {&state.room, &state.x, &state.y, &state.ended, &state.endDialogueId,
+                         state.inventory.data(), 1, state.takenItems.data(), 1};
+    return step(ref, input);
+}
+
+BitsyStepResult BitsyWorld::step(const BitsyStateRef& state, BitsyInput input) const {
+    BitsyStepResult result;
+    if (*state.ended || *state.room < 0 || input == kInputNone) return result;
+
+    int x = *state.x + (input == kInputRight) - (input == kInputLeft);
+    int y = *state.y + (input == kInputDown) - (input == kInputUp);
+    const RoomInfo& room = rooms_[*state.room];
+    if (!inRoom(x, y) || room.blocked.test(x, y)) {
+        result.events = kEventBlocked;
+        if (inRoom(x, y) && !room.walls.test(x, y)) {  // Bumped into a sprite
+            for (const PlacedSprite& sprite : room.sprites) {
+                if (sprite.x == x && sprite.y == y && sprite.dialogueId != -1) {
+                    result.events |= kEventDialogue;
+                    result.dialogueId = sprite.dialogueId;
+                    break;
+                }
+            }
+        }
+        return result;
+    }
+
+    *state.x = x;
+    *state.y = y;
+    result.events = kEventMoved;
+    if (!room.triggers.test(x, y)) return result;
+
+    // Items first, then endings, then exits, as Bitsy does
+    for (const PlacedItem& item : room.items) {
+        if (item.x != x || item.y != y) continue;
+        uint64_t bit = uint64_t(1) << (item.index & 63);
+        uint64_t& word = state.takenItems[(item.index >> 6) * state.takenStride];
+        if (word & bit) continue;
+        word |= bit;
+        ++state.inventory[item.itemSlot * state.inventoryStride];
+        result.events |= kEventItem;
+        result.itemId = item.itemId;
+        if (item.dialogueId != -1) {
+            result.events |= kEventDialogue;
+            result.dialogueId = item.dialogueId;
+        }
+        break;
+    }
+    for (const PlacedEnd& end : room.endings) {
+        if (end.x != x || end.y != y) continue;
+        *state.ended = 1;
+        *state.endDialogueId = end.dialogueId;
+        result.events |= kEventEnd;
+        if (end.dialogueId != -1) {
+            result.events |= kEventDialogue;
+            result.dialogueId = end.dialogueId;
+        }
+        return result;
+    }
+    for (const PlacedExit& exit : room.exits) {
+        if (exit.x != x || exit.y != y) continue;
+        *state.room = exit.destinationRoom;
+        *state.x = exit.destinationX;
+        *state.y = exit.destinationY;
+        result.events |= kEventExit;
+        if (exit.dialogueId != -1) {
+            result.events |= kEventDialogue;
+            result.dialogueId = exit.dialogueId;
+        }
+        break;
+    }
+    return result;
+}
+
+size_t BitsyWorld::run(BitsyPlayState& state, const BitsyInput* inputs, size_t count) const {
+    size_t applied = 0;
+    while (applied < count && !state.ended) step(state, inputs[applied++]);
+    return applied;
+}
@@ -0,0 +1,370 @@
+#include <BitsySynthesizer.h>
+#include <BitsyParallel.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+
+namespace {
+
+const int kStepsPerBar = 16;
+const int kArpeggioNotesPerStep = 4;
+const float kAttackSeconds = 0.002f;  // Tune notes fade in and out this fast to avoid clicks
+const float kReleaseSeconds = 0.01f;
+
+// Equal-tempered frequency of every MIDI note, A4 (69) = 440 Hz
+struct FrequencyTable {
+    double hz[128];
+
+    FrequencyTable() {
+        for (int note = 0; note < 128; ++note) hz[note] = 440.0 * std::pow(2.0, (note - 69) / 12.0);
+    }
+};
+
+double frequency(int note) {
+    static const FrequencyTable table;
+    return table.hz[note];
+}
+
+// Semitone above C of a note letter, or -1
+int semitone(char letter) {
+    static const int kSemitones[] = {9, 11, 0, 2, 4, 5, 7};  // A..G
+    return letter >= 'A' && letter <= 'G' ? kSemitones[letter - 'A'] : -1;
+}
+
+// Semitones of the seven scale degrees (d r m f s l t); KEY lists them as "C,D,E,F,G,A,B ..."
+struct Scale {
+    int degrees[7] = {0, 2, 4, 5, 7, 9, 11};
+
+    explicit Scale(const std::string& key) {
+        int degree = 0;
+        for (size_t i = 0; i < key.size() && key[i] != ' ' && degree < 7; ++i) {
+            int value = semitone(key[i]);
+            if (value < 0) continue;
+            if (i + 1 < key.size() && key[i + 1] == '#') ++value;
+            if (i + 1 < key.size() && key[i + 1] == 'b') --value;
+            degrees[degree++] = (value + 12) % 12;
+        }
+    }
+};
+
+// Parse one step such as "3d5", "2F#" or "G3". Returns false for "0" and anything unplayable.
+bool parseNote(const char* p, const char* end, const Scale& scale, int& length, int& note) {
+    length = 0;
+    while (p < end && *p >= '0' && *p <= '9') length = std::min(length * 10 + (*p++ - '0'), 1 << 16);
+    if (p == end) return false;
+
+    static const char kSolfa[] = "drmfslt";
+    int value = semitone(*p);
+    for (int degree = 0; value < 0 && degree < 7; ++degree) {
+        if (*p == kSolfa[degree]) value = scale.degrees[degree];
+    }
+    if (value < 0) return false;
+    ++p;
+    if (p < end && *p == '#') {
+        ++value;
+        ++p;
+    }
+    int octave = 4;
+    if (p < end && *p >= '0' && *p <= '9') octave = *p - '0';
+
+    note = std::max(0, std::min(127, 12 * (octave + 1) + value));
+    if (length == 0) length = 1;
+    return true;
+}
+
+float pulseWidth(const std::string& instrument) {
+    if (instrument == "P4") return 0.25f;
+    if (instrument == "P8") return 0.125f;
+    return 0.5f;
+}
+
+int stepsPerSecond(const std::string& tempo) {
+    if (tempo == "SLW") return 4;
+    if (tempo == "FST") return 12;
+    if (tempo == "XFST") return 16;
+    return 8;
+}
+
+// Semitone offsets an arpeggio cycles through
+std::vector<int> arpeggio(const std::string& name) {
+    if (name == "UP") return std::vector<int>({0, 4, 7});
+    if (name == "DWN") return std::vector<int>({7, 4, 0});
+    if (name == "INT5") return std::vector<int>({0, 7});
+    if (name == "INT8") return std::vector<int>({0, 12});
+    return std::vector<int>();
+}
+
+// A piecewise-linear envelope: level at a time in samples, flat after the last point
+struct EnvelopePoint {
+    double time;
+    float level;
+};
+typedef std::vector<EnvelopePoint> Envelope;
+
+// Kernels. Each processes one block with a plain counted loop over floats.
+
+// Pulse wave: +amplitude while the phase (in cycles) is below width, -amplitude after.
+// Returns the phase after the block.
+double pulseBlock(float* out, int count, double phase, double increment, float width, float amplitude) {
+    float start = static_cast<float>(phase), step = static_cast<float>(increment);
+    for (int i = 0; i < count; ++i) {
+        float p = start + step * static_cast<float>(i);
+        p -= static_cast<float>(static_cast<int>(p));
+        out[i] = p < width ? amplitude : -amplitude;
+    }
+    double next = phase + increment * count;
+    return next - std::floor(next);
+}
+
+void rampBlock(float* out, int count, float start, float step) {
+    for (int i = 0; i < count; ++i) out[i] *= start + step * static_cast<float>(i);
+}
+
+void mixBlock(float* out, const float* in, int count) {
+    for (int i = 0; i < count; ++i) out[i] += in[i];
+}
+
+void toPcm(const float* in, int16_t* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        float value = in[i] * 32767.0f;
+        value = value > 32767.0f ? 32767.0f : value;
+        value = value < -32768.0f ? -32768.0f : value;
+        out[i] = static_cast<int16_t>(value);
+    }
+}
+
+// Multiply a block starting at envelope time offset by the envelope, one ramp per segment it crosses
+void applyEnvelope(float* block, int count, double offset, const Envelope& envelope) {
+    int done = 0;
+    for (size_t k = 0; k + 1 < envelope.size() && done < count; ++k) {
+        const EnvelopePoint& a = envelope[k];
+        const EnvelopePoint& b = envelope[k + 1];
+        if (b.time <= offset + done) continue;
+        int end = static_cast<int>(std::min<double>(count, std::ceil(b.time - offset)));
+        if (end <= done) continue;
+        double span = b.time - a.time;
+        float slope = span > 0 ? static_cast<float>((b.level - a.level) / span) : 0.0f;
+        float start = a.level + slope * static_cast<float>(offset + done - a.time);
+        rampBlock(block + done, end - done, start, slope);
+        done = end;
+    }
+    if (done < count) rampBlock(block + done, count - done, envelope.empty() ? 1.0f : envelope.back().level, 0.0f);
+}
+
+// Add a pulse tone to mix[start, start + length). envelopeOffset is the envelope time of the
+// first sample; phase carries on from one tone to the next.
+void renderTone(std::vector<float>& mix, size_t start, size_t length, int note, float width, float amplitude,
+                const Envelope& envelope, double envelopeOffset, int sampleRate, double& phase) {
+    float block[BitsySynthesizer::kBlockSize];
+    double increment = frequency(note) / sampleRate;
+    length = std::min(length, mix.size() > start ? mix.size() - start : 0);
+    for (size_t done = 0; done < length;) {
+        int count = static_cast<int>(std::min<size_t>(BitsySynthesizer::kBlockSize, length - done));
+        phase = pulseBlock(block, count, phase, increment, width, amplitude);
+        applyEnvelope(block, count, envelopeOffset + done, envelope);
+        mixBlock(&mix[start + done], block, count);
+        done += count;
+    }
+}
+
+struct NoteEvent {
+    int step, length, note;
+};
+
+std::vector<NoteEvent> voiceEvents(const std::vector<std::string>& bars, const Scale& scale) {
+    std::vector<NoteEvent> events;
+    for (size_t bar = 0; bar < bars.size(); ++bar) {
+        const std::string& line = bars[bar];
+        const char* p = line.data();
+        const char* end = p + line.size();
+        for (int step = 0; step < kStepsPerBar && p <= end; ++step) {
+            const char* comma = std::find(p, end, ',');
+            NoteEvent event;
+            if (parseNote(p, comma, scale, event.length, event.note)) {
+                event.step = static_cast<int>(bar) * kStepsPerBar + step;
+                events.push_back(event);
+            }
+            p = comma + 1;
+        }
+    }
+    return events;
+}
+
+void renderVoice(std::vector<float>& mix, const std::vector<NoteEvent>& events, size_t samplesPerStep, float width,
+                 float amplitude, const std::vector<int>& arpeggioOffsets, int sampleRate) {
+    double phase = 0;
+    for (size_t e = 0; e < events.size(); ++e) {
+        const NoteEvent& event = events[e];
+        int steps = event.length;
+        if (e + 1 < events.size()) steps = std::min(steps, events[e + 1].step - event.step);
+        size_t start = event.step * samplesPerStep, length = steps * samplesPerStep;
+
+        double fade = std::min<double>(length / 2.0, kAttackSeconds * sampleRate);
+        double release = std::min<double>(length / 2.0, kReleaseSeconds * sampleRate);
+        Envelope envelope = {{0, 0.0f}, {fade, 1.0f}, {length - release, 1.0f}, {static_cast<double>(length), 0.0f}};
+
+        if (arpeggioOffsets.empty()) {
+            renderTone(mix, start, length, event.note, width, amplitude, envelope, 0, sampleRate, phase);
+            continue;
+        }
+        size_t chunk = std::max<size_t>(1, samplesPerStep / kArpeggioNotesPerStep);
+        for (size_t offset = 0, k = 0; offset < length; offset += chunk, ++k) {
+            int note = std::min(127, event.note + arpeggioOffsets[k % arpeggioOffsets.size()]);
+            renderTone(mix, start + offset, std::min(chunk, length - offset), note, width, amplitude, envelope,
+                       static_cast<double>(offset), sampleRate, phase);
+        }
+    }
+}
+
+void finish(const std::vector<float>& mix, int sampleRate, BitsyAudio& audio) {
+    audio.sampleRate = sampleRate;
+    audio.samples.resize(mix.size());
+    if (!mix.empty()) toPcm(mix.data(), audio.samples.data(), mix.size());
+}
+
+void appendLittleEndian(std::string& out, uint32_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) out += static_cast<char>((value >> (8 * i)) & 0xFF);
+}
+
+}  // namespace
+
+void BitsySynthesizer::renderTune(const Tune& tune, const BitsyAudioOptions& options, BitsyAudio& audio) {
+    int sampleRate = std::max(1, options.sampleRate);
+    size_t samplesPerStep = std::max(1, sampleRate / stepsPerSecond(tune.tempo));
+    size_t bars = std::max(tune.treblePatterns.size(), tune.bassPatterns.size());
+    std::vector<float> mix(bars * kStepsPerBar * samplesPerStep, 0.0f);
+
+    Scale scale(tune.key);
+    float amplitude = options.volume * 0.5f;
+    renderVoice(mix, voiceEvents(tune.treblePatterns, scale), samplesPerStep, pulseWidth(tune.trebleInstrument),
+                amplitude, arpeggio(tune.arpeggio), sampleRate);
+    renderVoice(mix, voiceEvents(tune.bassPatterns, scale), samplesPerStep, pulseWidth(tune.bassInstrument),
+                amplitude, std::vector<int>(), sampleRate);
+    finish(mix, sampleRate, audio);
+}
+
+BitsyAudio BitsySynthesizer::renderTune(const Tune& tune, const BitsyAudioOptions& options) {
+    BitsyAudio audio;
+    renderTune(tune, options, audio);
+    return audio;
+}
+
+void BitsySynthesizer::renderBlip(const Blip& blip, const BitsyAudioOptions& options, BitsyAudio& audio) {
+    int sampleRate = std::max(1, options.sampleRate);
+    static const int kDefaultEnvelope[] = {10, 50, 8, 100, 50};
+    int maxMs = kMaxBlipSegmentMs;  // Local copy: std::min binds a reference to its arguments
+    int env[5];
+    for (size_t i = 0; i < 5; ++i) {
+        env[i] = std::min(std::max(0, i < blip.env.size() ? blip.env[i] : kDefaultEnvelope[i]), maxMs);
+    }
+    double perMs = sampleRate / 1000.0;
+    double attack = env[0] * perMs, decay = attack + env[1] * perMs, hold = decay + env[3] * perMs;
+    double release = hold + env[4] * perMs;
+    float sustain = std::min(env[2], 15) / 15.0f;
+    Envelope envelope = {{0, 0.0f}, {attack, 1.0f}, {decay, sustain}, {hold, sustain}, {release, 0.0f}};
+
+    std::vector<float> mix(static_cast<size_t>(release), 0.0f);
+    std::vector<int> notes;
+    Scale scale("");
+    const char* p = blip.notes.data();
+    const char* end = p + blip.notes.size();
+    while (p <= end) {
+        const char* comma = std::find(p, end, ',');
+        int length, note;
+        if (parseNote(p, comma, scale, length, note)) notes.push_back(note);
+        p = comma + 1;
+    }
+
+    int beat = std::min(std::max(1, blip.beat.empty() ? 100 : blip.beat[0]), maxMs);
+    int silence = std::min(std::max(0, blip.beat.size() > 1 ? blip.beat[1] : 0), maxMs);
+    size_t noteLength = static_cast<size_t>(beat * perMs);
+    size_t gap = static_cast<size_t>(silence * perMs);
+    double phase = 0;
+    float width = pulseWidth(blip.squareWave);
+    for (size_t start = 0, k = 0; !notes.empty() && start < mix.size(); start += noteLength + gap, ++k) {
+        bool last = !blip.repeat && k + 1 >= notes.size();
+        size_t length = last ? mix.size() - start : noteLength;
+        renderTone(mix, start, length, notes[blip.repeat ? k % notes.size() : std::min(k, notes.size() - 1)], width,
+                   options.volume, envelope, static_cast<double>(start), sampleRate, phase);
+        if (last) break;
+    }
+    finish(mix, sampleRate, audio);
+}
+
+BitsyAudio BitsySynthesizer::renderBlip(const Blip& blip, const BitsyAudioOptions& options) {
+    BitsyAudio audio;
+    renderBlip(blip, options, audio);
+    return audio;
+}
+
+std::string BitsySynthesizer::encodeWav(const BitsyAudio& audio) {
+    uint32_t dataBytes = static_cast<uint32_t>(audio.samples.size() * 2);
+    std::string out;
+    out.reserve(44 + dataBytes);
+    out += "RIFF";
+    appendLittleEndian(out, 36 + dataBytes, 4);
+    out += "WAVEfmt ";
+    appendLittleEndian(out, 16, 4);  // Format chunk size
+    appendLittleEndian(out, 1, 2);  // PCM
+    appendLittleEndian(out, 1, 2);  // Mono
+    appendLittleEndian(out, audio.sampleRate, 4);
+    appendLittleEndian(out, audio.sampleRate * 2, 4);  // Bytes per second
+    appendLittleEndian(out, 2, 2);  // Bytes per frame
+    appendLittleEndian(out, 16, 2);  // Bits per sample
+    out += "data";
+    appendLittleEndian(out, dataBytes, 4);
+    for (int16_t sample : audio.samples) appendLittleEndian(out, static_cast<uint16_t>(sample), 2);
+    return out;
+}
+
+bool BitsySynthesizer::writeWav(const BitsyAudio& audio, const std::string& filePath) {
+    std::string data = encodeWav(audio);
+    FILE* file = std::fopen(filePath.c_str(), "wb");
+    if (!file) return false;
+    bool ok = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    return std::fclose(file) == 0 && ok;
+}
+
+std::vector<BitsyAudioJob> BitsySynthesizer::audioJobs(const BitsyGameData& game, const std::string& pathPrefix) {
+    std::vector<BitsyAudioJob> jobs;
+    for (const Tune& tune : game.tunes) {
+        BitsyAudioJob job;
+        job.tune = &tune;
+        job.outputPath = pathPrefix + "tune" + std::to_string(tune.id) + ".wav";
+        jobs.push_back(job);
+    }
+    for (const Blip& blip : game.blips) {
+        BitsyAudioJob job;
+        job.blip = &blip;
+        job.outputPath = pathPrefix + "blip" + std::to_string(blip.id) + ".wav";
+        jobs.push_back(job);
+    }
+    return jobs;
+}
+
+size_t BitsySynthesizer::renderBatch(const std::vector<BitsyAudioJob>& jobs, const BitsyAudioOptions& options,
+                                     unsigned threadCount) {
+    if (threadCount == 0) threadCount = bitsyDefaultThreadCount();
+    std::vector<BitsyAudio> buffers(threadCount);
+    std::atomic<size_t> failures(0);
+    bitsyParallelFor(jobs.size(), threadCount, [&](unsigned worker, size_t index) {
+        const BitsyAudioJob& job = jobs[index];
+        try {
+            if (job.tune) {
+                renderTune(*job.tune, options, buffers[worker]);
+            } else if (job.blip) {
+                renderBlip(*job.blip, options, buffers[worker]);
+            } else {
+                ++failures;
+                return;
+            }
+        } catch (const std::exception&) {  // Out of memory on a huge tune; the other jobs go on
+            ++failures;
+            return;
+        }
+        if (!writeWav(buffers[worker], job.outputPath)) ++failures;
+    });
+    return failures;
+}
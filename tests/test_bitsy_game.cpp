@@ -1,8 +1,31 @@
 #include <BitsyGameData.h>
 #include <BitsyGameParser.h>
+#include <BitsyBinaryFormat.h>
+#include <BitsyBatchLoader.h>
+#include <BitsyArenaGame.h>
+#include <BitsyGameGenerator.h>
+#include <BitsyIncrementalParser.h>
+#include <BitsyLazyGame.h>
+#include <BitsyGameWriter.h>
+#include <BitsyRenderer.h>
+#include <BitsySimulation.h>
+#include <BitsyBatchRunner.h>
+#include <BitsyAnalysis.h>
+#include <BitsyDialogueScripts.h>
+#include <BitsySynthesizer.h>
+#include <BitsyInternedGame.h>
+#include <BitsyParallel.h>
+#include <BitsyAsyncLoader.h>
+#include <BitsyJsonWriter.h>
+#include <BitsySearchIndex.h>
 #include <iostream>
 #include <sstream>
+#include <fstream>
 #include <cassert>
+#include <algorithm>
+#include <memory>
+#include <future>
+#include <stdexcept>
 
 void test_parse_game_data() {
     BitsyGameData gameData;
@@ -32,12 +55,19 @@ void test_parse_game_data() {
     assert(gameData.rooms.size() == 1);
     assert(gameData.rooms[0].name == "example room");
     assert(gameData.rooms[0].tiles[0][0] == '0');
+    assert(gameData.rooms[0].tiles.at(1, 1) == 'a');
+    assert(gameData.rooms[0].tiles.row(2) == "0a000000000000a0");
+    assert(gameData.rooms[0].tiles.view().size == 256);
     assert(gameData.rooms[0].paletteId == 0);
 
     // Test tile
     assert(gameData.tiles.size() == 1);
     assert(gameData.tiles[0].id == 'a');
     assert(gameData.tiles[0].name == "block");
+    assert(gameData.tiles[0].frames.size() == 1);
+    assert(gameData.tiles[0].frames.pixel(0, 0, 0));
+    assert(!gameData.tiles[0].frames.pixel(0, 1, 1));
+    assert(gameData.tiles[0].frames.toText()[3] == "10011001");
 
     // Test avatar
     assert(gameData.avatar.id == 'A');
@@ -79,8 +109,1151 @@ void test_parse_game_data() {
     gameData.printGameStats();
 }
 
+void test_parse_game_data_mapped() {
+    std::string filePath = "../game.bitsy";
+
+    // The zero-copy path reads every field of the sample game as written in the file
+    BitsyGameData mapped = BitsyGameParser::parseGameDataMapped(filePath);
+    assert(mapped.palettes[0].color1 == std::make_tuple(0, 82, 204));
+    assert(mapped.palettes[0].color3 == std::make_tuple(255, 255, 255));
+    assert(mapped.rooms[0].tiles[1][1] == 'a' && mapped.rooms[0].tuneId == 2);
+    assert(mapped.tiles[0].id == 'a' && mapped.tiles[0].frames.size() == 1);
+    assert(mapped.sprites.size() == 1 && mapped.sprites[0].id == 'a' && mapped.sprites[0].name == "cat");
+    assert(mapped.sprites[0].dialogId == 0 && mapped.sprites[0].blipId == 1 && mapped.sprites[0].roomId == 0);
+    assert(mapped.sprites[0].position == std::make_pair(8, 12));
+    assert(mapped.items.size() == 2 && mapped.items[1].name == "key");
+    assert(mapped.items[1].dialogId == 2 && mapped.items[1].blipId == 2);
+    assert(mapped.dialogues[2].text == "A key! {wvy}What does it open?{wvy}");
+    assert(mapped.dialogues[2].name == "key dialog");
+    assert(mapped.variables.at("a").value == "42");
+    assert(mapped.tunes[0].treblePatterns[0] == "3d,0,0,0,3d5,0,0,0,3l,0,0,0,3s,0,0,0");
+    assert(mapped.tunes[0].key == "C,D,E,F,G,A,B d,r,m,s,l" && mapped.tunes[0].arpeggio == "INT8");
+    assert(mapped.tunes[1].bassPatterns.size() == 8 && mapped.tunes[1].tempo == "FST");
+    assert(mapped.blips[0].notes == "E5,B5,B5" && mapped.blips[0].env.size() == 5);
+    assert(mapped.blips[0].env[3] == 185 && mapped.blips[1].beat[0] == 95);
+    assert(BitsyGameParser::parseGameData(filePath) == mapped);
+
+    // Caller-owned buffers work too, including a last line without a newline
+    std::string text = "title\n\nDLG 7\nhello\nNAME greeting";
+    BitsyGameData fromBuffer = BitsyGameParser::parseGameBuffer(text.data(), text.size());
+    assert(fromBuffer.title == "title");
+    assert(fromBuffer.dialogues.size() == 1);
+    assert(fromBuffer.dialogues[0].id == 7);
+    assert(fromBuffer.dialogues[0].name == "greeting");
+
+    std::cout << "test_parse_game_data_mapped passed!" << std::endl;
+}
+
+void test_tile_properties() {
+    // NAME and WAL are optional lines after the frames, in either order, up to the blank line
+    std::string text = "title\n\n"
+                       "TIL a\n11111111\n10000001\n10000001\n10000001\n10000001\n10000001\n10000001\n11111111\n"
+                       "WAL true\n\n"
+                       "TIL b\n00000000\n00000000\n00000000\n00000000\n00000000\n00000000\n00000000\n00000000\n"
+                       "WAL true\nNAME brick\n\n"
+                       "TIL c\n00000000\n00000000\n00000000\n00000000\n00000000\n00000000\n00000000\n00000001\n"
+                       "NAME floor\n\n"
+                       "DLG 0\nafter the tiles\n";
+    BitsyGameData game = BitsyGameParser::parseGameBuffer(text.data(), text.size());
+    assert(game.tiles.size() == 3);
+    assert(game.tiles[0].id == 'a' && game.tiles[0].wall && game.tiles[0].name.empty());
+    assert(game.tiles[1].id == 'b' && game.tiles[1].wall && game.tiles[1].name == "brick");
+    assert(game.tiles[2].id == 'c' && !game.tiles[2].wall && game.tiles[2].name == "floor");
+    assert(game.tiles[2].frames.size() == 1 && game.tiles[2].frames[0].bits == 1ull << 63);
+    assert(game.dialogues.size() == 1 && game.dialogues[0].text == "after the tiles");
+
+    std::cout << "test_tile_properties passed!" << std::endl;
+}
+
+void test_packed_frames() {
+    BitsyGameData gameData = BitsyGameParser::parseGameData("../game.bitsy");
+
+    // Avatar frame: a figure standing on two legs
+    PackedFrame avatar = gameData.avatar.frames[0];
+    assert(avatar.toText()[0] == "00011000");
+    assert(avatar.toText()[7] == "00100100");
+    assert(avatar.row(0) == 0x18);
+
+    // Flips and rotations
+    PackedFrame corner;
+    corner.setPixel(1, 0, true);  // top row, second column
+    assert(corner.flippedHorizontal().pixel(6, 0));
+    assert(corner.flippedVertical().pixel(1, 7));
+    assert(corner.transposed().pixel(0, 1));
+    assert(corner.rotatedClockwise().pixel(7, 1));
+    assert(corner.rotatedCounterClockwise().pixel(0, 6));
+    assert(avatar.rotatedClockwise().rotatedCounterClockwise() == avatar);
+    assert(avatar.flippedHorizontal().flippedHorizontal() == avatar);
+    assert(avatar.rotatedClockwise().rotatedClockwise() == avatar.flippedHorizontal().flippedVertical());
+
+    std::cout << "test_packed_frames passed!" << std::endl;
+}
+
+void test_id_lookups() {
+    BitsyGameData gameData = BitsyGameParser::parseGameData("../game.bitsy");
+
+    assert(gameData.findRoom(0) == &gameData.rooms[0]);
+    assert(gameData.findRoom(5) == nullptr);
+    assert(gameData.findTile('a')->name == "block");
+    assert(gameData.findTile('z') == nullptr);
+    assert(gameData.findSprite('a')->name == "cat");
+    assert(gameData.findItem(1)->name == "key");
+    assert(gameData.findDialogue(gameData.sprites[0].dialogId)->name == "cat dialog");
+    assert(gameData.findPalette(gameData.rooms[0].paletteId)->name == "blueprint");
+    assert(gameData.findTune(gameData.rooms[0].tuneId)->name == "tuneful town");
+    assert(gameData.findBlip(2)->name == "pick up key");
+
+    // Huge and negative IDs fall back to the sparse table
+    Dialogue far;
+    far.id = 1000000;
+    gameData.dialogues.push_back(far);
+    gameData.buildIndex();
+    assert(gameData.findDialogue(1000000) == &gameData.dialogues.back());
+    assert(gameData.findDialogue(-1) == nullptr);
+
+    std::cout << "test_id_lookups passed!" << std::endl;
+}
+
+void test_binary_round_trip() {
+    BitsyGameData text = BitsyGameParser::parseGameData("../game.bitsy");
+    assert(BitsyBinaryWriter::writeFile(text, "game.bitsybin"));
+
+    BitsyBinaryGame binary;
+    assert(binary.open("game.bitsybin"));
+    assert(binary.toGameData() == text);
+
+    // Sections are usable straight from the mapping
+    assert(binary.string(binary.game().title) == "game");
+    assert(binary.count(kBinTunes) == 3);
+    const BitsyBinRoom* room = binary.findRoom(0);
+    assert(room != nullptr);
+    assert(BitsyStringView(room->tiles + 16, 16) == text.rooms[0].tiles.row(1));
+    assert(binary.string(room->name) == "example room");
+    size_t tileCount;
+    const BitsyBinTile* tiles = binary.records<BitsyBinTile>(kBinTiles, tileCount);
+    assert(tileCount == 1 && tiles[0].frames[0] == text.tiles[0].frames[0].bits);
+
+    // Serialization is deterministic and damaged images are rejected
+    std::string image = BitsyBinaryWriter::serialize(text);
+    assert(image == BitsyBinaryWriter::serialize(binary.toGameData()));
+    std::string truncated = image.substr(0, image.size() / 2);
+    BitsyBinaryGame broken;
+    assert(!broken.openBuffer(truncated.data(), truncated.size()));
+
+    // Rooms are found through the sorted ID index, whatever order the file lists them in
+    BitsyGeneratorOptions options;
+    options.rooms = 50;
+    std::string generatedText = BitsyGameGenerator::generate(options);
+    BitsyGameData generated = BitsyGameParser::parseGameBuffer(generatedText.data(), generatedText.size());
+    std::reverse(generated.rooms.begin(), generated.rooms.end());
+    generated.rooms.push_back(generated.rooms.front());
+    generated.rooms.back().name = "duplicate";
+    std::string shuffled = BitsyBinaryWriter::serialize(generated);
+    BitsyBinaryGame many;
+    assert(many.openBuffer(shuffled.data(), shuffled.size()) && many.count(kBinRoomIndex) == 51);
+    for (const Room& expected : generated.rooms) {
+        const BitsyBinRoom* found = many.findRoom(expected.id);
+        assert(found && found->id == expected.id && many.string(found->name) != "duplicate");
+    }
+    assert(many.findRoom(-1) == nullptr && many.findRoom(50) == nullptr);
+
+    std::cout << "test_binary_round_trip passed!" << std::endl;
+}
+
+void test_batch_loader() {
+    std::vector<std::string> files(8, "../game.bitsy");
+    files.push_back("../missing.bitsy");
+
+    BitsyGameData expected = BitsyGameParser::parseGameData("../game.bitsy");
+    std::vector<bool> seen(files.size(), false);
+    size_t failures = BitsyBatchLoader(4).load(files, [&](BitsyBatchResult& result) {
+        assert(!seen[result.index]);
+        seen[result.index] = true;
+        if (result.filePath == "../missing.bitsy") {
+            assert(!result.ok && !result.error.empty());
+        } else {
+            assert(result.ok && result.game == expected);
+        }
+    });
+    assert(failures == 1);
+    assert(std::count(seen.begin(), seen.end(), true) == static_cast<long>(files.size()));
+
+    std::cout << "test_batch_loader passed!" << std::endl;
+}
+
+void test_parallel_parse() {
+    // A game large enough to be split: game.bitsy followed by many generated blocks
+    std::ifstream file("../game.bitsy");
+    std::stringstream text;
+    text << file.rdbuf() << "\n";
+    for (int i = 10; i < 3000; ++i) {
+        text << "ROOM " << i << "\n";
+        for (int y = 0; y < 16; ++y) text << "a,0,0,0,0,0,0,0,0,0,0,0,0,0,0," << (y % 2 ? "a" : "0") << "\n";
+        text << "NAME room " << i << "\nEXT 1,1 " << i - 1 << " 2,2 FX fade DLG " << i << "\nPAL 0\n\n";
+        text << "DLG " << i << "\nline " << i << "\nNAME dialog " << i << "\n\n";
+        text << "VAR v" << i % 50 << "\n" << i << "\n\n";
+        if (i == 1500) text << "! VER_MIN 13\n\nSPR A\n00011000\n00011000\n00011000\n00111100\n"
+                               "01111110\n10111101\n00100100\n00100100\nPOS 7 1,1\n\n";
+    }
+    std::string buffer = text.str();
+
+    BitsyGameData sequential, parallel;
+    std::string error;
+    assert(BitsyGameParser::parseGameBuffer(buffer.data(), buffer.size(), sequential, error));
+    assert(BitsyGameParser::parseGameBufferParallel(buffer.data(), buffer.size(), parallel, error, 4));
+    assert(parallel == sequential);
+    assert(parallel.rooms.size() == 2991);
+    assert(parallel.settings.verMin == 13);
+    assert(parallel.avatar.roomId == 7);
+    assert(parallel.findRoom(2999)->exits[0].destinationRoomId == 2998);
+
+    // Errors stop the merge at the same place the sequential parse stops
+    std::string broken = buffer;
+    broken.replace(broken.find("ROOM 2000"), 9, "ROOM oops");
+    BitsyGameData brokenSequential, brokenParallel;
+    assert(!BitsyGameParser::parseGameBuffer(broken.data(), broken.size(), brokenSequential, error));
+    assert(!BitsyGameParser::parseGameBufferParallel(broken.data(), broken.size(), brokenParallel, error, 4));
+    assert(brokenParallel == brokenSequential);
+
+    std::cout << "test_parallel_parse passed!" << std::endl;
+}
+
+// Collects dialogue text only and stops after a given number of dialogues
+class DialogueCollector : public BitsyGameVisitor {
+public:
+    explicit DialogueCollector(size_t limit) : limit(limit) {}
+    bool wants(BitsyBlockType type) const override { return type == kBlockDialogue || type == kBlockRoom; }
+    bool onDialogue(Dialogue& dialogue) override {
+        texts.push_back(dialogue.text);
+        return texts.size() < limit;
+    }
+    bool onExit(const Room&, const Exit&) override { ++exits; return true; }
+    bool onTile(Tile&) override { ++tiles; return true; }
+
+    size_t limit;
+    std::vector<std::string> texts;
+    int exits = 0;
+    int tiles = 0;
+};
+
+void test_visitor() {
+    std::string error;
+    DialogueCollector all(100);
+    assert(BitsyGameParser::parseFile("../game.bitsy", all, error));
+    assert(all.texts.size() == 3);
+    assert(all.texts[0] == "I'm a cat");
+    assert(all.tiles == 0);  // Skipped without being parsed
+
+    DialogueCollector firstTwo(2);
+    assert(BitsyGameParser::parseFile("../game.bitsy", firstTwo, error));
+    assert(firstTwo.texts.size() == 2);
+
+    std::string text = "t\n\nROOM 1\n0\n0\n0\n0\n0\n0\n0\n0\n0\n0\n0\n0\n0\n0\n0\n0\n"
+                       "EXT 1,1 2 3,3\nEXT 4,4 2 5,5\n\nDLG 1\nhi\n";
+    DialogueCollector exits(100);
+    assert(BitsyGameParser::parse(text.data(), text.size(), exits, error));
+    assert(exits.exits == 2 && exits.texts.size() == 1);
+
+    std::cout << "test_visitor passed!" << std::endl;
+}
+
+void test_arena_game() {
+    BitsyGameData expected = BitsyGameParser::parseGameData("../game.bitsy");
+
+    BitsyArenaGame game;
+    std::string error;
+    assert(game.loadFile("../game.bitsy", error));
+    assert(game.toGameData() == expected);
+    assert(game.title == "game");
+    assert(game.rooms.size == 1 && game.rooms[0].tiles.at(1, 1) == 'a');
+    assert(game.tunes[1].bassPatterns.size == 8);
+    assert(game.findVariable("a")->value == "42");
+    assert(game.findVariable("b") == nullptr);
+    assert(game.bytesUsed() > 0 && game.bytesUsed() <= game.bytesReserved());
+
+    // Reloading reuses the same single block
+    size_t used = game.bytesUsed();
+    assert(game.loadFile("../game.bitsy", error));
+    assert(game.bytesUsed() == used);
+    assert(game.arena().blockCount() == 1);
+
+    // Outgrowing the block merges everything into one block on the next reset
+    BitsyArena arena(64);
+    for (int i = 0; i < 1000; ++i) arena.copyString("some text that does not fit");
+    assert(arena.blockCount() > 1);
+    arena.reset();
+    assert(arena.blockCount() == 1 && arena.bytesUsed() == 0);
+
+    std::cout << "test_arena_game passed!" << std::endl;
+}
+
+void test_game_generator() {
+    BitsyGeneratorOptions options;
+    options.rooms = 40;
+    options.dialogues = 50;
+    std::string text = BitsyGameGenerator::generate(options);
+    assert(text == BitsyGameGenerator::generate(options));  // Deterministic
+
+    BitsyGameData game;
+    std::string error;
+    assert(BitsyGameParser::parseGameBuffer(text.data(), text.size(), game, error));
+    assert(game.rooms.size() == 40 && game.dialogues.size() == 50);
+    assert(game.tiles.size() == 16 && game.sprites.size() == 8 && game.items.size() == 8);
+    assert(game.tunes.size() == 4 && game.blips.size() == 4 && game.variables.size() == 4);
+    for (const Room& room : game.rooms) {
+        for (const Exit& ext : room.exits) assert(game.findRoom(ext.destinationRoomId) != nullptr);
+        assert(game.findTune(room.tuneId) != nullptr);
+    }
+
+    options.seed = 2;
+    assert(text != BitsyGameGenerator::generate(options));
+
+    std::cout << "test_game_generator passed!" << std::endl;
+}
+
+uint64_t countCalls() {
+    static uint64_t calls = 0;
+    return ++calls;  // Stands in for an allocation counter: every read looks like one new allocation
+}
+
+void test_parse_stats() {
+    std::ifstream file("../game.bitsy");
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    text += "\nMYSTERY 1\n";
+
+    BitsyGameData game;
+    std::string error;
+    BitsyParseStats stats;
+    stats.allocationCounter = countCalls;
+    assert(BitsyGameParser::parseGameBuffer(text.data(), text.size(), game, error, &stats));
+    assert(stats.ok && stats.bytes == text.size());
+    assert(stats.lines == static_cast<size_t>(std::count(text.begin(), text.end(), '\n')));
+    assert(stats.sections[kBlockRoom].blocks == game.rooms.size());
+    assert(stats.sections[kBlockDialogue].blocks == game.dialogues.size());
+    assert(stats.sections[kBlockAvatar].blocks == 1);
+    assert(stats.sections[kBlockTile].allocations == game.tiles.size());
+    assert(stats.commentLines == 1 && stats.unrecognizedLines == 1);
+    assert(stats.unrecognizedSamples[0].text == "MYSTERY 1" && stats.unrecognizedSamples[0].line == stats.lines);
+    std::string json = stats.toJson();
+    assert(json.find("\"room\": {\"blocks\": 1") != std::string::npos);
+    assert(json.find("MYSTERY 1") != std::string::npos);
+
+    // Skipped blocks are counted separately
+    DialogueCollector collector(100);
+    assert(BitsyGameParser::parse(text.data(), text.size(), collector, error, &stats));
+    assert(stats.sections[kBlockTile].blocks == 0 && stats.sections[kBlockTile].skippedBlocks == game.tiles.size());
+    assert(stats.sections[kBlockDialogue].blocks == 3);
+
+    // Failures report the line they happened on
+    std::string broken = "title\n\nPAL 0\n0,0,0\n0,0,0\n0,0,0\n\nROOM x\n";
+    assert(!BitsyGameParser::parseGameBuffer(broken.data(), broken.size(), game, error, &stats));
+    assert(!stats.ok && stats.errorLine == 8 && stats.error == error);
+    assert(stats.sections[kBlockPalette].blocks == 1);
+    assert(!BitsyGameParser::parseGameDataMapped("missing.bitsy", game, error, &stats) && !stats.ok);
+
+    // Memory accounting
+    game = BitsyGameParser::parseGameData("../game.bitsy");
+    BitsyMemoryFootprint footprint = game.memoryFootprint();
+    assert(footprint.rooms >= game.rooms.capacity() * sizeof(Room));
+    assert(footprint.dialogues >= game.dialogues.capacity() * sizeof(Dialogue));
+    assert(footprint.variables > 0 && footprint.index > 0);
+    assert(footprint.total() > footprint.object + footprint.rooms);
+    assert(footprint.toJson().find("\"total\": ") != std::string::npos);
+
+    std::cout << "test_parse_stats passed!" << std::endl;
+}
+
+// Apply text to game incrementally and check it matches a full parse
+BitsyReloadReport reloadAndCheck(BitsyIncrementalParser& parser, const std::string& text, BitsyGameData& game) {
+    BitsyReloadReport report;
+    std::string error;
+    assert(parser.update(text.data(), text.size(), game, report, error));
+    assert(game == BitsyGameParser::parseGameBuffer(text.data(), text.size()));
+    return report;
+}
+
+void test_incremental_parse() {
+    BitsyGeneratorOptions options;
+    options.rooms = 20;
+    options.dialogues = 40;
+    std::string text = BitsyGameGenerator::generate(options);
+
+    BitsyIncrementalParser parser;
+    BitsyGameData game;
+    BitsyReloadReport report = reloadAndCheck(parser, text, game);
+    assert(report.fullParse && report.blocksReused == 0 && report.added.size() > 100);
+
+    // Unchanged text parses nothing
+    report = reloadAndCheck(parser, text, game);
+    assert(report.empty() && report.blocksParsed == 0 && !report.fullParse);
+
+    // Editing one dialogue re-parses just that block
+    size_t pos = text.find("NAME dialog 7\n");
+    text.replace(pos, 13, "NAME dialog seven");
+    report = reloadAndCheck(parser, text, game);
+    assert(report.blocksParsed == 1 && report.modified.size() == 1 && report.added.empty());
+    assert(report.modified[0].type == kBlockDialogue && report.modified[0].id == 7);
+    assert(game.findDialogue(7)->name == "dialog seven");
+
+    // Removing a variable and adding a room
+    pos = text.find("VAR v1\n");
+    text.erase(pos, text.find("\n\n", pos) + 2 - pos);
+    text += "ROOM 99\n";
+    for (int y = 0; y < 16; ++y) text += "0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0\n";
+    text += "NAME new room\n\n";
+    report = reloadAndCheck(parser, text, game);
+    assert(report.removed.size() == 1 && report.removed[0].type == kBlockVariable && report.removed[0].name == "v1");
+    assert(report.added.size() == 1 && report.added[0].type == kBlockRoom && report.added[0].id == 99);
+    assert(game.variables.count("v1") == 0 && game.findRoom(99) != nullptr);
+
+    // A name defined by several VAR blocks keeps the last definition in the file
+    text += "VAR dup\n1\n\nVAR dup\n2\n\n";
+    reloadAndCheck(parser, text, game);
+    assert(game.variables["dup"].value == "2");
+    text.replace(text.find("VAR dup\n1\n"), 10, "VAR dup\n3\n");
+    reloadAndCheck(parser, text, game);
+    assert(game.variables["dup"].value == "2");
+    text.erase(text.find("VAR dup\n2\n"), 11);
+    reloadAndCheck(parser, text, game);
+    assert(game.variables["dup"].value == "3");
+
+    // Settings, avatar and title are assigned rather than appended
+    text.replace(text.find("! TXT_MODE 0"), 12, "! TXT_MODE 1");
+    text.replace(text.find("POS 0 4,4"), 9, "POS 3 5,6");
+    text.replace(0, text.find('\n'), "renamed");
+    report = reloadAndCheck(parser, text, game);
+    assert(report.titleChanged && report.modified.size() == 2);
+    assert(game.settings.txtMode == 1 && game.avatar.roomId == 3 && game.title == "renamed");
+
+    // A broken save leaves the last good game in place
+    BitsyGameData before = game;
+    std::string broken = text;
+    broken.replace(broken.find("ROOM 1\n"), 6, "ROOM x");
+    std::string error;
+    assert(!parser.update(broken.data(), broken.size(), game, report, error) && !error.empty());
+    assert(game == before);
+    report = reloadAndCheck(parser, text, game);
+    assert(report.empty());
+
+    // A different game object starts over
+    BitsyGameData other;
+    report = reloadAndCheck(parser, text, other);
+    assert(report.fullParse);
+
+    std::cout << "test_incremental_parse passed!" << std::endl;
+}
+
+void test_lazy_game() {
+    BitsyLazyGame lazy;
+    std::string error;
+    assert(lazy.openFile("../game.bitsy", error));
+    BitsyGameData full = BitsyGameParser::parseGameData("../game.bitsy");
+    assert(lazy.title == full.title && lazy.settings == full.settings && lazy.avatar == full.avatar);
+    assert(lazy.parsedBlockCount() == 2);  // Settings and avatar only
+
+    const Room* room = lazy.findRoom(full.avatar.roomId);
+    assert(room && *room == *full.findRoom(full.avatar.roomId));
+    assert(lazy.parsedBlockCount() == 3);
+    assert(lazy.findRoom(full.avatar.roomId) == room);  // Cached
+    assert(lazy.parsedBlockCount() == 3);
+
+    for (const Tile& tile : full.tiles) assert(*lazy.findTile(tile.id) == *full.findTile(tile.id));
+    for (const Dialogue& dlg : full.dialogues) assert(*lazy.findDialogue(dlg.id) == *full.findDialogue(dlg.id));
+    for (const Tune& tune : full.tunes) assert(*lazy.findTune(tune.id) == tune);
+    for (const auto& var : full.variables) assert(*lazy.findVariable(var.first) == var.second);
+    assert(lazy.findRoom(12345) == nullptr && lazy.findTile('~') == nullptr && lazy.findVariable("none") == nullptr);
+    assert(lazy.toGameData() == full);
+
+    // Startup work does not grow with the number of rooms
+    BitsyGeneratorOptions options;
+    options.rooms = 500;
+    std::string text = BitsyGameGenerator::generate(options);
+    assert(lazy.openBuffer(text.data(), text.size(), error));
+    assert(lazy.parsedBlockCount() == 2 && lazy.blocks().size() > 500);
+    assert(lazy.findRoom(250)->id == 250 && lazy.parsedBlockCount() == 3);
+
+    std::string broken = "title\n\nROOM x\n";
+    assert(!lazy.openBuffer(broken.data(), broken.size(), error) && lazy.blocks().empty());
+
+    std::cout << "test_lazy_game passed!" << std::endl;
+}
+
+void test_game_writer() {
+    std::ifstream file("../game.bitsy");
+    std::string original((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    BitsyGameData game = BitsyGameParser::parseGameBuffer(original.data(), original.size());
+
+    // game.bitsy is already in canonical form, so writing it reproduces the file
+    std::string text = BitsyGameWriter::write(game);
+    assert(text.size() == BitsyGameWriter::measure(game));
+    assert(text == original);
+
+    // Parse -> write -> parse is stable on a generated game exercising every property
+    BitsyGeneratorOptions options;
+    options.rooms = 30;
+    std::string generated = BitsyGameGenerator::generate(options);
+    BitsyGameData first = BitsyGameParser::parseGameBuffer(generated.data(), generated.size());
+    std::string written = BitsyGameWriter::write(first);
+    BitsyGameData second = BitsyGameParser::parseGameBuffer(written.data(), written.size());
+    assert(first == second);
+    assert(BitsyGameWriter::write(second) == written);
+
+    // Walls without names survive the round trip
+    first.tiles[0].name.clear();
+    first.tiles[0].wall = true;
+    written = BitsyGameWriter::write(first);
+    assert(BitsyGameParser::parseGameBuffer(written.data(), written.size()) == first);
+
+    // Caller buffers and files
+    std::vector<char> buffer(text.size());
+    assert(BitsyGameWriter::write(game, buffer.data(), buffer.size() - 1) == 0);
+    assert(BitsyGameWriter::write(game, buffer.data(), buffer.size()) == text.size());
+    assert(std::string(buffer.begin(), buffer.end()) == text);
+    assert(BitsyGameWriter::writeFile(second, "writer_test.bitsy"));
+    assert(BitsyGameParser::parseGameData("writer_test.bitsy") == second);
+    std::remove("writer_test.bitsy");
+    assert(!BitsyGameWriter::writeFile(game, "no_such_dir/game.bitsy"));
+
+    std::cout << "test_game_writer passed!" << std::endl;
+}
+
+// Per-pixel reference for the row-mask renderer
+void drawReference(BitsyImage& image, int cellX, int cellY, const FrameSet& frames, int frame,
+                   const std::tuple<int, int, int>& color) {
+    if (frames.empty()) return;
+    for (int y = 0; y < 8; ++y) {
+        for (int x = 0; x < 8; ++x) {
+            if (!frames.pixel(frame % frames.size(), x, y)) continue;
+            uint8_t* p = &image.pixels[((cellY * 8 + y) * 128 + cellX * 8 + x) * 3];
+            p[0] = std::get<0>(color);
+            p[1] = std::get<1>(color);
+            p[2] = std::get<2>(color);
+        }
+    }
+}
+
+void test_renderer() {
+    BitsyGameData game = BitsyGameParser::parseGameData("../game.bitsy");
+    const Room& room = game.rooms[0];
+    BitsyImage image = BitsyRenderer::renderRoom(game, room);
+    assert(image.width == 128 && image.height == 128 && image.pixels.size() == 128 * 128 * 3);
+
+    const uint8_t* background = image.pixel(0, 0);  // Cell (0, 0) is empty
+    assert(background[0] == 0 && background[1] == 82 && background[2] == 204);
+    const uint8_t* wall = image.pixel(8, 8);  // Tile 'a' at (1, 1) has a solid top row
+    assert(wall[0] == 128 && wall[1] == 159 && wall[2] == 255);
+    const uint8_t* avatar = image.pixel(4 * 8 + 3, 4 * 8);  // Avatar at (4, 4), top row 00011000
+    assert(avatar[0] == 255 && avatar[1] == 255 && avatar[2] == 255);
+
+    // Compare both animation frames against a per-pixel reference on a generated game
+    BitsyGeneratorOptions options;
+    options.rooms = 4;
+    std::string text = BitsyGameGenerator::generate(options);
+    BitsyGameData generated = BitsyGameParser::parseGameBuffer(text.data(), text.size());
+    for (int frame = 0; frame < 2; ++frame) {
+        for (const Room& r : generated.rooms) {
+            const Palette& p = *generated.findPalette(r.paletteId);
+            BitsyImage expected;
+            expected.width = expected.height = 128;
+            for (int i = 0; i < 128 * 128; ++i) {
+                expected.pixels.push_back(std::get<0>(p.color1));
+                expected.pixels.push_back(std::get<1>(p.color1));
+                expected.pixels.push_back(std::get<2>(p.color1));
+            }
+            for (int y = 0; y < 16; ++y) {
+                for (int x = 0; x < 16; ++x) {
+                    const Tile* tile = generated.findTile(r.tiles.at(x, y));
+                    if (tile) drawReference(expected, x, y, tile->frames, frame, p.color2);
+                }
+            }
+            for (const auto& placed : r.items) {
+                drawReference(expected, placed.second.first, placed.second.second,
+                              generated.findItem(placed.first)->frames, frame, p.color3);
+            }
+            for (const Sprite& sprite : generated.sprites) {
+                if (sprite.roomId != r.id) continue;
+                drawReference(expected, sprite.position.first, sprite.position.second, sprite.frames, frame, p.color3);
+            }
+            if (generated.avatar.roomId == r.id) {
+                drawReference(expected, generated.avatar.position.first, generated.avatar.position.second,
+                              generated.avatar.frames, frame, p.color3);
+            }
+            assert(BitsyRenderer::renderRoom(generated, r, frame).pixels == expected.pixels);
+        }
+    }
+
+    // Encoders
+    std::string ppm = BitsyRenderer::encodePpm(image);
+    assert(ppm.compare(0, 15, "P6\n128 128\n255\n") == 0 && ppm.size() == 15 + image.pixels.size());
+    std::string png = BitsyRenderer::encodePng(image);
+    assert(png.compare(0, 8, "\x89PNG\r\n\x1a\n", 8) == 0);
+    assert(png.compare(png.size() - 12, 12, "\0\0\0\0IEND\xae\x42\x60\x82", 12) == 0);  // Known IEND CRC
+
+    // Batch rendering writes one file per room
+    std::vector<BitsyRenderJob> jobs = BitsyRenderer::roomJobs(generated, "render_test_", kImagePng);
+    assert(jobs.size() == generated.rooms.size() && jobs[1].outputPath == "render_test_room1.png");
+    assert(BitsyRenderer::renderBatch(jobs, kImagePng, 0, 2) == 0);
+    for (const BitsyRenderJob& job : jobs) {
+        std::ifstream written(job.outputPath, std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(written)), std::istreambuf_iterator<char>());
+        assert(bytes == BitsyRenderer::encodePng(BitsyRenderer::renderRoom(generated, *job.room)));
+        std::remove(job.outputPath.c_str());
+    }
+    std::cout << "test_renderer passed!" << std::endl;
+}
+
+// game.bitsy, with walls on tile 'a', an item and an exit next to the avatar at (4, 4),
+// and a second room holding an ending
+BitsyGameData simulationGame() {
+    BitsyGameData game = BitsyGameParser::parseGameData("../game.bitsy");
+    game.tiles[0].wall = true;
+    game.rooms[0].items.emplace_back(0, std::make_pair(5, 4));
+    Exit exit;
+    exit.startPosition = std::make_pair(4, 5);
+    exit.destinationRoomId = 1;
+    exit.destinationPosition = std::make_pair(10, 10);
+    game.rooms[0].exits.push_back(exit);
+    Room second = game.rooms[0];
+    second.id = 1;
+    second.items.clear();
+    second.exits.clear();
+    End end;
+    end.dialogueId = 2;
+    end.position = std::make_pair(11, 10);
+    second.endings.push_back(end);
+    game.rooms.push_back(second);
+    game.buildIndex();
+    return game;
+}
+
+void test_simulation() {
+    BitsyGameData game = simulationGame();
+    BitsyWorld world(game);
+    assert(world.rooms().size() == 2 && world.placedItemCount() == 1);
+    assert(world.rooms()[0].walls.test(1, 1) && !world.rooms()[0].walls.test(4, 4));
+    assert(world.rooms()[0].blocked.test(8, 12));  // The cat
+
+    BitsyPlayState state = world.initialState();
+    assert(state.room == 0 && state.x == 4 && state.y == 4 && state.inventory.size() == game.items.size());
+    assert(world.step(state, kInputUp).events == kEventMoved);
+    assert(world.step(state, kInputUp).events == kEventMoved);
+    assert(world.step(state, kInputUp).events == kEventBlocked && state.y == 2);  // Wall at (4, 1)
+    world.step(state, kInputDown);
+    world.step(state, kInputDown);
+
+    BitsyStepResult result = world.step(state, kInputRight);
+    assert(result.events == (kEventMoved | kEventItem | kEventDialogue));
+    assert(result.itemId == 0 && result.dialogueId == 1);
+    assert(state.inventory[0] == 1);
+    world.step(state, kInputLeft);
+    assert(world.step(state, kInputRight).events == kEventMoved && state.inventory[0] == 1);  // Already taken
+    world.step(state, kInputLeft);
+
+    result = world.step(state, kInputDown);
+    assert((result.events & kEventExit) && state.room == 1 && state.x == 10 && state.y == 10);
+    result = world.step(state, kInputRight);
+    assert((result.events & kEventEnd) && result.dialogueId == 2 && state.ended && state.endDialogueId == 2);
+    assert(world.step(state, kInputLeft).events == 0 && state.x == 11);
+
+    // Bumping into a sprite blocks and starts its dialogue
+    BitsyPlayState bump = world.initialState();
+    bump.x = 8;
+    bump.y = 11;
+    result = world.step(bump, kInputDown);
+    assert(result.events == (kEventBlocked | kEventDialogue) && result.dialogueId == 0 && bump.y == 11);
+
+    // run() stops at the ending
+    const BitsyInput inputs[] = {kInputRight, kInputLeft, kInputDown, kInputRight, kInputUp, kInputUp};
+    BitsyPlayState replay = world.initialState();
+    assert(world.run(replay, inputs, 6) == 4 && replay.ended && replay.steps == 4);
+
+    std::cout << "test_simulation passed!" << std::endl;
+}
+
+void test_batch_runner() {
+    BitsyGameData game = simulationGame();
+    game.variables["score"].name = "score";
+    game.variables["score"].value = "7";
+    BitsyWorld world(game);
+
+    // Random input streams, checked instance by instance against single-state stepping
+    const size_t kInstances = 500, kTicks = 200;
+    std::vector<BitsyInput> inputs(kInstances * kTicks);
+    uint32_t seed = 12345;
+    for (BitsyInput& input : inputs) {
+        seed = seed * 1664525u + 1013904223u;
+        input = seed >> 29 < 5 ? static_cast<BitsyInput>(seed >> 29) : kInputNone;
+    }
+    BitsyBatchRunner runner(world, kInstances, 3);
+    runner.run(inputs.data(), kTicks);
+
+    std::map<int, size_t> dialogues;
+    size_t inSecondRoom = 0, ended = 0;
+    for (size_t i = 0; i < kInstances; ++i) {
+        BitsyPlayState expected = world.initialState();
+        bool reachedSecond = false;
+        for (size_t t = 0; t < kTicks && !expected.ended; ++t) {
+            BitsyStepResult result = world.step(expected, inputs[t * kInstances + i]);
+            if (result.events & kEventDialogue) ++dialogues[result.dialogueId];
+            reachedSecond = reachedSecond || expected.room == 1;
+        }
+        inSecondRoom += reachedSecond;
+        ended += expected.ended != 0;
+
+        BitsyPlayState actual = runner.state(i);
+        assert(actual.room == expected.room && actual.x == expected.x && actual.y == expected.y);
+        assert(actual.ended == expected.ended && actual.inventory == expected.inventory);
+        assert(actual.takenItems == expected.takenItems && actual.variables == expected.variables);
+    }
+    assert(runner.state(0).variables.size() == game.variables.size());
+
+    BitsyCoverage coverage = runner.coverage();
+    assert(coverage.instances == kInstances && coverage.ticks == kTicks);
+    assert(coverage.roomInstances[0] == kInstances && coverage.roomInstances[1] == inSecondRoom);
+    assert(coverage.endedInstances == ended && coverage.endingInstances.size() == 1);
+    assert(coverage.endingInstances[0] == ended && coverage.endingsHit() == (ended > 0 ? 1u : 0u));
+    assert(coverage.dialogueTriggers == dialogues);
+    assert(coverage.toJson().find("\"instances\": 500") != std::string::npos);
+
+    // Random runs are reproducible and reset starts over
+    runner.reset();
+    runner.runRandom(100, 42);
+    BitsyCoverage first = runner.coverage();
+    runner.reset();
+    assert(runner.coverage().ticks == 0 && runner.coverage().dialogueTriggers.empty());
+    runner.runRandom(100, 42);
+    assert(runner.coverage().roomInstances == first.roomInstances);
+    assert(runner.coverage().dialogueTriggers == first.dialogueTriggers);
+
+    std::cout << "test_batch_runner passed!" << std::endl;
+}
+
+void test_analysis() {
+    BitsyGameData game = simulationGame();
+    BitsyGameAnalysis analysis(game);
+    assert(analysis.report().clean());
+    assert(analysis.regionCount() == 4);  // Inside and outside the wall ring, in both rooms
+    assert(analysis.reachable(0) && analysis.reachable(1));
+    assert(analysis.reachable(0, 4, 4) && analysis.reachable(0, 4, 5) && analysis.reachable(1, 11, 10));
+    assert(!analysis.reachable(0, 0, 0) && !analysis.reachable(0, 1, 1) && !analysis.reachable(0, 8, 12));
+    assert(analysis.linkedRooms(0) == std::vector<int>({0, 1}) && analysis.linkedRooms(1) == std::vector<int>(1, 1));
+
+    // Walling off the exit cuts off the second room and its ending
+    BitsyGameData walled = simulationGame();
+    walled.rooms[0].tiles.set(4, 5, 'a');
+    BitsyGameAnalysis cut(walled);
+    assert(!cut.reachable(1) && cut.linkedRooms(0).size() == 2);
+    assert(cut.report().unreachableRooms == std::vector<int>(1, 1));
+    assert(cut.report().unreachableEndings.size() == 1 && cut.report().unreachableEndings[0].dialogueId == 2);
+
+    // An unlinked room, an ending outside the walls, a broken exit and dangling references
+    Room orphan = game.rooms[1];
+    orphan.id = 2;
+    orphan.endings.clear();
+    orphan.paletteId = 7;
+    game.rooms.push_back(orphan);
+    End outside;
+    outside.position = std::make_pair(0, 0);
+    game.rooms[1].endings.push_back(outside);
+    Exit broken;
+    broken.startPosition = std::make_pair(6, 6);
+    broken.destinationRoomId = 9;
+    game.rooms[0].exits.push_back(broken);
+    game.sprites[0].dialogId = 99;
+    game.buildIndex();
+
+    BitsyGameAnalysis damaged(game);
+    const BitsyAnalysisReport& report = damaged.report();
+    assert(!report.clean() && report.unreachableRooms == std::vector<int>(1, 2));
+    assert(report.unreachableEndings.size() == 1 && report.unreachableEndings[0].x == 0);
+    assert(report.brokenExits.size() == 1 && report.brokenExits[0].destinationRoomId == 9);
+    assert(report.danglingReferences.size() == 2);
+    assert(report.danglingReferences[0].kind == "palette" && report.danglingReferences[0].ownerId == "2");
+    assert(report.danglingReferences[1].kind == "dialogue" && report.danglingReferences[1].ownerType == "sprite");
+    assert(report.toJson().find("\"broken_exits\": [{\"room\": 0, \"x\": 6, \"y\": 6, \"destination\": 9}]") !=
+           std::string::npos);
+    assert(damaged.reachable(0, 6, 6));  // The broken exit is plain floor
+
+    std::cout << "test_analysis passed!" << std::endl;
+}
+
+void test_dialogue_scripts() {
+    BitsyGameData game = simulationGame();
+    game.dialogues[1].text = "{picked = picked + 1}You found a nice warm cup of tea";
+    const char* kScripts[][2] = {
+        {"10", "{visits = visits + 1}Visit {say visits}.{- visits > 2 ? Again? - visits == 2 ? Hi again - else ? Hi}"},
+        {"11", "{print {item \"tea\"}} tea{br}{double = (a - 2) * 2 + {item 0}}{say -double / 3}{pg}"},
+        {"12", "{- a == 42 ? {- picked ? both - else ? {/rbw}answer}}!"},
+        {"13", "ok {oops = } {/nope} {item \"missing\"} {unclosed"}};
+    for (const auto& script : kScripts) {
+        Dialogue dialogue;
+        dialogue.id = std::atoi(script[0]);
+        dialogue.text = script[1];
+        game.dialogues.push_back(dialogue);
+    }
+    game.buildIndex();
+
+    BitsyDialogueScripts scripts(game);
+    const std::vector<std::string>& names = scripts.variableNames();
+    assert(names.size() == 4 && names[0] == "a" && names[1] == "picked" && names[2] == "visits");
+    assert(scripts.initialVariables() == std::vector<int>({42, 0, 0, 0}) && scripts.variableIndex("double") == 3);
+    assert(scripts.errors().size() == 4);
+    for (const BitsyScriptError& error : scripts.errors()) assert(error.dialogueId == 13);
+    assert(scripts.errors()[0].column == 3 && scripts.errors()[3].message == "unclosed {");
+
+    BitsyWorld world(game);
+    BitsyPlayState state = world.initialState();
+    BitsyDialogueOutput output;
+    assert(scripts.run(2, state, &output) && output.text == "A key! What does it open?");
+    assert(output.tags.size() == 2 && output.tags[0].type == kTagWavy && !output.tags[0].closing);
+    assert(output.tags[0].offset == 7 && output.tags[1].offset == 25);
+    assert(state.variables.size() == 4);
+    assert(!scripts.run(99, state, &output));
+
+    const char* kVisits[] = {"Visit 1.Hi", "Visit 2.Hi again", "Visit 3.Again?", "Visit 4.Again?"};
+    for (const char* expected : kVisits) {
+        output.clear();
+        scripts.run(10, state, &output);
+        assert(output.text == expected);
+    }
+
+    state.inventory[0] = 3;
+    output.clear();
+    scripts.run(11, state, &output);
+    assert(output.text == "3 tea\n-27" && state.variables[3] == 83);
+    assert(output.tags.size() == 1 && output.tags[0].type == kTagPage && output.tags[0].offset == 9);
+
+    output.clear();
+    scripts.run(12, state, &output);
+    assert(output.text == "answer!" && output.tags.size() == 1 && output.tags[0].closing);
+    state.variables[1] = 1;
+    output.clear();
+    scripts.run(12, state, &output);
+    assert(output.text == "both!");
+    output.clear();
+    scripts.run(13, state, &output);
+    assert(output.text == "ok    {unclosed");  // Broken blocks print nothing; an unclosed one is text
+
+    // A default play state gets zeroed inventory slots for every item before scripts read them
+    BitsyPlayState fresh;
+    output.clear();
+    assert(scripts.itemCount() == game.items.size() && scripts.run(11, fresh, &output));
+    assert(output.text == "0 tea\n-26" && fresh.inventory == std::vector<int>(game.items.size(), 0));
+
+    // The batch runner runs scripts against each instance's own variables
+    const size_t kInstances = 5;
+    BitsyBatchRunner runner(world, kInstances, 2);
+    runner.setScripts(&scripts);
+    std::vector<BitsyInput> inputs(kInstances, kInputRight);
+    inputs[2] = kInputUp;
+    runner.run(inputs.data(), 1);
+    for (size_t i = 0; i < kInstances; ++i) {
+        BitsyPlayState played = runner.state(i);
+        assert(played.variables.size() == 4 && played.variables[0] == 42);
+        assert(played.variables[1] == (i == 2 ? 0 : 1));
+    }
+
+    std::cout << "test_dialogue_scripts passed!" << std::endl;
+}
+
+void test_synthesizer() {
+    BitsyAudioOptions options;
+    options.sampleRate = 8000;
+
+    // One A4 (440 Hz) step at 8 steps per second, then silence for the rest of the bar
+    Tune tune;
+    tune.id = 9;
+    tune.treblePatterns.push_back("A,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0");
+    BitsyAudio audio = BitsySynthesizer::renderTune(tune, options);
+    assert(audio.sampleRate == 8000 && audio.samples.size() == 16 * 1000);
+    assert(audio.samples[0] == 0);
+    size_t positive = 0;
+    for (size_t i = 100; i < 900; ++i) {
+        int16_t sample = audio.samples[i];
+        assert(sample == 8191 || sample == -8191);
+        positive += sample > 0;
+    }
+    assert(positive > 380 && positive < 420);  // Half-width pulse
+    for (size_t i = 1000; i < audio.samples.size(); ++i) assert(audio.samples[i] == 0);
+
+    // Quarter-width pulse, a held note and a solfa note from the key
+    tune.trebleInstrument = "P4";
+    tune.treblePatterns[0] = "3A,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0";
+    audio = BitsySynthesizer::renderTune(tune, options);
+    positive = 0;
+    for (size_t i = 100; i < 2900; ++i) positive += audio.samples[i] > 0;
+    assert(positive > 650 && positive < 750 && audio.samples[2950] != 0 && audio.samples[3000] == 0);
+    Tune solfa = tune;
+    solfa.key = "G,A,B,C,D,E,F# d,r,m,s,l";
+    solfa.treblePatterns[0] = "3r,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0";
+    assert(BitsySynthesizer::renderTune(solfa, options).samples == audio.samples);
+
+    // The game's tunes and blips: lengths follow tempo and envelope, rendering is repeatable
+    BitsyGameData game = BitsyGameParser::parseGameData("../game.bitsy");
+    const Tune* fanfare = game.findTune(1);
+    BitsyAudio first = BitsySynthesizer::renderTune(*fanfare, options);
+    assert(first.samples.size() == 4 * 16 * 500);  // XFST: 16 steps per second
+    assert(BitsySynthesizer::renderTune(*fanfare, options).samples == first.samples);
+    BitsyAudio meow = BitsySynthesizer::renderBlip(*game.findBlip(1), options);
+    assert(meow.samples.size() == (40 + 99 + 185 + 138) * 8);
+    assert(meow.samples[0] == 0 && meow.samples[40 * 8 - 3] > 3500);  // Near the end of the attack
+
+    // Oversized envelope and beat values from a file are capped rather than allocated
+    Blip huge = *game.findBlip(1);
+    huge.env = {0, 0, 15, 2000000000, 0};
+    huge.beat = {2000000000, 2000000000};
+    BitsyAudio capped = BitsySynthesizer::renderBlip(huge, options);
+    assert(capped.samples.size() == 5000 * 8);  // kMaxBlipSegmentMs of hold
+
+    std::string wav = BitsySynthesizer::encodeWav(meow);
+    assert(wav.size() == 44 + 2 * meow.samples.size() && wav.compare(0, 4, "RIFF") == 0);
+    assert(wav.compare(8, 8, "WAVEfmt ") == 0 && wav.compare(36, 4, "data") == 0);
+
+    // Batch rendering writes the same bytes
+    std::vector<BitsyAudioJob> jobs = BitsySynthesizer::audioJobs(game, "synth_");
+    assert(jobs.size() == game.tunes.size() + game.blips.size() && jobs[0].outputPath == "synth_tune1.wav");
+    assert(BitsySynthesizer::renderBatch(jobs, options, 3) == 0);
+    std::ifstream in("synth_blip1.wav", std::ios::binary);
+    std::string written((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    assert(written == wav);
+    for (const BitsyAudioJob& job : jobs) std::remove(job.outputPath.c_str());
+
+    std::cout << "test_synthesizer passed!" << std::endl;
+}
+
+void test_interning() {
+    BitsyInternPool pool;
+    BitsyStringHandle hello = pool.intern("hello");
+    assert(hello == pool.intern(std::string("hello")) && hello != pool.intern("hell"));
+    assert(*hello == "hello" && pool.intern("") == pool.intern(std::string()));
+    FrameSet frames;
+    frames.push_back(PackedFrame());
+    assert(pool.intern(frames) == pool.intern(frames) && pool.intern(frames) != pool.intern(FrameSet()));
+    RoomGrid grid;
+    BitsyGridHandle empty = pool.intern(grid);
+    grid.set(3, 4, 'a');
+    assert(pool.intern(grid) != empty && pool.intern(RoomGrid()) == empty && pool.intern(grid)->at(3, 4) == 'a');
+    std::vector<std::string> patterns = {"0", "1"};
+    assert(pool.intern(patterns) == pool.intern(patterns) && pool.intern(patterns)->size == 2);
+
+    // The same game loaded many times, on several threads, is stored once
+    BitsyGameData parsed = BitsyGameParser::parseGameData("../game.bitsy");
+    BitsyInternedGame first(pool);
+    std::string error;
+    assert(first.loadFile("../game.bitsy", error));
+    assert(first.toGameData() == parsed);
+    BitsyInternPool::Stats stats = pool.stats();
+
+    std::vector<std::unique_ptr<BitsyInternedGame>> copies;
+    for (int i = 0; i < 16; ++i) copies.emplace_back(new BitsyInternedGame(pool));
+    bitsyParallelFor(copies.size(), 4, [&copies](unsigned, size_t index) {
+        std::string loadError;
+        copies[index]->loadFile("../game.bitsy", loadError);
+    });
+    assert(pool.stats().values == stats.values && pool.stats().bytes == stats.bytes);
+    assert(pool.stats().hits > stats.hits);
+    for (const auto& copy : copies) assert(*copy == first);
+    assert(first.memoryUsage() < parsed.memoryFootprint().total());
+
+    // Converting from BitsyGameData gives the same handles; different content does not
+    BitsyInternedGame assigned(pool);
+    assigned.assign(parsed);
+    assert(assigned == first && assigned.rooms[0].tiles == first.rooms[0].tiles);
+    assert(assigned.findVariable("a") != nullptr && *assigned.findVariable("a")->value == "42");
+    parsed.dialogues[0].text += "!";
+    assigned.assign(parsed);
+    assert(assigned != first && assigned.dialogues[0].text != first.dialogues[0].text);
+    assert(assigned.dialogues[0].name == first.dialogues[0].name);
+
+    std::cout << "test_interning passed!" << std::endl;
+}
+
+void test_async_loader() {
+    // A background load gives the same game as the blocking one, and reports its progress
+    BitsyGameData parsed = BitsyGameParser::parseGameData("../game.bitsy");
+    size_t callbacks = 0;
+    BitsyLoadHandle handle = BitsyAsyncLoader::loadFile("../game.bitsy", [&callbacks](BitsyLoadResult& result) {
+        assert(result.ok());
+        ++callbacks;
+    });
+    BitsyLoadResult& result = handle.result();
+    assert(handle.done() && handle.status() == kLoadOk && result.ok() && callbacks == 1);
+    assert(result.game == parsed && result.error.message.empty());
+    BitsyLoadProgress progress = handle.progress();
+    assert(progress.bytes == progress.totalBytes && progress.totalBytes > 0 && progress.fraction() == 1);
+    assert(progress.blocks > parsed.rooms.size() + parsed.dialogues.size());
+
+    // Failures come back as structured errors
+    BitsyLoadHandle missing = BitsyAsyncLoader::loadFile("missing.bitsy");
+    assert(missing.result().error.status == kLoadOpenFailed && missing.result().error.filePath == "missing.bitsy");
+    std::string broken = "title\n\nPAL 0\n0,0,0\n0,0,0\n0,0,0\n\nROOM x\n";
+    BitsyLoadHandle failed = BitsyAsyncLoader::loadBuffer(broken.data(), broken.size());
+    const BitsyLoadError& error = failed.result().error;
+    assert(error.status == kLoadParseFailed && error.line == 8 && broken.compare(error.offset, 6, "ROOM x") == 0);
+    assert(failed.result().game.palettes.size() == 1);
+    assert(error.toJson().find("\"status\": \"parse_failed\"") != std::string::npos);
+
+    // A throwing callback is reported instead of taking down the executor
+    BitsyLoadHandle throwing = BitsyAsyncLoader::loadFile("../game.bitsy", [](BitsyLoadResult&) {
+        throw std::runtime_error("no room");
+    });
+    assert(throwing.result().error.status == kLoadCallbackFailed && throwing.status() == kLoadCallbackFailed);
+    assert(throwing.result().error.message == "Error in load callback: no room" && throwing.result().game == parsed);
+
+    // A load cancelled while still queued never starts
+    BitsyExecutor executor(1);
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    executor.submit([released]() { released.wait(); });
+    BitsyLoadHandle queued = BitsyAsyncLoader::loadFile("../game.bitsy", BitsyAsyncLoader::Callback(), executor);
+    assert(!queued.waitFor(0.01) && !queued.done());
+    queued.cancel();
+    release.set_value();
+    assert(queued.result().error.status == kLoadCancelled && queued.progress().blocks == 0);
+
+    // Cancelling a running load stops it between blocks with the blocks parsed so far
+    BitsyGeneratorOptions options;
+    options.rooms = 2000;
+    options.dialogues = 4000;
+    std::string text = BitsyGameGenerator::generate(options);
+    BitsyLoadHandle large =
+        BitsyAsyncLoader::loadBuffer(text.data(), text.size(), BitsyAsyncLoader::Callback(), executor);
+    while (large.progress().blocks == 0 && !large.done()) std::this_thread::yield();
+    large.cancel();
+    BitsyLoadResult& partial = large.result();
+    if (partial.error.status == kLoadCancelled) {
+        assert(partial.game.rooms.size() + partial.game.dialogues.size() < 6000);
+        assert(partial.error.offset == large.progress().bytes && large.progress().bytes < text.size());
+    } else {
+        assert(partial.ok() && partial.game.rooms.size() == 2000);  // Finished before the cancel arrived
+    }
+
+    std::cout << "test_async_loader passed!" << std::endl;
+}
+
+void test_json_writer() {
+    BitsyGameData game = BitsyGameParser::parseGameData("../game.bitsy");
+    std::string json = BitsyJsonWriter::write(game);
+    assert(json.compare(0, 10, "{\"title\":\"") == 0 && json.compare(json.size() - 2, 2, "}\n") == 0);
+    assert(std::count(json.begin(), json.end(), '{') == std::count(json.begin(), json.end(), '}'));
+    assert(std::count(json.begin(), json.end(), '[') == std::count(json.begin(), json.end(), ']'));
+    assert(json.find("\"variables\":[{\"name\":\"a\",\"value\":\"42\"}]") != std::string::npos);
+    assert(json.find("\"frames\":[[\"") != std::string::npos);
+
+    // Text is escaped; frames can be packed words
+    game.dialogues[0].text = "say \"hi\"\n\\ \x01";
+    json = BitsyJsonWriter::write(game);
+    assert(json.find("\"text\":\"say \\\"hi\\\"\\n\\\\ \\u0001\"") != std::string::npos);
+    BitsyJsonOptions options;
+    options.packedFrames = true;
+    std::string packed = BitsyJsonWriter::write(game, options);
+    std::string frame = "\"frames\":[" + std::to_string(game.tiles[0].frames[0].bits);
+    assert(packed.find(frame) != std::string::npos && packed.size() < json.size());
+
+    // NDJSON: a game record, then one record per entity; skipped sections are left out
+    options.lines = true;
+    options.sections = kJsonAllSections & ~kJsonDialogues;
+    std::string lines = BitsyJsonWriter::write(game, options);
+    size_t records = 2 + game.palettes.size() + game.rooms.size() + game.tiles.size() + game.sprites.size() +
+                     game.items.size() + game.variables.size() + game.tunes.size() + game.blips.size();
+    assert(static_cast<size_t>(std::count(lines.begin(), lines.end(), '\n')) == records);
+    assert(lines.compare(0, 15, "{\"type\":\"game\",") == 0 && lines.find("\"type\":\"room\"") != std::string::npos);
+    assert(lines.find("\"type\":\"dialogue\"") == std::string::npos);
+
+    // Streaming to a file gives the same bytes, and append reuses a buffer
+    assert(BitsyJsonWriter::writeFile(game, "json_test.ndjson", options));
+    std::ifstream in("json_test.ndjson", std::ios::binary);
+    std::string written((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    assert(written == lines);
+    std::remove("json_test.ndjson");
+    std::string buffer = "x";
+    BitsyJsonWriter::append(game, options, buffer);
+    assert(buffer == "x" + lines);
+
+    std::cout << "test_json_writer passed!" << std::endl;
+}
+
+void test_search_index() {
+    std::vector<std::string> words;
+    BitsySearchIndex::tokenize("A key! {wvy}What does IT open?{/wvy} {a b}", words);
+    assert((words == std::vector<std::string>{"a", "key", "what", "does", "it", "open", "a", "b"}));
+
+    BitsyGameData game = BitsyGameParser::parseGameData("../game.bitsy");
+    BitsyGameData changed = game;
+    changed.dialogues[0].text = "I'm a dog";
+    BitsySearchIndexBuilder builder;
+    builder.addGame("one", game);
+    builder.addGame("two", changed);
+    std::string image = builder.serialize();
+    BitsySearchIndex index;
+    assert(index.openBuffer(image.data(), image.size()));
+    assert(index.gameCount() == 2 && index.gameKey(1) == "two" && index.termCount() > 10);
+    for (size_t t = 1; t < index.termCount(); ++t) assert(index.termText(t - 1).str() < index.termText(t).str());
+
+    // Term queries cover dialogue text and names; hits are sorted by game, field and entity
+    std::vector<BitsySearchHit> hits = index.term("CAT");
+    assert(hits.size() == 5);
+    assert(hits[0].game == 0 && hits[0].field == kSearchDialogueText && hits[0].entityId == 0);
+    assert(hits[1].field == kSearchDialogueName && hits[2].field == kSearchSpriteName && hits[2].entityId == 'a');
+    assert(hits[3].game == 1 && hits[3].field == kSearchDialogueName);
+    assert(index.term("wvy").empty() && index.term("zebra").empty());
+
+    // Prefix and phrase queries, through the search syntax too
+    assert(index.prefix("ca").size() == 5 && index.search("ca*").size() == 5);
+    hits = index.phrase("cup of tea");
+    assert(hits.size() == 2 && hits[0].entityId == 1 && hits[0].matches == 1);
+    assert(index.phrase("tea of cup").empty() && index.search("does it open").size() == 2);
+    assert(index.search("a dog").size() == 1 && index.search("a dog")[0].game == 1);
+
+    // Re-indexing one game from the file on disk replaces only its postings
+    assert(builder.writeFile("search_test.idx"));
+    BitsySearchIndex onDisk;
+    assert(onDisk.open("search_test.idx") && onDisk.postingCount() == index.postingCount());
+    BitsySearchIndexBuilder updater;
+    BitsySearchIndex closed;
+    assert(!updater.load(closed) && updater.gameCount() == 0);
+    assert(updater.load(onDisk));
+    updater.addGame("one", changed);
+    assert(updater.gameCount() == 2 && updater.writeFile("search_test.idx"));
+    BitsySearchIndex updated;
+    assert(updated.open("search_test.idx") && updated.search("dog").size() == 2);
+    assert(updated.term("cat").size() == 4 && onDisk.term("cat").size() == 5);  // Old mapping is unchanged
+
+    assert(updater.removeGame("two") && !updater.removeGame("two"));
+    image = updater.serialize();
+    assert(updated.openBuffer(image.data(), image.size()) && updated.gameCount() == 1);
+    assert(updated.gameKey(0) == "one" && updated.search("dog").size() == 1);
+    std::remove("search_test.idx");
+
+    std::cout << "test_search_index passed!" << std::endl;
+}
+
 int main() {
     test_parse_game_data();
+    test_parse_game_data_mapped();
+    test_tile_properties();
+    test_packed_frames();
+    test_id_lookups();
+    test_binary_round_trip();
+    test_batch_loader();
+    test_parallel_parse();
+    test_visitor();
+    test_arena_game();
+    test_game_generator();
+    test_parse_stats();
+    test_incremental_parse();
+    test_lazy_game();
+    test_game_writer();
+    test_renderer();
+    test_simulation();
+    test_batch_runner();
+    test_analysis();
+    test_dialogue_scripts();
+    test_synthesizer();
+    test_interning();
+    test_async_loader();
+    test_json_writer();
+    test_search_index();
 
     std::cout << "All tests passed!" << std::endl;
     return 0;
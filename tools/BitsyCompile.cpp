@@ -0,0 +1,32 @@
+// BitsyCompile.cpp: converts a .bitsy text file into the compiled binary format
+#include "BitsyBinaryFormat.h"
+#include "BitsyGameParser.h"
+#include <iostream>
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <input.bitsy> <output.bitsybin>" << std::endl;
+        return 2;
+    }
+
+    BitsyGameData game;
+    std::string error;
+    if (!BitsyGameParser::parseGameDataMapped(argv[1], game, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    if (!BitsyBinaryWriter::writeFile(game, argv[2])) {
+        std::cerr << "Error: Unable to write file " << argv[2] << std::endl;
+        return 1;
+    }
+
+    // Load the result back so a broken conversion never goes unnoticed
+    BitsyBinaryGame compiled;
+    if (!compiled.open(argv[2]) || !(compiled.toGameData() == game)) {
+        std::cerr << "Error: Compiled file " << argv[2] << " does not match " << argv[1] << std::endl;
+        return 1;
+    }
+
+    std::cout << "Compiled " << game.title << " (" << game.rooms.size() << " rooms) to " << argv[2] << std::endl;
+    return 0;
+}
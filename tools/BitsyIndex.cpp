@@ -0,0 +1,120 @@
+// BitsyIndex.cpp: builds or updates a search index over many games and runs queries against it
+#include "BitsyBatchLoader.h"
+#include "BitsySearchIndex.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sys/stat.h>
+
+namespace {
+
+const char* fieldName(BitsySearchField field) {
+    switch (field) {
+        case kSearchDialogueText: return "dialogue";
+        case kSearchDialogueName: return "dialogue name";
+        case kSearchRoomName: return "room";
+        case kSearchSpriteName: return "sprite";
+        case kSearchItemName: return "item";
+        case kSearchTuneName: return "tune";
+        case kSearchBlipName: return "blip";
+        default: return "unknown";
+    }
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    unsigned threads = 0;
+    std::string indexPath = "bitsy.idx";
+    bool update = false;
+    std::vector<std::string> removals;
+    std::vector<std::string> queries;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc) {
+            threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (arg == "--index" && i + 1 < argc) {
+            indexPath = argv[++i];
+        } else if (arg == "--update") {
+            update = true;
+        } else if (arg == "--remove" && i + 1 < argc) {
+            removals.push_back(argv[++i]);
+        } else if (arg == "-q" && i + 1 < argc) {
+            queries.push_back(argv[++i]);
+        } else {
+            struct stat st;
+            if (stat(arg.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+                std::vector<std::string> found = BitsyBatchLoader::listGameFiles(arg);
+                files.insert(files.end(), found.begin(), found.end());
+            } else {
+                files.push_back(arg);
+            }
+        }
+    }
+
+    if (files.empty() && removals.empty() && queries.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [-j threads] [--index file] [--update] [--remove game]..."
+                  << " [-q query]... [<file.bitsy | directory>...]" << std::endl;
+        return 2;
+    }
+
+    // Games are keyed by the path they were given as. With --update (or removals) the existing
+    // index is loaded first, so only the listed games are parsed.
+    size_t failures = 0;
+    if (!files.empty() || !removals.empty()) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        BitsySearchIndexBuilder builder;
+        if (update || !removals.empty()) {
+            BitsySearchIndex existing;
+            if (existing.open(indexPath)) {
+                builder.load(existing);
+            } else if (!removals.empty()) {
+                std::cerr << "Unable to open index " << indexPath << std::endl;
+                return 1;
+            }
+        }
+        for (const std::string& key : removals) {
+            if (!builder.removeGame(key)) std::cerr << "Not in the index: " << key << std::endl;
+        }
+
+        BitsyBatchLoader loader(threads);
+        failures = loader.load(files, [&](BitsyBatchResult& result) {
+            if (!result.ok) {
+                std::cerr << "FAIL " << result.filePath << ": " << result.error << std::endl;
+                return;
+            }
+            builder.addGame(result.filePath, result.game);
+        });
+        if (!builder.writeFile(indexPath)) {
+            std::cerr << "Unable to write index " << indexPath << std::endl;
+            return 1;
+        }
+        std::cout << "Indexed " << files.size() - failures << "/" << files.size() << " files, "
+                  << builder.gameCount() << " games in the index, in " << secondsSince(start) << " s" << std::endl;
+    }
+
+    if (!queries.empty()) {
+        BitsySearchIndex index;
+        if (!index.open(indexPath)) {
+            std::cerr << "Unable to open index " << indexPath << std::endl;
+            return 1;
+        }
+        for (const std::string& query : queries) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            std::vector<BitsySearchHit> hits = index.search(query);
+            double seconds = secondsSince(start);
+            for (const BitsySearchHit& hit : hits) {
+                std::cout << index.gameKey(hit.game).str() << ": " << fieldName(hit.field) << ' ' << hit.entityId
+                          << " (" << hit.matches << ")" << std::endl;
+            }
+            std::cout << hits.size() << " hits for \"" << query << "\" in " << seconds * 1000 << " ms" << std::endl;
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
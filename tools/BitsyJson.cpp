@@ -0,0 +1,116 @@
+// BitsyJson.cpp: converts games to JSON or NDJSON files, many games at once
+#include "BitsyBatchLoader.h"
+#include "BitsyGameParser.h"
+#include "BitsyJsonWriter.h"
+#include "BitsyParallel.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <sys/stat.h>
+
+namespace {
+
+// Section bit for a name given to --skip, or 0 if unknown
+unsigned sectionBit(const std::string& name) {
+    static const char* kNames[] = {"palettes", "rooms",     "tiles",     "sprites", "avatar",
+                                   "items",    "dialogues", "variables", "tunes",   "blips"};
+    for (unsigned i = 0; i < sizeof(kNames) / sizeof(kNames[0]); ++i) {
+        if (name == kNames[i]) return 1u << i;
+    }
+    return 0;
+}
+
+off_t fileSize(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? st.st_size : 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    unsigned threads = 0;
+    std::string outputDir = ".";
+    BitsyJsonOptions options;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc) {
+            threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (arg == "-o" && i + 1 < argc) {
+            outputDir = argv[++i];
+        } else if (arg == "--ndjson") {
+            options.lines = true;
+        } else if (arg == "--packed-frames") {
+            options.packedFrames = true;
+        } else if (arg == "--skip" && i + 1 < argc) {
+            unsigned bit = sectionBit(argv[++i]);
+            if (bit == 0) {
+                std::cerr << "Unknown section " << argv[i] << std::endl;
+                return 2;
+            }
+            options.sections &= ~bit;
+        } else {
+            struct stat st;
+            if (stat(arg.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+                std::vector<std::string> found = BitsyBatchLoader::listGameFiles(arg);
+                files.insert(files.end(), found.begin(), found.end());
+            } else {
+                files.push_back(arg);
+            }
+        }
+    }
+
+    if (files.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [-j threads] [-o dir] [--ndjson] [--packed-frames] [--skip section]..."
+                  << " <file.bitsy | directory>..." << std::endl;
+        return 2;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // Each worker parses a game and streams it to its own output file, so nothing is held
+    // beyond one game per thread. Largest files go first to balance the workers. Outputs are
+    // named <dir>/<input index>_<file name>.json (or .ndjson), as BitsyRender names its images.
+    std::vector<size_t> order(files.size());
+    std::vector<off_t> sizes(files.size());
+    for (size_t i = 0; i < files.size(); ++i) {
+        order[i] = i;
+        sizes[i] = fileSize(files[i]);
+    }
+    std::stable_sort(order.begin(), order.end(), [&sizes](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+
+    std::mutex errorMutex;
+    std::atomic<size_t> failures(0);
+    std::atomic<size_t> totalBytes(0);
+    bitsyParallelFor(order.size(), threads, [&](unsigned, size_t task) {
+        size_t index = order[task];
+        const std::string& path = files[index];
+        BitsyGameData game;
+        std::string error;
+        bool ok = BitsyGameParser::parseGameDataMapped(path, game, error);
+        if (ok) {
+            std::string name = path.substr(path.find_last_of('/') + 1);
+            std::string outputPath = outputDir + "/" + std::to_string(index) + "_" +
+                                     name.substr(0, name.rfind(".bitsy")) + (options.lines ? ".ndjson" : ".json");
+            ok = BitsyJsonWriter::writeFile(game, outputPath, options);
+            if (!ok) error = "Error: Unable to write " + outputPath;
+        }
+        if (!ok) {
+            ++failures;
+            std::lock_guard<std::mutex> lock(errorMutex);
+            std::cerr << "FAIL " << path << ": " << error << std::endl;
+            return;
+        }
+        totalBytes += sizes[index];
+    });
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Converted " << files.size() - failures << "/" << files.size() << " files, " << totalBytes
+              << " bytes in " << seconds << " s (" << (seconds > 0 ? totalBytes / seconds / 1e6 : 0) << " MB/s)"
+              << std::endl;
+    return failures == 0 ? 0 : 1;
+}
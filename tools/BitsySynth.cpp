@@ -0,0 +1,71 @@
+// BitsySynth.cpp: renders every tune and blip of one or more games to WAV files
+#include "BitsyBatchLoader.h"
+#include "BitsySynthesizer.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sys/stat.h>
+
+int main(int argc, char** argv) {
+    unsigned threads = 0;
+    BitsyAudioOptions options;
+    std::string outputDir = ".";
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc) {
+            threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (arg == "-o" && i + 1 < argc) {
+            outputDir = argv[++i];
+        } else if (arg == "--rate" && i + 1 < argc) {
+            options.sampleRate = std::atoi(argv[++i]);
+        } else {
+            struct stat st;
+            if (stat(arg.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+                std::vector<std::string> found = BitsyBatchLoader::listGameFiles(arg);
+                files.insert(files.end(), found.begin(), found.end());
+            } else {
+                files.push_back(arg);
+            }
+        }
+    }
+
+    if (files.empty() || options.sampleRate <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [-j threads] [-o dir] [--rate hz] <file.bitsy | directory>..."
+                  << std::endl;
+        return 2;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // Load everything, then render all sounds of all games as one batch. Output files are
+    // named <dir>/<game index>_<file name>_tune<id>.wav (or blip<id>) so equal names from
+    // different directories do not collide.
+    std::vector<std::unique_ptr<BitsyGameData>> games(files.size());
+    BitsyBatchLoader loader(threads);
+    size_t failures = loader.load(files, [&](BitsyBatchResult& result) {
+        if (!result.ok) {
+            std::cerr << "FAIL " << result.filePath << ": " << result.error << std::endl;
+            return;
+        }
+        games[result.index].reset(new BitsyGameData(std::move(result.game)));
+    });
+
+    std::vector<BitsyAudioJob> jobs;
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (!games[i]) continue;
+        std::string name = files[i].substr(files[i].find_last_of('/') + 1);
+        std::string prefix = outputDir + "/" + std::to_string(i) + "_" + name.substr(0, name.rfind(".bitsy")) + "_";
+        std::vector<BitsyAudioJob> gameJobs = BitsySynthesizer::audioJobs(*games[i], prefix);
+        jobs.insert(jobs.end(), gameJobs.begin(), gameJobs.end());
+    }
+    size_t writeFailures = BitsySynthesizer::renderBatch(jobs, options, threads);
+    if (writeFailures > 0) std::cerr << writeFailures << " sounds could not be written to " << outputDir << std::endl;
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Rendered " << jobs.size() - writeFailures << " sounds from " << files.size() - failures << "/"
+              << files.size() << " games in " << seconds << " s" << std::endl;
+    return failures == 0 && writeFailures == 0 ? 0 : 1;
+}